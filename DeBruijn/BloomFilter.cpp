@@ -0,0 +1,79 @@
+/**
+ * @file BloomFilter.cpp
+ * @author Anna Catenacci
+ */
+
+#include "BloomFilter.hpp"
+#include <set>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("CountingBloomFilter__membership", "[BloomFilter.hpp]")
+{
+    {
+        CountingBloomFilter filter;
+        CHECK(!filter.enabled());
+        filter.reset(1000, 0.01);
+        CHECK(filter.enabled());
+        CHECK(filter.hash_count() == 7);
+
+        // no false negatives, and about the requested false-positive rate once full
+        for(int i = 0; i < 1000; ++i){
+            filter.insert(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i)));
+        }
+        for(int i = 0; i < 1000; ++i){
+            CHECK(filter.may_contain(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i))));
+        }
+        int let_through = 0;
+        for(int i = 1000; i < 11000; ++i){
+            let_through += filter.may_contain(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i)));
+        }
+        CHECK(let_through < 300);
+        CHECK(filter.estimated_false_positive_rate() < 0.03);
+        CHECK(filter.queries() == 11000);
+        CHECK(filter.rejected() == uint64_t(10000 - let_through));
+
+        // erasing brings the counters back down, and other keys stay in
+        for(int i = 0; i < 500; ++i){
+            filter.erase(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i)));
+        }
+        CHECK(filter.size() == 500);
+        for(int i = 500; i < 1000; ++i){
+            CHECK(filter.may_contain(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i))));
+        }
+        for(int i = 500; i < 1000; ++i){
+            filter.erase(CountingBloomFilter::kmer_hash("kmer" + std::to_string(i)));
+        }
+        CHECK(filter.estimated_false_positive_rate() == 0);
+        CHECK(!filter.may_contain(CountingBloomFilter::kmer_hash("kmer3")));
+
+        // an edge does not hash like its source vertex
+        CHECK(CountingBloomFilter::edge_hash("0110", '1') != CountingBloomFilter::edge_hash("0110", '0'));
+        CHECK(CountingBloomFilter::edge_hash("0110", '1') != CountingBloomFilter::kmer_hash("0110"));
+    }
+}
+
+TEST_CASE("CountingBloomFilter__saturation", "[BloomFilter.hpp]")
+{
+    {
+        // a counter that overflows stays set, so a key inserted often enough is never lost
+        CountingBloomFilter filter;
+        filter.reset(10, 0.01);
+        uint64_t key = CountingBloomFilter::kmer_hash("0000");
+        for(int i = 0; i < 300; ++i){
+            filter.insert(key);
+        }
+        for(int i = 0; i < 300; ++i){
+            filter.erase(key);
+        }
+        CHECK(filter.may_contain(key));
+
+        filter.record_false_positive();
+        CountingBloomFilter copy = filter;
+        CHECK(copy.false_positives() == 1);
+        CHECK(copy.queries() == 1);
+        filter.clear();
+        CHECK(!filter.enabled());
+        CHECK(filter.memory_bytes() == 0);
+    }
+}
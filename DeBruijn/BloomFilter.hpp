@@ -0,0 +1,230 @@
+/**
+ * @file BloomFilter.hpp
+ * @author Anna Catenacci
+ *
+ * A counting Bloom filter over the k-mers and edges of a DeBruijnGraph, used to turn away queries about
+ * genomes that are obviously novel without looking anything up in the vertex store.
+ *
+ * Each slot is an 8-bit counter, so keys can be erased as vertices and edges leave the graph. A counter that
+ * reaches 255 stays there for good (it can no longer be decremented safely), which only ever costs false
+ * positives, never false negatives. The filter counts how often it was asked, how often it said no, and how
+ * often it said "maybe" about something the store then did not have, so its real false-positive rate can be
+ * logged next to the estimate from how full it is.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_BLOOMFILTER_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_BLOOMFILTER_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+
+class CountingBloomFilter {
+private:
+    /// One counter per slot (empty while the filter is off)
+    std::vector<uint8_t> mCounters;
+
+    /// Slots set for each key
+    int mHashes = 0;
+
+    /// Number of keys inserted and not erased
+    size_t mKeys = 0;
+
+    /// Number of non-zero counters
+    size_t mOccupied = 0;
+
+    /// Query counters, updated from const lookups (possibly on several threads)
+    mutable std::atomic<uint64_t> mQueries{0};
+    mutable std::atomic<uint64_t> mRejected{0};
+    mutable std::atomic<uint64_t> mFalsePositives{0};
+
+    static constexpr uint8_t SATURATED = 255;
+
+    /**
+     * splitmix64 finalizer, to spread a hash over all 64 bits
+     */
+    static uint64_t mix(uint64_t x){
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * Call func on the slot of every hash of a key (double hashing from one 64-bit hash)
+     */
+    template <typename FuncType>
+    void for_each_slot(uint64_t hash, FuncType func) const {
+        uint64_t first = mix(hash);
+        uint64_t step = mix(first) | 1;
+        for(int i = 0; i < mHashes; ++i){
+            func(size_t((first + i * step) % mCounters.size()));
+        }
+    }
+
+public:
+    CountingBloomFilter() = default;
+
+    CountingBloomFilter(const CountingBloomFilter & other)
+        : mCounters(other.mCounters), mHashes(other.mHashes), mKeys(other.mKeys), mOccupied(other.mOccupied),
+          mQueries(other.mQueries.load()), mRejected(other.mRejected.load()),
+          mFalsePositives(other.mFalsePositives.load()) { }
+
+    CountingBloomFilter & operator=(const CountingBloomFilter & other){
+        mCounters = other.mCounters;
+        mHashes = other.mHashes;
+        mKeys = other.mKeys;
+        mOccupied = other.mOccupied;
+        mQueries = other.mQueries.load();
+        mRejected = other.mRejected.load();
+        mFalsePositives = other.mFalsePositives.load();
+        return *this;
+    }
+
+    /**
+     * Size the filter for a number of keys and a target false-positive rate, and clear it
+     * @param expected_keys number of keys the filter should hold at that rate
+     * @param false_positive_rate target rate, between 0 and 1
+     */
+    void reset(size_t expected_keys, double false_positive_rate){
+        double keys = std::max<double>(expected_keys, 1);
+        double rate = std::min(std::max(false_positive_rate, 1e-9), 0.5);
+        double slots = std::ceil(-keys * std::log(rate) / (std::log(2.0) * std::log(2.0)));
+        mCounters.assign(size_t(std::max(slots, 64.0)), 0);
+        mHashes = std::max(1, int(std::round(mCounters.size() / keys * std::log(2.0))));
+        mKeys = 0;
+        mOccupied = 0;
+        mQueries = 0;
+        mRejected = 0;
+        mFalsePositives = 0;
+    }
+
+    /**
+     * Turn the filter off and free its counters
+     */
+    void clear(){
+        mCounters.clear();
+        mCounters.shrink_to_fit();
+        mHashes = 0;
+        mKeys = 0;
+        mOccupied = 0;
+    }
+
+    /**
+     * @return true if the filter has been sized with reset
+     */
+    bool enabled() const { return !mCounters.empty(); }
+
+    /**
+     * @param hash 64-bit hash of the key
+     */
+    void insert(uint64_t hash){
+        for_each_slot(hash, [this] (size_t slot) {
+            uint8_t & counter = mCounters[slot];
+            if(counter == 0){
+                mOccupied++;
+            }
+            if(counter != SATURATED){
+                counter++;
+            }
+        });
+        mKeys++;
+    }
+
+    /**
+     * Take out a key that was inserted
+     * @param hash 64-bit hash of the key
+     */
+    void erase(uint64_t hash){
+        for_each_slot(hash, [this] (size_t slot) {
+            uint8_t & counter = mCounters[slot];
+            if(counter != SATURATED && counter > 0){
+                counter--;
+                if(counter == 0){
+                    mOccupied--;
+                }
+            }
+        });
+        mKeys--;
+    }
+
+    /**
+     * @param hash 64-bit hash of the key
+     * @return false if the key is certainly not in the filter
+     */
+    bool may_contain(uint64_t hash) const {
+        bool present = true;
+        for_each_slot(hash, [this, &present] (size_t slot) { present = present && mCounters[slot] != 0; });
+        mQueries.fetch_add(1, std::memory_order_relaxed);
+        if(!present){
+            mRejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        return present;
+    }
+
+    /**
+     * Note that a key the filter let through turned out not to be there
+     */
+    void record_false_positive() const { mFalsePositives.fetch_add(1, std::memory_order_relaxed); }
+
+///@remark HASHES /////////////////////////////////////////////////////////////
+
+    /**
+     * @param kmer vertex
+     * @return hash of the vertex
+     */
+    static uint64_t kmer_hash(std::string_view kmer){ return std::hash<std::string_view>{}(kmer); }
+
+    /**
+     * An edge is its source k-mer plus the character it appends
+     * @param from source vertex
+     * @param last last character of the vertex it leads to
+     * @return hash of the edge (different from the hash of any vertex)
+     */
+    static uint64_t edge_hash(std::string_view from, char last){
+        return mix(kmer_hash(from) ^ (uint64_t(uint8_t(last)) + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+///@remark MEASUREMENT /////////////////////////////////////////////////////////////
+
+    /**
+     * @return false-positive rate expected from how full the filter is
+     */
+    double estimated_false_positive_rate() const {
+        return enabled() ? std::pow(double(mOccupied) / mCounters.size(), mHashes) : 0;
+    }
+
+    /**
+     * @return share of absent keys the filter let through, among those it was asked about
+     */
+    double measured_false_positive_rate() const {
+        uint64_t false_positives = mFalsePositives, rejected = mRejected;
+        return false_positives + rejected == 0 ? 0 : double(false_positives) / (false_positives + rejected);
+    }
+
+    uint64_t queries() const { return mQueries; }
+    uint64_t rejected() const { return mRejected; }
+    uint64_t false_positives() const { return mFalsePositives; }
+
+    /**
+     * @return number of keys held
+     */
+    size_t size() const { return mKeys; }
+
+    /**
+     * @return number of slots set for each key
+     */
+    int hash_count() const { return mHashes; }
+
+    /**
+     * @return bytes used by the counters
+     */
+    size_t memory_bytes() const { return mCounters.capacity(); }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_BLOOMFILTER_H
@@ -0,0 +1,93 @@
+/**
+ * @file ColorSet.cpp
+ * @author Anna Catenacci
+ */
+
+#include "ColorSet.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <set>
+#include <limits>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    using color_t = ColorSet::color_t;
+
+    std::vector<color_t> as_vector(const std::set<color_t> & colors){
+        return std::vector<color_t>(colors.begin(), colors.end());
+    }
+}
+
+TEST_CASE("ColorSet__runs", "[ColorSet.hpp]")
+{
+    {
+        ColorSet colors;
+        CHECK(colors.empty());
+        CHECK(colors.insert(5));
+        CHECK(colors.insert(7));
+        CHECK(colors.run_count() == 2);
+        CHECK(colors.insert(6));        // joins both neighbours into one run
+        CHECK(colors.run_count() == 1);
+        CHECK(!colors.insert(6));
+        CHECK(colors.size() == 3);
+        CHECK(colors.contains(5));
+        CHECK(!colors.contains(4));
+        CHECK(!colors.contains(8));
+
+        CHECK(colors.erase(6));         // splits the run
+        CHECK(colors.run_count() == 2);
+        CHECK(!colors.erase(6));
+        CHECK(colors.to_vector() == std::vector<color_t>{5, 7});
+
+        // a long run of consecutive ids is one run
+        ColorSet generation;
+        for(color_t id = 1000; id < 101000; ++id){
+            generation.insert(id);
+        }
+        CHECK(generation.run_count() == 1);
+        CHECK(generation.size() == 100000);
+
+        // the ends of the id range
+        ColorSet ends{0, std::numeric_limits<color_t>::max(), std::numeric_limits<color_t>::max() - 1};
+        CHECK(ends.run_count() == 2);
+        CHECK(ends.contains(std::numeric_limits<color_t>::max()));
+        CHECK(ends.erase(0));
+        CHECK(ends.size() == 2);
+    }
+}
+
+TEST_CASE("ColorSet__matches-std-set", "[ColorSet.hpp]")
+{
+    {
+        emp::Random random(8);
+        for(int trial = 0; trial < 50; ++trial){
+            ColorSet a, b;
+            std::set<color_t> reference_a, reference_b;
+            for(int i = 0; i < 300; ++i){
+                color_t color = random.GetUInt(200);
+                bool remove = random.P(0.3);
+                ColorSet & set = i % 2 ? a : b;
+                std::set<color_t> & reference = i % 2 ? reference_a : reference_b;
+                if(remove){
+                    CHECK(set.erase(color) == (reference.erase(color) > 0));
+                }
+                else {
+                    CHECK(set.insert(color) == reference.insert(color).second);
+                }
+            }
+            CHECK(a.to_vector() == as_vector(reference_a));
+            CHECK(a.size() == reference_a.size());
+
+            std::set<color_t> either = reference_a, both, only_a;
+            either.insert(reference_b.begin(), reference_b.end());
+            for(color_t color : reference_a){
+                (reference_b.count(color) ? both : only_a).insert(color);
+            }
+            CHECK((a | b).to_vector() == as_vector(either));
+            CHECK((a & b).to_vector() == as_vector(both));
+            CHECK((a - b).to_vector() == as_vector(only_a));
+            CHECK((a | b) == (b | a));
+            CHECK((a - a).empty());
+        }
+    }
+}
@@ -0,0 +1,254 @@
+/**
+ * @file ColorSet.hpp
+ * @author Anna Catenacci
+ *
+ * A set of organism (or lineage) ids stored as sorted runs of consecutive ids.
+ *
+ * MABE hands out organism ids in order of birth, so the organisms sharing a k-mer are mostly relatives born
+ * close together, and their ids fall into a few long runs. A set of a million ids in one run takes eight bytes.
+ * Membership is a binary search over the runs; union, intersection and difference walk both sets' runs once.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLORSET_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLORSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <initializer_list>
+
+class ColorSet {
+public:
+    using color_t = uint32_t;
+
+private:
+    /// Ids first through last, inclusive
+    struct Run {
+        color_t first;
+        color_t last;
+        bool operator==(const Run & other) const { return first == other.first && last == other.last; }
+    };
+
+    /// Disjoint, non-adjacent runs in increasing order
+    std::vector<Run> mRuns;
+
+    /**
+     * @param color id
+     * @return index of the first run that starts after the id
+     */
+    size_t run_after(color_t color) const {
+        return std::upper_bound(mRuns.begin(), mRuns.end(), color,
+                                [] (color_t c, const Run & run) { return c < run.first; }) - mRuns.begin();
+    }
+
+    /**
+     * Append a run to the end of the set, joining it to the last run if they touch or overlap
+     * (runs must be appended in order of their first id)
+     */
+    void append(color_t first, color_t last){
+        if(!mRuns.empty() && uint64_t(mRuns.back().last) + 1 >= first){
+            mRuns.back().last = std::max(mRuns.back().last, last);
+        }
+        else {
+            mRuns.push_back({first, last});
+        }
+    }
+
+public:
+    ColorSet() = default;
+
+    /**
+     * @param colors ids in the set, in any order
+     */
+    ColorSet(std::initializer_list<color_t> colors){
+        for(color_t color : colors){
+            insert(color);
+        }
+    }
+
+    /**
+     * @param color id to add
+     * @return true if it was not in the set already
+     */
+    bool insert(color_t color){
+        size_t after = run_after(color);
+        bool joins_previous = after > 0 && uint64_t(mRuns[after - 1].last) + 1 >= color;
+        if(joins_previous && mRuns[after - 1].last >= color){
+            return false;
+        }
+        bool joins_next = after < mRuns.size() && mRuns[after].first == color + 1;
+        if(joins_previous && joins_next){
+            mRuns[after - 1].last = mRuns[after].last;
+            mRuns.erase(mRuns.begin() + after);
+        }
+        else if(joins_previous){
+            mRuns[after - 1].last = color;
+        }
+        else if(joins_next){
+            mRuns[after].first = color;
+        }
+        else {
+            mRuns.insert(mRuns.begin() + after, Run{color, color});
+        }
+        return true;
+    }
+
+    /**
+     * @param color id to take out
+     * @return true if it was in the set
+     */
+    bool erase(color_t color){
+        size_t after = run_after(color);
+        if(after == 0 || mRuns[after - 1].last < color){
+            return false;
+        }
+        Run & run = mRuns[after - 1];
+        if(run.first == run.last){
+            mRuns.erase(mRuns.begin() + (after - 1));
+        }
+        else if(run.first == color){
+            run.first++;
+        }
+        else if(run.last == color){
+            run.last--;
+        }
+        else {
+            Run upper{color + 1, run.last};
+            run.last = color - 1;
+            mRuns.insert(mRuns.begin() + after, upper);
+        }
+        return true;
+    }
+
+    /**
+     * @param color id
+     * @return true if the id is in the set
+     */
+    bool contains(color_t color) const {
+        size_t after = run_after(color);
+        return after > 0 && mRuns[after - 1].last >= color;
+    }
+
+    /**
+     * @return number of ids in the set
+     */
+    size_t size() const {
+        size_t count = 0;
+        for(auto const & run : mRuns){
+            count += size_t(run.last - run.first) + 1;
+        }
+        return count;
+    }
+
+    /**
+     * @return true if the set has no ids
+     */
+    bool empty() const { return mRuns.empty(); }
+
+    /**
+     * @return number of runs the ids are stored as
+     */
+    size_t run_count() const { return mRuns.size(); }
+
+    /**
+     * @return bytes the set takes, including its heap buffer
+     */
+    size_t memory_bytes() const { return sizeof(ColorSet) + mRuns.capacity() * sizeof(Run); }
+
+    /**
+     * Call func on every id, in increasing order
+     * @param func lambda taking a color_t
+     */
+    template <typename FuncType>
+    void for_each(FuncType func) const {
+        for(auto const & run : mRuns){
+            for(uint64_t color = run.first; color <= run.last; ++color){
+                func(color_t(color));
+            }
+        }
+    }
+
+    /**
+     * @return every id, in increasing order
+     */
+    std::vector<color_t> to_vector() const {
+        std::vector<color_t> colors;
+        colors.reserve(size());
+        for_each([&colors] (color_t color) { colors.push_back(color); });
+        return colors;
+    }
+
+///@remark SET OPERATIONS /////////////////////////////////////////////////////////////
+
+    /**
+     * @return ids in either set
+     */
+    static ColorSet set_union(const ColorSet & a, const ColorSet & b){
+        ColorSet result;
+        size_t i = 0, j = 0;
+        while(i < a.mRuns.size() || j < b.mRuns.size()){
+            bool take_a = j == b.mRuns.size() || (i < a.mRuns.size() && a.mRuns[i].first <= b.mRuns[j].first);
+            const Run & run = take_a ? a.mRuns[i++] : b.mRuns[j++];
+            result.append(run.first, run.last);
+        }
+        return result;
+    }
+
+    /**
+     * @return ids in both sets
+     */
+    static ColorSet set_intersection(const ColorSet & a, const ColorSet & b){
+        ColorSet result;
+        size_t i = 0, j = 0;
+        while(i < a.mRuns.size() && j < b.mRuns.size()){
+            color_t first = std::max(a.mRuns[i].first, b.mRuns[j].first);
+            color_t last = std::min(a.mRuns[i].last, b.mRuns[j].last);
+            if(first <= last){
+                result.append(first, last);
+            }
+            // move past whichever run ends first
+            if(a.mRuns[i].last < b.mRuns[j].last){
+                ++i;
+            }
+            else {
+                ++j;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @return ids in a but not in b
+     */
+    static ColorSet set_difference(const ColorSet & a, const ColorSet & b){
+        ColorSet result;
+        size_t j = 0;
+        for(auto const & run : a.mRuns){
+            uint64_t first = run.first;
+            while(j < b.mRuns.size() && b.mRuns[j].last < first){
+                ++j;
+            }
+            // cut out every run of b that overlaps this run
+            for(size_t k = j; k < b.mRuns.size() && b.mRuns[k].first <= run.last && first <= run.last; ++k){
+                if(b.mRuns[k].first > first){
+                    result.append(color_t(first), b.mRuns[k].first - 1);
+                }
+                first = uint64_t(b.mRuns[k].last) + 1;
+            }
+            if(first <= run.last){
+                result.append(color_t(first), run.last);
+            }
+        }
+        return result;
+    }
+
+    ColorSet operator|(const ColorSet & other) const { return set_union(*this, other); }
+    ColorSet operator&(const ColorSet & other) const { return set_intersection(*this, other); }
+    ColorSet operator-(const ColorSet & other) const { return set_difference(*this, other); }
+
+    bool operator==(const ColorSet & other) const { return mRuns == other.mRuns; }
+    bool operator!=(const ColorSet & other) const { return !(*this == other); }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLORSET_H
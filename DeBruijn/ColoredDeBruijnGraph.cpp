@@ -0,0 +1,102 @@
+/**
+ * @file ColoredDeBruijnGraph.cpp
+ * @author Anna Catenacci
+ */
+
+#include "ColoredDeBruijnGraph.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("ColoredDeBruijnGraph__membership", "[ColoredDeBruijnGraph.hpp]")
+{
+    {
+        ColoredDeBruijnGraph g;
+        g.add_sequence("0110100", 1);
+        g.add_sequence("0110111", 2);
+        g.add_sequence("1110100", 3);
+        CHECK(g.graph().get_sequence_size() == 3);
+        CHECK(g.colors("011").to_vector() == vector<ColorSet::color_t>{1, 2});
+        CHECK(g.colors("100").to_vector() == vector<ColorSet::color_t>{1, 3});
+        CHECK(g.colors("111").to_vector() == vector<ColorSet::color_t>{2, 3});
+        CHECK(g.colors("000").empty());
+
+        // edges know who took them
+        CHECK(g.edge_colors("101", "010").to_vector() == vector<ColorSet::color_t>{1, 3});
+        CHECK(g.edge_colors("101", "011").to_vector() == vector<ColorSet::color_t>{2});
+        CHECK(g.edge_colors("101", "111").empty());   // not an edge of the graph at all
+
+        // queries across vertices
+        CHECK(g.shared_colors({"011", "111"}).to_vector() == vector<ColorSet::color_t>{2});
+        CHECK(g.path_colors("110100").to_vector() == vector<ColorSet::color_t>{1, 3});
+        CHECK(g.path_colors("0110100").to_vector() == vector<ColorSet::color_t>{1});
+        ColorSet lineage{2, 3};
+        CHECK((g.colors("110") & lineage) == lineage);
+
+        CHECK_THROWS_AS(g.add_sequence("000", 2), std::invalid_argument);
+
+        // removing a genome takes its color off everything it used
+        CHECK(!g.remove_sequence("0110100", 2));   // not the genome added as 2
+        CHECK(g.remove_sequence("0110100", 1));
+        CHECK(!g.remove_sequence("0110100", 1));
+        CHECK(g.colors("011").to_vector() == vector<ColorSet::color_t>{2});
+        CHECK(g.edge_colors("101", "010").to_vector() == vector<ColorSet::color_t>{3});
+        CHECK(g.live_colors().to_vector() == vector<ColorSet::color_t>{2, 3});
+        CHECK(g.remove_sequence("0110111", 2));
+        CHECK(g.colors("011").empty());
+        CHECK(!g.graph().get_value("011").get_kmer_occurrences());
+
+        // only the whole genome removes its color, not a stretch of it
+        ColoredDeBruijnGraph part;
+        part.add_sequence("00110101", 1);
+        CHECK(!part.remove_sequence("00110", 1));
+        CHECK(!part.remove_sequence("0011010", 1));
+        CHECK(part.live_colors().to_vector() == vector<ColorSet::color_t>{1});
+        CHECK(part.graph().get_sequence_size() == 1);
+        CHECK(part.colors("101").to_vector() == vector<ColorSet::color_t>{1});
+        CHECK(part.colors("001").to_vector() == vector<ColorSet::color_t>{1});
+        CHECK(part.remove_sequence("00110101", 1));
+        CHECK(part.live_colors().empty());
+        CHECK(part.graph().get_size() == 0);
+    }
+}
+
+TEST_CASE("ColoredDeBruijnGraph__matches-genome-archive", "[ColoredDeBruijnGraph.hpp]")
+{
+    {
+        // a population turning over, checked against keeping every genome string
+        emp::Random random(12);
+        ColoredDeBruijnGraph g(4);
+        map<ColorSet::color_t, string> archive;
+        ColorSet::color_t next_id = 0;
+        for(int step = 0; step < 400; ++step){
+            if(archive.size() < 20 || random.P(0.5)){
+                string genome;
+                for(int j = 0; j < 30; ++j){
+                    genome += random.P(0.5) ? '1' : '0';
+                }
+                g.add_sequence(genome, next_id);
+                archive[next_id++] = genome;
+            }
+            else {
+                auto it = std::next(archive.begin(), random.GetUInt(archive.size()));
+                CHECK(g.remove_sequence(it->second, it->first));
+                archive.erase(it);
+            }
+        }
+        CHECK(g.graph().get_sequence_size() == int(archive.size()));
+        for(auto const & kmer : g.graph().get_all_vertices()){
+            vector<ColorSet::color_t> users;
+            for(auto const & organism : archive){
+                if(organism.second.find(kmer) != string::npos){
+                    users.push_back(organism.first);
+                }
+            }
+            CHECK(g.colors(kmer).to_vector() == users);
+            CHECK(int(users.size()) <= g.graph().get_value(kmer).get_kmer_occurrences());
+        }
+        // the colors are accounted for apart from the graph
+        CHECK(g.color_memory_bytes() > 0);
+        CHECK(g.live_colors().size() == archive.size());
+    }
+}
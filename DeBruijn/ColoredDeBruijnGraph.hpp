@@ -0,0 +1,260 @@
+/**
+ * @file ColoredDeBruijnGraph.hpp
+ * @author Anna Catenacci
+ *
+ * A DeBruijnGraph that also knows which organisms use each k-mer and each edge, so lineage and ancestry
+ * questions ("which organisms share this k-mer?", "who carries this whole stretch?") can be answered from the
+ * pangenome without keeping every genome string in a separate archive.
+ *
+ * Each genome is added with a color, normally its organism id, which must not belong to another live genome.
+ * Every k-mer and edge keeps the colors of the genomes that use it in a run-length ColorSet, and both are
+ * updated as genomes are added and removed. Lineages are sets of colors too, so lineage questions are set
+ * operations, e.g. colors("0110") & lineage.
+ *
+ * Typical use in a MABE run:
+ *     string child = colored.graph().sample_path(random, parent);
+ *     colored.add_sequence(child, child_id);          // OnOffspringReady
+ *     colored.remove_sequence(dead_genome, dead_id);  // BeforeDeath
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLOREDDEBRUIJNGRAPH_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLOREDDEBRUIJNGRAPH_H
+
+#include "DeBruijnGraph.hpp"
+#include "ColorSet.hpp"
+#include "GenomeFingerprint.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <stdexcept>
+
+class ColoredDeBruijnGraph {
+public:
+    using color_t = ColorSet::color_t;
+
+private:
+    /// Colors of one k-mer and of the edges leaving it
+    struct VertexColors {
+        /// Genomes that use the k-mer
+        ColorSet kmer;
+        /// Genomes that use each edge out of the k-mer, by the last character of the k-mer it leads to
+        vector<std::pair<char, ColorSet>> edges;
+    };
+
+    /// Graph of every live genome
+    DeBruijnGraph mGraph;
+
+    /// Colors of every k-mer
+    map<string, VertexColors> mColors;
+
+    /// Colors of every live genome
+    ColorSet mLive;
+
+    /// Fingerprint of the genome added under each live color, so only that whole genome can remove it
+    std::unordered_map<color_t, GenomeFingerprint> mFingerprints;
+
+    /// Returned for k-mers and edges no genome uses
+    static const ColorSet & no_colors(){
+        static const ColorSet empty;
+        return empty;
+    }
+
+    /**
+     * @param vertex colors of a k-mer
+     * @param last last character of the k-mer the edge leads to
+     * @return colors of the edge, or nullptr if it has none
+     */
+    template <typename VertexT>
+    static auto find_edge(VertexT & vertex, char last) -> decltype(&vertex.edges.front().second) {
+        for(auto & edge : vertex.edges){
+            if(edge.first == last){
+                return &edge.second;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Call func on every k-mer of a sequence, along with the k-mer after it (empty for the last one)
+     * @param sequence to walk
+     * @param func lambda taking (const string & kmer, const string & next)
+     */
+    template <typename FuncType>
+    void for_each_step(const string & sequence, FuncType func) const {
+        size_t kmer_length = mGraph.get_kmer_len();
+        size_t count = sequence.size() > kmer_length ? sequence.size() - kmer_length + 1 : 1;
+        string current = sequence.substr(0, kmer_length), next;
+        for(size_t i = 1; i <= count; ++i){
+            if(i < count){
+                next.assign(sequence, i, kmer_length);
+            }
+            else {
+                next.clear();
+            }
+            func(current, next);
+            current.swap(next);
+        }
+    }
+
+public:
+    /**
+     * @param kmer_length length of each vertex ID
+     */
+    ColoredDeBruijnGraph(int kmer_length = 3) : mGraph(kmer_length) { }
+
+    /**
+     * Add a genome to the graph under a color
+     * @param sequence genome to add
+     * @param color id of the genome (e.g. its organism id); must not be the color of another live genome
+     */
+    void add_sequence(const string & sequence, color_t color){
+        if(mLive.contains(color)){
+            throw std::invalid_argument("ColoredDeBruijnGraph::add_sequence: color " + std::to_string(color)
+                                        + " already belongs to a genome in the graph");
+        }
+        mGraph.add_sequence(sequence);
+        mLive.insert(color);
+        mFingerprints[color] = FingerprintBuilder::of(sequence);
+        for_each_step(sequence, [this, color] (const string & kmer, const string & next) {
+            VertexColors & vertex = mColors[kmer];
+            vertex.kmer.insert(color);
+            if(!next.empty()){
+                ColorSet * edge = find_edge(vertex, next.back());
+                if(!edge){
+                    vertex.edges.emplace_back(next.back(), ColorSet());
+                    edge = &vertex.edges.back().second;
+                }
+                edge->insert(color);
+            }
+        });
+    }
+
+    /**
+     * Remove a genome from the graph, along with its color
+     * @param sequence genome that was added under the color
+     * @param color id the genome was added under
+     * @return true if the genome was removed (false if the sequence is not the genome added under the color)
+     */
+    bool remove_sequence(const string & sequence, color_t color){
+        auto added = mFingerprints.find(color);
+        if(added == mFingerprints.end() || added->second != FingerprintBuilder::of(sequence)){
+            return false;
+        }
+        mGraph.remove_sequence(sequence);
+        mLive.erase(color);
+        mFingerprints.erase(added);
+        for_each_step(sequence, [this, color] (const string & kmer, const string & next) {
+            auto it = mColors.find(kmer);
+            if(it == mColors.end()){
+                return;
+            }
+            VertexColors & vertex = it->second;
+            vertex.kmer.erase(color);
+            if(!next.empty()){
+                ColorSet * edge = find_edge(vertex, next.back());
+                if(edge && edge->erase(color) && edge->empty()){
+                    vertex.edges.erase(std::remove_if(vertex.edges.begin(), vertex.edges.end(),
+                                                      [] (const std::pair<char, ColorSet> & e) { return e.second.empty(); }),
+                                       vertex.edges.end());
+                }
+            }
+            if(vertex.kmer.empty()){
+                mColors.erase(it);
+            }
+        });
+        return true;
+    }
+
+///@remark QUERIES /////////////////////////////////////////////////////////////
+
+    /**
+     * @param kmer vertex
+     * @return colors of the genomes that use the k-mer
+     */
+    const ColorSet & colors(const string & kmer) const {
+        auto it = mColors.find(kmer);
+        return it == mColors.end() ? no_colors() : it->second.kmer;
+    }
+
+    /**
+     * @param from vertex the edge starts at
+     * @param to vertex the edge leads to
+     * @return colors of the genomes that go from one k-mer straight to the other
+     */
+    const ColorSet & edge_colors(const string & from, const string & to) const {
+        auto it = mColors.find(from);
+        if(it == mColors.end() || to.empty() || from.compare(1, string::npos, to, 0, to.size() - 1) != 0){
+            return no_colors();
+        }
+        const ColorSet * edge = find_edge(it->second, to.back());
+        return edge ? *edge : no_colors();
+    }
+
+    /**
+     * @param kmers vertices
+     * @return colors of the genomes that use every one of the k-mers
+     */
+    ColorSet shared_colors(const vector<string> & kmers) const {
+        if(kmers.empty()){
+            return mLive;
+        }
+        ColorSet shared = colors(kmers[0]);
+        for(size_t i = 1; i < kmers.size() && !shared.empty(); ++i){
+            shared = shared & colors(kmers[i]);
+        }
+        return shared;
+    }
+
+    /**
+     * Colors of the genomes that take every step of a sequence: every k-mer of it, and every edge between
+     * consecutive k-mers. Every genome that contains the sequence is among them.
+     * @param sequence stretch of genome
+     * @return colors of the genomes that go through all of it
+     */
+    ColorSet path_colors(const string & sequence) const {
+        ColorSet shared = mLive;
+        for_each_step(sequence, [&] (const string & kmer, const string & next) {
+            if(shared.empty()){
+                return;
+            }
+            shared = shared & (next.empty() ? colors(kmer) : edge_colors(kmer, next));
+        });
+        return shared;
+    }
+
+    /**
+     * @return colors of every genome in the graph
+     */
+    const ColorSet & live_colors() const { return mLive; }
+
+    /**
+     * @return the uncolored graph, for sampling, traversal and everything else that does not change it
+     */
+    const DeBruijnGraph & graph() const { return mGraph; }
+
+    /**
+     * @return bytes taken by the colors (k-mer keys, k-mer and edge color sets, genome fingerprints), on top of
+     *         graph().memory_usage()
+     */
+    size_t color_memory_bytes() const {
+        size_t bytes = mLive.memory_bytes() + mFingerprints.bucket_count() * sizeof(void *)
+                       + mFingerprints.size() * (sizeof(std::pair<const color_t, GenomeFingerprint>) + 2 * sizeof(void *));
+        for(auto const & vertex : mColors){
+            // a map node holds the key and value plus three pointers and a color; long keys have a heap buffer too
+            const char * key = reinterpret_cast<const char *>(&vertex.first);
+            bool inline_key = vertex.first.data() >= key && vertex.first.data() < key + sizeof(string);
+            bytes += sizeof(vertex) + 4 * sizeof(void *) + (inline_key ? 0 : vertex.first.capacity() + 1)
+                     + vertex.second.kmer.memory_bytes()
+                     - sizeof(ColorSet) + vertex.second.edges.capacity() * sizeof(std::pair<char, ColorSet>);
+            for(auto const & edge : vertex.second.edges){
+                bytes += edge.second.memory_bytes() - sizeof(ColorSet);
+            }
+        }
+        return bytes;
+    }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COLOREDDEBRUIJNGRAPH_H
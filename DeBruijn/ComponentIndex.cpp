@@ -0,0 +1,158 @@
+/**
+ * @file ComponentIndex.cpp
+ * @author Anna Catenacci
+ */
+
+#include "DeBruijnGraph.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <set>
+#include <deque>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Every vertex reachable from a vertex (including itself)
+    std::set<string> reachable(const DeBruijnGraph & g, const string & from){
+        std::set<string> seen{from};
+        std::deque<string> frontier{from};
+        while(!frontier.empty()){
+            string current = frontier.front();
+            frontier.pop_front();
+            for(auto const & next : g.get_value(current).get_adj_list()){
+                if(seen.insert(next).second){
+                    frontier.push_back(next);
+                }
+            }
+        }
+        return seen;
+    }
+
+    /// Check an index against mutual reachability, computed the slow way
+    void check_against_reachability(const DeBruijnGraph & g){
+        auto index = g.components();
+        vector<string> vertices = g.get_all_vertices();
+        std::map<string, std::set<string>> reach;
+        for(auto const & vertex : vertices){
+            reach[vertex] = reachable(g, vertex);
+        }
+        for(auto const & a : vertices){
+            for(auto const & b : vertices){
+                bool same = reach[a].count(b) && reach[b].count(a);
+                CHECK((index->component_of(a) == index->component_of(b)) == same);
+            }
+            uint32_t component = index->component_of(a);
+            bool self_loop = g.get_value(a).valid_adj(a);
+            CHECK(index->is_cyclic(component) == (index->component_size(component) > 1 || self_loop));
+            for(auto const & next : g.get_value(a).get_adj_list()){
+                uint32_t to = index->component_of(next);
+                CHECK(to >= component);     // topological numbering
+                if(to != component){
+                    bool listed = false;
+                    index->for_each_successor(component, [&] (uint32_t c) { listed = listed || c == to; });
+                    CHECK(listed);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ComponentIndex__components", "[ComponentIndex.hpp]")
+{
+    {
+        // a de Bruijn cycle of every 3-mer is one component
+        DeBruijnGraph cycle;
+        cycle.add_sequence("00010111000");
+        auto index = cycle.components();
+        CHECK(index->vertex_count() == 8);
+        CHECK(index->component_count() == 1);
+        CHECK(index->largest_component_size() == 8);
+        CHECK(index->is_cyclic(0));
+        CHECK(index->cyclic_vertex_count() == 8);
+        CHECK(index->condensation_edge_count() == 0);
+        check_against_reachability(cycle);
+
+        // a path has one component per vertex, in path order
+        DeBruijnGraph path;
+        path.add_sequence("12345678");
+        index = path.components();
+        CHECK(index->component_count() == 6);
+        CHECK(index->cyclic_vertex_count() == 0);
+        CHECK(index->component_of("123") == 0);
+        CHECK(index->component_of("678") == 5);
+        CHECK(index->component_of("999") == ComponentIndex::NOT_FOUND);
+        CHECK(index->condensation_edge_count() == 5);
+        CHECK(index->out_degree(0) == 1);
+        vector<uint32_t> members;
+        index->for_each_member(2, [&] (uint32_t id) { members.push_back(id); });
+        CHECK(members.size() == 1);
+        CHECK(index->kmer(members[0]) == "345");
+
+        // a self-loop makes a single vertex cyclic
+        DeBruijnGraph loop;
+        loop.add_sequence("100001");
+        index = loop.components();
+        CHECK(index->is_cyclic(index->component_of("000")));
+        CHECK(!index->is_cyclic(index->component_of("100")));
+        check_against_reachability(loop);
+
+        // random binary populations with small k
+        emp::Random random(49);
+        for(int trial = 0; trial < 5; ++trial){
+            DeBruijnGraph g(4);
+            for(int i = 0; i < 6; ++i){
+                string genome;
+                for(int j = 0; j < 20; ++j){
+                    genome += random.P(0.5) ? '1' : '0';
+                }
+                g.add_sequence(genome);
+            }
+            check_against_reachability(g);
+        }
+    }
+}
+
+TEST_CASE("ComponentIndex__cached-by-version", "[ComponentIndex.hpp]")
+{
+    {
+        emp::Random random(50);
+        DeBruijnGraph g(14);
+        vector<string> genomes;
+        for(int i = 0; i < 200; ++i){
+            string genome;
+            for(int j = 0; j < 300; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            genomes.push_back(genome);
+            g.add_sequence(genome);
+        }
+        auto index = g.components();
+        CHECK(index->vertex_count() == size_t(g.get_size()));
+        vector<size_t> sizes = index->component_sizes();
+        size_t total = 0;
+        for(size_t size : sizes){
+            total += size;
+        }
+        CHECK(total == index->vertex_count());
+        CHECK(index->memory_bytes() > 0);
+
+        // asking again without a change gives the same index; any change makes a new one
+        CHECK(g.components() == index);
+        uint64_t version = g.version();
+        g.is_valid(genomes[0]);
+        CHECK(g.version() == version);
+        g.remove_sequence(genomes[0]);
+        CHECK(g.version() != version);
+        auto rebuilt = g.components();
+        CHECK(rebuilt != index);
+        CHECK(rebuilt->version() == g.version());
+        CHECK(rebuilt->vertex_count() == size_t(g.get_size()));
+        CHECK(index->vertex_count() > rebuilt->vertex_count());    // the old index is untouched
+
+        // a copy shares the index until one of them changes
+        DeBruijnGraph copy = g;
+        CHECK(copy.components() == rebuilt);
+        copy.add_sequence(genomes[0]);
+        CHECK(copy.components() != rebuilt);
+        CHECK(g.components() == rebuilt);
+    }
+}
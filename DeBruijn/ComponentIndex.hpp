@@ -0,0 +1,519 @@
+/**
+ * @file ComponentIndex.hpp
+ * @author Anna Catenacci
+ *
+ * Strongly connected components of a DeBruijnGraph, to measure its cycle structure (and so how much room
+ * crossover has to recombine genomes) generation by generation.
+ *
+ * The index numbers the vertices 0..n-1 in store order, copies the edges into a compressed adjacency array
+ * (resolving their targets through a flat hash table of ids rather than the vertex store), peels off every
+ * vertex no cycle leads into (sources first, as in Kahn's algorithm; in an evolving population that is most
+ * of the graph), and runs Tarjan's algorithm with an explicit stack on what is left, so deep graphs cannot
+ * overflow the call stack. Every step is linear in the size of the graph. Components are numbered in
+ * topological order of the condensation (every edge between two components goes from the lower id to the
+ * higher one), and the condensation DAG is kept as a compressed adjacency array as well.
+ *
+ * An index is a snapshot: it records the graph's version() and does not change. DeBruijnGraph::components()
+ * keeps the last one and only rebuilds it once the graph has changed, so asking every generation costs one
+ * rebuild per generation at most.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COMPONENTINDEX_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COMPONENTINDEX_H
+
+#include "DeBruijnValue.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+class ComponentIndex {
+public:
+    /// Returned for k-mers that are not in the graph
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+private:
+    /// Graph version the index was built from
+    uint64_t mVersion = 0;
+
+    /// K-mers of every vertex, back to back; vertex v's is mKmers[mKmerOffsets[v] .. mKmerOffsets[v + 1])
+    string mKmers;
+    vector<uint64_t> mKmerOffsets{0};
+
+    /// Open-addressing table, its size a power of two: every slot is a vertex id in the low 32 bits (NOT_FOUND
+    /// when the slot is empty) under the top 32 bits of its k-mer's hash, so most mismatches skip the k-mer compare
+    vector<uint64_t> mSlots;
+
+    /// Successors of vertex v are mTargets[mOffsets[v] .. mOffsets[v + 1])
+    vector<uint64_t> mOffsets;
+    vector<uint32_t> mTargets;
+
+    /// Component of every vertex
+    vector<uint32_t> mComponent;
+
+    /// Vertices of component c are mMembers[mMemberOffsets[c] .. mMemberOffsets[c + 1])
+    vector<uint32_t> mMemberOffsets;
+    vector<uint32_t> mMembers;
+
+    /// Components reachable in one step from component c are mDagTargets[mDagOffsets[c] .. mDagOffsets[c + 1])
+    vector<uint64_t> mDagOffsets;
+    vector<uint32_t> mDagTargets;
+
+    /// Components with a cycle (more than one vertex, or a vertex with an edge to itself)
+    vector<char> mCyclic;
+
+    /// Lookups that are prefetched ahead of the one being made
+    static constexpr size_t PREFETCH_DISTANCE = 16;
+
+    /**
+     * Hash of a k-mer, eight characters at a time and finished with the splitmix64 mixer (cheaper than
+     * std::hash, which takes a sizeable share of the build on short keys)
+     */
+    static uint64_t hash(std::string_view kmer){
+        const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+        uint64_t h = kmer.size() * multiplier;
+        size_t i = 0;
+        for(; i + 8 <= kmer.size(); i += 8){
+            uint64_t word;
+            std::memcpy(&word, kmer.data() + i, 8);
+            h = (h ^ word) * multiplier;
+            h ^= h >> 32;
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, kmer.data() + i, kmer.size() - i);
+        h = (h ^ tail) * multiplier;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        return h ^ (h >> 31);
+    }
+
+    static uint32_t slot_id(uint64_t slot){ return uint32_t(slot); }
+
+    /**
+     * @param kmer k-mer to look for
+     * @param kmer_hash hash(kmer)
+     * @return the table slot holding its id, or the empty slot where it would go
+     */
+    size_t probe(std::string_view kmer, uint64_t kmer_hash) const {
+        size_t mask = mSlots.size() - 1;
+        uint64_t tag = kmer_hash >> 32 << 32;
+        for(size_t slot = kmer_hash & mask; ; slot = (slot + 1) & mask){
+            uint64_t entry = mSlots[slot];
+            if(slot_id(entry) == NOT_FOUND || (entry >> 32 << 32 == tag && kmer_view(slot_id(entry)) == kmer)){
+                return slot;
+            }
+        }
+    }
+
+    std::string_view kmer_view(uint32_t id) const {
+        return std::string_view(mKmers.data() + mKmerOffsets[id], mKmerOffsets[id + 1] - mKmerOffsets[id]);
+    }
+
+    /**
+     * Fill mComponent with component ids in topological order
+     * @return number of components
+     */
+    uint32_t find_components(){
+        const uint32_t vertex_count = uint32_t(mComponent.size());
+        // a vertex's index is DONE once its component is closed, which also means it is off the stack
+        const uint32_t UNVISITED = NOT_FOUND, DONE = NOT_FOUND - 1;
+        struct Link { uint32_t index, low; };
+        vector<Link> links(vertex_count, Link{UNVISITED, UNVISITED});
+
+        // peel off the vertices no cycle leads into, sources first: each is a component of its own, and
+        // nothing left has an edge into one, so they take the first ids in the order they are peeled. The
+        // queue holds many independent walks, so its lookups can be prefetched (a depth-first search can't).
+        vector<uint32_t> in_degree(vertex_count, 0);
+        for(uint32_t target : mTargets){
+            in_degree[target]++;
+        }
+        vector<uint32_t> peeled;
+        peeled.reserve(vertex_count);
+        for(uint32_t v = 0; v < vertex_count; ++v){
+            if(in_degree[v] == 0){
+                peeled.push_back(v);
+            }
+        }
+        for(size_t head = 0; head < peeled.size(); ++head){
+            if(head + PREFETCH_DISTANCE < peeled.size()){
+                __builtin_prefetch(&mOffsets[peeled[head + PREFETCH_DISTANCE]]);
+            }
+            uint32_t v = peeled[head];
+            links[v].index = DONE;
+            mComponent[v] = uint32_t(head);
+            for(uint64_t edge = mOffsets[v]; edge < mOffsets[v + 1]; ++edge){
+                if(--in_degree[mTargets[edge]] == 0){
+                    peeled.push_back(mTargets[edge]);
+                }
+            }
+        }
+        const uint32_t first_cyclic = uint32_t(peeled.size());
+
+        // Tarjan's algorithm on the rest, numbering components from first_cyclic in the order they are
+        // completed (a component is completed after every component it reaches)
+        vector<uint32_t> stack;
+        // (vertex, next edge to follow) of every vertex the search is inside
+        vector<std::pair<uint32_t, uint64_t>> calls;
+        uint32_t counter = 0, components = first_cyclic;
+
+        auto enter = [&] (uint32_t v) {
+            links[v].index = links[v].low = counter++;
+            stack.push_back(v);
+            calls.emplace_back(v, mOffsets[v]);
+        };
+
+        for(uint32_t root = 0; root < vertex_count; ++root){
+            if(links[root].index != UNVISITED){
+                continue;
+            }
+            enter(root);
+            while(!calls.empty()){
+                uint32_t v = calls.back().first;
+                uint64_t edge = calls.back().second;
+                if(edge < mOffsets[v + 1]){
+                    calls.back().second++;
+                    uint32_t w = mTargets[edge];
+                    if(links[w].index == UNVISITED){
+                        enter(w);
+                    }
+                    else if(links[w].index != DONE){
+                        links[v].low = std::min(links[v].low, links[w].index);
+                    }
+                    continue;
+                }
+                // every edge of v followed: hand its low link up, and close its component if it is the root
+                calls.pop_back();
+                if(!calls.empty()){
+                    uint32_t parent = calls.back().first;
+                    links[parent].low = std::min(links[parent].low, links[v].low);
+                }
+                if(links[v].low == links[v].index){
+                    uint32_t w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        links[w].index = DONE;
+                        mComponent[w] = components;
+                    } while(w != v);
+                    components++;
+                }
+            }
+        }
+        // Tarjan completes sinks first, so reversing its numbering gives a topological order
+        for(auto & component : mComponent){
+            if(component >= first_cyclic){
+                component = first_cyclic + components - 1 - component;
+            }
+        }
+        return components;
+    }
+
+    /**
+     * Group the vertices by component and build the condensation
+     * @param components number of components
+     */
+    void build_components(uint32_t components){
+        mMemberOffsets.assign(size_t(components) + 1, 0);
+        for(uint32_t component : mComponent){
+            mMemberOffsets[component + 1]++;
+        }
+        for(uint32_t c = 0; c < components; ++c){
+            mMemberOffsets[c + 1] += mMemberOffsets[c];
+        }
+        mMembers.resize(mComponent.size());
+        vector<uint32_t> fill(mMemberOffsets.begin(), mMemberOffsets.end() - 1);
+        for(uint32_t v = 0; v < mComponent.size(); ++v){
+            mMembers[fill[mComponent[v]]++] = v;
+        }
+
+        // the edges between components, bucketed by the component they leave (a counting sort, in two passes)
+        mCyclic.assign(components, 0);
+        mDagOffsets.assign(size_t(components) + 1, 0);
+        vector<uint32_t> edge_components(mTargets.size());
+        for(uint32_t v = 0; v < mComponent.size(); ++v){
+            uint32_t from = mComponent[v];
+            if(mMemberOffsets[from + 1] - mMemberOffsets[from] > 1){
+                mCyclic[from] = 1;
+            }
+            for(uint64_t edge = mOffsets[v]; edge < mOffsets[v + 1]; ++edge){
+                uint32_t to = mComponent[mTargets[edge]];
+                edge_components[edge] = to;
+                if(to != from){
+                    mDagOffsets[from + 1]++;
+                }
+                else if(mTargets[edge] == v){
+                    mCyclic[from] = 1;
+                }
+            }
+        }
+        for(uint32_t c = 0; c < components; ++c){
+            mDagOffsets[c + 1] += mDagOffsets[c];
+        }
+        mDagTargets.resize(mDagOffsets.back());
+        vector<uint64_t> dag_fill(mDagOffsets.begin(), mDagOffsets.end() - 1);
+        for(uint32_t v = 0; v < mComponent.size(); ++v){
+            uint32_t from = mComponent[v];
+            for(uint64_t edge = mOffsets[v]; edge < mOffsets[v + 1]; ++edge){
+                if(edge_components[edge] != from){
+                    mDagTargets[dag_fill[from]++] = edge_components[edge];
+                }
+            }
+        }
+        // each bucket is short: sort it and drop repeats, closing up the gaps as we go
+        uint64_t kept = 0;
+        for(uint32_t c = 0; c < components; ++c){
+            uint64_t begin = mDagOffsets[c], end = mDagOffsets[c + 1];
+            std::sort(mDagTargets.begin() + begin, mDagTargets.begin() + end);
+            mDagOffsets[c] = kept;
+            for(uint64_t i = begin; i < end; ++i){
+                if(i == begin || mDagTargets[i] != mDagTargets[kept - 1]){
+                    mDagTargets[kept++] = mDagTargets[i];
+                }
+            }
+        }
+        mDagOffsets[components] = kept;
+        mDagTargets.resize(kept);
+        mDagTargets.shrink_to_fit();
+    }
+
+public:
+    /**
+     * Build the index of a graph
+     * @param graph any graph with for_each_vertex and version (see BasicDeBruijnGraph)
+     */
+    template <typename GraphT>
+    explicit ComponentIndex(const GraphT & graph) : mVersion(graph.version()) {
+        size_t vertex_count = graph.get_size();
+        if(vertex_count >= NOT_FOUND){
+            throw std::length_error("ComponentIndex: too many vertices for 32-bit ids");
+        }
+        // ids in store order
+        mKmerOffsets.reserve(vertex_count + 1);
+        mKmers.reserve(vertex_count * size_t(std::max(graph.get_kmer_len(), 1)));
+        size_t slot_count = 16;
+        while(slot_count < 2 * vertex_count){
+            slot_count *= 2;
+        }
+        mSlots.assign(slot_count, NOT_FOUND);
+        // one sweep of the store copies the k-mers and the edges; an edge always leads to its vertex's last k - 1
+        // characters plus one more, so only that character is kept. Hashing and the lookups come after, over
+        // the copies in order, so each slot can be prefetched a few lookups ahead.
+        string edge_labels;
+        edge_labels.reserve(vertex_count);
+        mOffsets.reserve(vertex_count + 1);
+        mOffsets.push_back(0);
+        graph.for_each_vertex([&] (const string & kmer, const DBGraphValue & value) {
+            mKmers += kmer;
+            mKmerOffsets.push_back(mKmers.size());
+            for(auto const & adjacency : value.adjacencies()){
+                edge_labels += adjacency.back();
+            }
+            mOffsets.push_back(edge_labels.size());
+        });
+        vertex_count = mKmerOffsets.size() - 1;
+        vector<uint64_t> hashes(vertex_count);
+        for(size_t id = 0; id < vertex_count; ++id){
+            hashes[id] = hash(kmer_view(id));
+        }
+        const size_t mask = mSlots.size() - 1;
+        for(size_t id = 0; id < vertex_count; ++id){
+            if(id + PREFETCH_DISTANCE < vertex_count){
+                __builtin_prefetch(&mSlots[hashes[id + PREFETCH_DISTANCE] & mask]);
+            }
+            mSlots[probe(kmer_view(id), hashes[id])] = (hashes[id] >> 32 << 32) | id;
+        }
+        string target;
+        auto spell_target = [&] (size_t from, size_t edge) {
+            std::string_view kmer = kmer_view(from);
+            target.assign(kmer.data() + 1, kmer.size() - 1);
+            target += edge_labels[edge];
+        };
+        hashes.resize(edge_labels.size());
+        for(size_t from = 0, edge = 0; from < vertex_count; ++from){
+            for(; edge < mOffsets[from + 1]; ++edge){
+                spell_target(from, edge);
+                hashes[edge] = hash(target);
+            }
+        }
+        // edges to k-mers that are not vertices are dropped, so the offsets are recounted as the targets go in
+        mTargets.reserve(edge_labels.size());
+        size_t edge = 0;
+        for(size_t from = 0; from < vertex_count; ++from){
+            uint64_t end = mOffsets[from + 1];
+            mOffsets[from + 1] = mOffsets[from];
+            for(; edge < end; ++edge){
+                if(edge + PREFETCH_DISTANCE < edge_labels.size()){
+                    __builtin_prefetch(&mSlots[hashes[edge + PREFETCH_DISTANCE] & mask]);
+                }
+                spell_target(from, edge);
+                uint32_t to = slot_id(mSlots[probe(target, hashes[edge])]);
+                if(to != NOT_FOUND){
+                    mTargets.push_back(to);
+                    mOffsets[from + 1]++;
+                }
+            }
+        }
+        mComponent.assign(vertex_count, 0);
+        build_components(find_components());
+    }
+
+    ComponentIndex(const ComponentIndex &) = delete;
+    ComponentIndex & operator=(const ComponentIndex &) = delete;
+
+    /**
+     * @return version() of the graph when the index was built
+     */
+    uint64_t version() const { return mVersion; }
+
+///@remark VERTICES /////////////////////////////////////////////////////////////
+
+    /**
+     * @return number of vertices
+     */
+    size_t vertex_count() const { return mComponent.size(); }
+
+    /**
+     * @param kmer vertex
+     * @return its id, or NOT_FOUND
+     */
+    uint32_t vertex_id(std::string_view kmer) const { return slot_id(mSlots[probe(kmer, hash(kmer))]); }
+
+    /**
+     * @param id vertex id
+     * @return its k-mer (valid as long as the index)
+     */
+    std::string_view kmer(uint32_t id) const {
+        if(id >= vertex_count()){
+            throw std::out_of_range("ComponentIndex::kmer: no vertex has id " + std::to_string(id));
+        }
+        return kmer_view(id);
+    }
+
+    /**
+     * @param kmer vertex
+     * @return id of its component, or NOT_FOUND if it is not in the graph
+     */
+    uint32_t component_of(std::string_view kmer) const {
+        uint32_t id = vertex_id(kmer);
+        return id == NOT_FOUND ? NOT_FOUND : mComponent[id];
+    }
+
+    /**
+     * @param id vertex id
+     * @return id of its component
+     */
+    uint32_t component_of_id(uint32_t id) const { return mComponent.at(id); }
+
+///@remark COMPONENTS /////////////////////////////////////////////////////////////
+
+    /**
+     * @return number of strongly connected components
+     */
+    size_t component_count() const { return mCyclic.size(); }
+
+    /**
+     * @param component id
+     * @return number of vertices in it
+     */
+    size_t component_size(uint32_t component) const {
+        return mMemberOffsets.at(size_t(component) + 1) - mMemberOffsets[component];
+    }
+
+    /**
+     * @return size of every component, by id
+     */
+    vector<size_t> component_sizes() const {
+        vector<size_t> sizes(component_count());
+        for(uint32_t c = 0; c < sizes.size(); ++c){
+            sizes[c] = component_size(c);
+        }
+        return sizes;
+    }
+
+    /**
+     * @return number of vertices in the largest component
+     */
+    size_t largest_component_size() const {
+        size_t largest = 0;
+        for(uint32_t c = 0; c < component_count(); ++c){
+            largest = std::max(largest, component_size(c));
+        }
+        return largest;
+    }
+
+    /**
+     * @param component id
+     * @return true if the component contains a cycle
+     */
+    bool is_cyclic(uint32_t component) const { return mCyclic.at(component); }
+
+    /**
+     * @return number of vertices that lie on a cycle (the vertices of cyclic components)
+     */
+    size_t cyclic_vertex_count() const {
+        size_t count = 0;
+        for(uint32_t c = 0; c < component_count(); ++c){
+            count += mCyclic[c] ? component_size(c) : 0;
+        }
+        return count;
+    }
+
+    /**
+     * Call func on the id of every vertex in a component
+     * @param component id
+     * @param func lambda taking a uint32_t
+     */
+    template <typename FuncType>
+    void for_each_member(uint32_t component, FuncType func) const {
+        for(uint32_t i = mMemberOffsets.at(component); i < mMemberOffsets[size_t(component) + 1]; ++i){
+            func(mMembers[i]);
+        }
+    }
+
+///@remark CONDENSATION /////////////////////////////////////////////////////////////
+
+    /**
+     * Call func on every component the given one has an edge into (each once, in increasing order; every
+     * one of them has a higher id)
+     * @param component id
+     * @param func lambda taking a uint32_t
+     */
+    template <typename FuncType>
+    void for_each_successor(uint32_t component, FuncType func) const {
+        for(uint64_t i = mDagOffsets.at(component); i < mDagOffsets[size_t(component) + 1]; ++i){
+            func(mDagTargets[i]);
+        }
+    }
+
+    /**
+     * @param component id
+     * @return number of components it has an edge into
+     */
+    size_t out_degree(uint32_t component) const {
+        return mDagOffsets.at(size_t(component) + 1) - mDagOffsets[component];
+    }
+
+    /**
+     * @return number of edges of the condensation DAG
+     */
+    size_t condensation_edge_count() const { return mDagTargets.size(); }
+
+    /**
+     * @return bytes held by the index
+     */
+    size_t memory_bytes() const {
+        return sizeof(*this) + mKmers.capacity() + mKmerOffsets.capacity() * sizeof(uint64_t)
+            + mSlots.capacity() * sizeof(uint64_t) + mOffsets.capacity() * sizeof(uint64_t) + mTargets.capacity() * sizeof(uint32_t)
+            + mComponent.capacity() * sizeof(uint32_t) + mMemberOffsets.capacity() * sizeof(uint32_t)
+            + mMembers.capacity() * sizeof(uint32_t) + mDagOffsets.capacity() * sizeof(uint64_t)
+            + mDagTargets.capacity() * sizeof(uint32_t) + mCyclic.capacity();
+    }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COMPONENTINDEX_H
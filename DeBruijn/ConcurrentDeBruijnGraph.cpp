@@ -0,0 +1,164 @@
+/**
+ * @file ConcurrentDeBruijnGraph.cpp
+ * @author Anna Catenacci
+ */
+
+#include "ConcurrentDeBruijnGraph.hpp"
+#include "DeBruijnGraph.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <thread>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    vector<string> genomes = {
+        "1111000110111101110101100101000010101110000001011000011101110101000001110000100101110100111010100110",
+        "1111111110111100011110100010101010101110010011100111010000101110001101010010110010010111110111100011",
+        "1101100110101001001111110000100010110001101010100100101100010000111001101001011000011010111001000001",
+        "1001010100101010100101111100111001101100000101110110001010010011110110110010111111111111101101101111",
+        "1110001001111100101011001011011100101000101000000000011110100101001100010101000000001010111011101010",
+        "0101000101001000001011010110101010011101000100101100000111000100000010010010011111101011101001010011",
+        "0100011001111111010100010011000100001101101001100011011001101101111001000110001110110000110101111011",
+        "1100000000000101101010001010000101001000011011001111110100110101101011101010101101100101010110100111",
+        "123456789",
+        "123450000",
+        "999456789",
+        "555555555",
+    };
+
+    /// The concurrent graph reports the same vertices, edges and counts as the serial one
+    void check_matches(const ConcurrentDeBruijnGraph & concurrent, const DeBruijnGraph & serial){
+        CHECK(concurrent.get_sequence_size() == serial.get_sequence_size());
+        CHECK(concurrent.get_size() == serial.get_size());
+        CHECK(concurrent.edge_count() == serial.edge_count());
+        CHECK(concurrent.get_all_vertices() == serial.get_all_vertices());
+        CHECK(concurrent.get_start_vertices().size() == serial.get_start_vertices().size());
+        vector<string> concurrent_branches = concurrent.get_branch_vertices();
+        vector<string> serial_branches = serial.get_branch_vertices();
+        std::sort(concurrent_branches.begin(), concurrent_branches.end());
+        std::sort(serial_branches.begin(), serial_branches.end());
+        CHECK(concurrent_branches == serial_branches);
+        for(auto vertex : serial.get_all_vertices()){
+            CHECK(concurrent.get_kmer_occurrences(vertex) == serial.get_value(vertex).get_kmer_occurrences());
+            CHECK(concurrent.get_value(vertex).get_adj_list() == serial.get_value(vertex).get_adj_list());
+            CHECK(concurrent.get_value(vertex).get_endpoint() == serial.get_value(vertex).get_endpoint());
+            CHECK(concurrent.get_value(vertex).get_empty_bool() == serial.get_value(vertex).get_empty_bool());
+        }
+    }
+}
+
+TEST_CASE("ConcurrentDeBruijnGraph__matches-serial-graph", "[ConcurrentDeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph serial;
+        ConcurrentDeBruijnGraph concurrent(3, 8);
+        for(auto genome : genomes){
+            serial.add_sequence(genome);
+        }
+
+        // every thread adds an interleaved slice of the population
+        vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&concurrent, t] () {
+                for(int i = t; i < int(genomes.size()); i += 4){
+                    concurrent.add_sequence(genomes[i]);
+                }
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+
+        check_matches(concurrent, serial);
+        for(auto genome : genomes){
+            CHECK(concurrent.is_valid(genome));
+        }
+        CHECK(!concurrent.is_valid("123999999"));
+
+        // removals drop an edge only once no remaining genome uses it, as in the serial graph
+        threads.clear();
+        for(int t = 0; t < 2; ++t){
+            threads.emplace_back([&concurrent, t] () {
+                for(int i = 2 * t; i < int(genomes.size()); i += 4){
+                    concurrent.remove_sequence(genomes[i]);
+                }
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+        for(int i = 0; i < int(genomes.size()); i += 2){
+            serial.remove_sequence(genomes[i]);
+        }
+        check_matches(concurrent, serial);
+
+        DeBruijnGraph serial_small;
+        ConcurrentDeBruijnGraph concurrent_small(3, 4);
+        for(auto genome : {"11001111", "10010110", "01000100"}){
+            serial_small.add_sequence(genome);
+            concurrent_small.add_sequence(genome);
+        }
+        serial_small.remove_sequence("11001111");
+        concurrent_small.remove_sequence("11001111");
+        check_matches(concurrent_small, serial_small);
+        CHECK(concurrent_small.edge_count() == 8);
+        CHECK(!concurrent_small.get_value("001").valid_adj("011"));
+
+        // a remove-heavy run: branch points that lose a successor leave the branch list in both graphs
+        DeBruijnGraph serial_mixed;
+        ConcurrentDeBruijnGraph concurrent_mixed(3, 8);
+        emp::Random random(26);
+        vector<string> living;
+        for(int step = 0; step < 400; ++step){
+            if(living.size() > 2 && random.P(0.6)){
+                size_t dead = random.GetUInt(living.size());
+                serial_mixed.remove_sequence(living[dead]);
+                concurrent_mixed.remove_sequence(living[dead]);
+                living.erase(living.begin() + dead);
+            }
+            else {
+                string genome;
+                for(int j = 0; j < 10; ++j){
+                    genome += random.P(0.5) ? '1' : '0';
+                }
+                serial_mixed.add_sequence(genome);
+                concurrent_mixed.add_sequence(genome);
+                living.push_back(genome);
+            }
+        }
+        check_matches(concurrent_mixed, serial_mixed);
+    }
+}
+
+TEST_CASE("ConcurrentDeBruijnGraph__concurrent-removal", "[ConcurrentDeBruijnGraph.hpp]")
+{
+    {
+        ConcurrentDeBruijnGraph concurrent(3, 8);
+        for(auto genome : genomes){
+            concurrent.add_sequence(genome);
+        }
+
+        // remove every genome from two threads while two others re-add a copy of each
+        vector<std::thread> threads;
+        for(int t = 0; t < 2; ++t){
+            threads.emplace_back([&concurrent, t] () {
+                for(int i = t; i < int(genomes.size()); i += 2){
+                    concurrent.remove_sequence(genomes[i]);
+                }
+            });
+            threads.emplace_back([&concurrent, t] () {
+                for(int i = t; i < int(genomes.size()); i += 2){
+                    concurrent.add_sequence(genomes[i]);
+                }
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+
+        CHECK(concurrent.get_sequence_size() == int(genomes.size()));
+        CHECK(concurrent.get_size() == int(concurrent.get_all_vertices().size()));
+
+        for(auto genome : genomes){
+            concurrent.remove_sequence(genome);
+        }
+        CHECK(concurrent.get_sequence_size() == 0);
+        CHECK(concurrent.get_size() == 0);
+        CHECK(concurrent.get_all_vertices().empty());
+        CHECK(concurrent.get_start_vertices().empty());
+    }
+}
@@ -0,0 +1,404 @@
+/**
+ * @file ConcurrentDeBruijnGraph.hpp
+ * @author Anna Catenacci
+ *
+ * A thread-safe variant of DeBruijnGraph so MABE's organism updates can run on multiple threads.
+ * Vertices are striped across shards by k-mer hash, each shard guarded by its own mutex.
+ *
+ * Consistency model:
+ * - add_sequence, remove_sequence and is_valid lock every shard the sequence touches (in ascending
+ *   shard order, so they cannot deadlock) and hold them for the whole call. Each of these calls is
+ *   therefore linearizable: it takes effect atomically at some point while it holds its locks.
+ * - get_value, get_kmer_occurrences and vertex_branch_check lock a single shard and are linearizable.
+ * - get_size, get_sequence_size and edge_count read atomic counters. They are exact once writers are
+ *   quiescent, and may lag in-flight calls by at most those calls' own contributions.
+ * - get_all_vertices, get_branch_vertices and get_start_vertices are not snapshots of the whole graph;
+ *   use them between generations (or take a DeBruijnGraph snapshot) when an exact view is needed.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_CONCURRENTDEBRUIJNGRAPH_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_CONCURRENTDEBRUIJNGRAPH_H
+
+#include "DeBruijnValue.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+
+using std::string; using std::vector; using std::map;
+
+class ConcurrentDeBruijnGraph {
+private:
+
+    /// One stripe of the vertex store
+    struct Shard {
+        std::mutex mMutex;
+        map<string, DBGraphValue> mVertices;
+    };
+
+    /// Length of the k-mer IDs
+    int mKmerLength = 3;
+
+    /// Number of vertices the graph contains
+    std::atomic<int> mSize{0};
+
+    /// Number of sequences currently in the graph
+    std::atomic<int> mSeqSize{0};
+
+    /// Length of the most recently added sequence
+    std::atomic<int> mSequenceLength{0};
+
+    /// Number of edges the graph contains
+    std::atomic<int> mEdgeCount{0};
+
+    /// Number of shards the vertex store is striped across
+    size_t mShardCount = 64;
+
+    /// Vertex store, striped by k-mer hash
+    std::unique_ptr<Shard[]> mShards;
+
+    /// Guards mBranchedVertices and mStarts. Only ever taken while no shard lock is requested
+    /// afterwards, so the lock order is always shards (ascending) -> lists.
+    mutable std::mutex mListMutex;
+
+    /// Vector of all vertices that branch
+    vector<string> mBranchedVertices;
+
+    /// Vector of all beginning verticies
+    vector<string> mStarts;
+
+    /**
+     * Find the shard a k-mer lives in
+     * @param kmer vertex ID
+     * @return index of the shard
+     */
+    size_t shard_index(const string & kmer) const { return std::hash<string>{}(kmer) % mShardCount; }
+
+    /**
+     * Lock every shard that a sequence touches, in ascending order
+     * @param sequence whose k-mers we will read or write
+     * @return the held locks; they are released when the vector goes out of scope
+     */
+    vector<std::unique_lock<std::mutex>> lock_sequence(const string & sequence) const {
+        vector<bool> needed(mShardCount, false);
+        for(int i = 0; i + mKmerLength <= int(sequence.size()); ++i){
+            needed[shard_index(sequence.substr(i, mKmerLength))] = true;
+        }
+        if(int(sequence.size()) < mKmerLength){
+            needed[shard_index(sequence)] = true;
+        }
+        vector<std::unique_lock<std::mutex>> locks;
+        for(size_t i = 0; i < mShardCount; ++i){
+            if(needed[i]){
+                locks.emplace_back(mShards[i].mMutex);
+            }
+        }
+        return locks;
+    }
+
+    /**
+     * Access (inserting if needed) a vertex. The caller must hold its shard lock.
+     * @param kmer vertex ID
+     * @return the vertex value
+     */
+    DBGraphValue & vertex(const string & kmer) { return mShards[shard_index(kmer)].mVertices[kmer]; }
+
+    /**
+     * Check whether a vertex exists. The caller must hold its shard lock.
+     * @param kmer vertex ID
+     * @return true if the vertex is in the graph
+     */
+    bool contains(const string & kmer) const { return mShards[shard_index(kmer)].mVertices.count(kmer) > 0; }
+
+    /**
+     * Add a use of the edge between two vertices. The caller must hold the shard lock of start_v.
+     * @param start_v Starting Debruijn vertex
+     * @param end_v Vertex being pointed to
+     */
+    void add_edge(const string & start_v, const string & end_v){
+        DBGraphValue & value = vertex(start_v);
+        int initial_adj_size = value.adj_list_size();
+        value.add_to_adj_list(end_v);
+        value.increment_edge_count(end_v);
+        if(initial_adj_size < value.adj_list_size()){
+            mEdgeCount++;
+            if(initial_adj_size > 0){ // the vertex just became (or already was) a branch point
+                value.set_branch(true);
+                std::lock_guard<std::mutex> guard(mListMutex);
+                if(std::find(mBranchedVertices.begin(), mBranchedVertices.end(), start_v) == mBranchedVertices.end()){
+                    mBranchedVertices.push_back(start_v);
+                }
+            }
+        }
+    }
+
+    /**
+     * Take an edge out of a vertex's adjacency list, as DeBruijnGraph does: a vertex left with fewer than two
+     * successors stops being a branch point, and one left with none is flagged as an endpoint.
+     * The caller must hold the shard lock of from.
+     * @param from k-mer of the edge's source vertex
+     * @param value its value
+     * @param to vertex being pointed to
+     */
+    void drop_edge(const string & from, DBGraphValue & value, const string & to){
+        value.remove_from_adj_list(to);
+        if(value.adj_list_size() == 0){
+            value.set_empty_bool(1);
+        }
+        if(value.get_branch() && value.adj_list_size() < 2){
+            value.set_branch(false);
+            std::lock_guard<std::mutex> guard(mListMutex);
+            mBranchedVertices.erase(std::remove(mBranchedVertices.begin(), mBranchedVertices.end(), from), mBranchedVertices.end());
+        }
+    }
+
+    /**
+     * remove_sequence helper function to make sure a vertex is removed from all containers.
+     * The caller must hold its shard lock.
+     * @param kmer vertex to remove
+     */
+    void remove(const string & kmer){
+        map<string, DBGraphValue> & vertices = mShards[shard_index(kmer)].mVertices;
+        auto it = vertices.find(kmer);
+        if(it != vertices.end()){
+            mSize--;
+            mEdgeCount -= it->second.adj_list_size();
+            vertices.erase(it);
+        }
+        std::lock_guard<std::mutex> guard(mListMutex);
+        mStarts.erase(std::remove(mStarts.begin(), mStarts.end(), kmer), mStarts.end());
+        mBranchedVertices.erase(std::remove(mBranchedVertices.begin(), mBranchedVertices.end(), kmer), mBranchedVertices.end());
+    }
+
+    /**
+     * is_valid body. The caller must hold the shard locks of the sequence.
+     * @param sequence to evaluate
+     * @return true if the sequence is in the graph
+     */
+    bool is_valid_locked(const string & sequence) const {
+        for(int i = 0; i + mKmerLength + 1 < int(sequence.size()); ++i){
+            const map<string, DBGraphValue> & vertices = mShards[shard_index(sequence.substr(i, mKmerLength))].mVertices;
+            auto it = vertices.find(sequence.substr(i, mKmerLength));
+            if(it == vertices.end() || !it->second.valid_adj(sequence.substr(i+1, mKmerLength))){
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    /**
+     * Construct an empty concurrent graph
+     * @param kmer_length length of each vertex ID
+     * @param shards number of lock stripes; more shards means less contention between writers
+     */
+    ConcurrentDeBruijnGraph(int kmer_length = 3, size_t shards = 64)
+        : mKmerLength(kmer_length), mShardCount(shards > 0 ? shards : 1), mShards(new Shard[mShardCount]) { }
+    ~ConcurrentDeBruijnGraph()=default;
+    ConcurrentDeBruijnGraph(const ConcurrentDeBruijnGraph &) = delete;
+    ConcurrentDeBruijnGraph & operator=(const ConcurrentDeBruijnGraph &) = delete;
+
+///@remark MABE FUNCTIONS (add sequence, remove sequence) /////////////////////////////////////////////////////////////
+
+    /**
+     * Add a sequence into the graph. Safe to call from any number of threads.
+     * @param sequence to add to the graph
+     */
+    void add_sequence(const string & sequence){
+        auto locks = lock_sequence(sequence);
+        mSeqSize++;
+        mSequenceLength = sequence.size();
+        string first = sequence.substr(0, mKmerLength);
+        // if the beginning string is not in the graph, add a new beginning vertex
+        if(!contains(first)){
+            vertex(first);
+            mSize++;
+            std::lock_guard<std::mutex> guard(mListMutex);
+            mStarts.push_back(first);
+        }
+        // go through the entire new sequence and add edges:
+        int i = 0;
+        for(; i + mKmerLength < int(sequence.size()); ++i){
+            string current = sequence.substr(i, mKmerLength);
+            string next = sequence.substr(i+1, mKmerLength);
+            if(!contains(next)){
+                vertex(next);
+                mSize++;
+            }
+            add_edge(current, next);
+            vertex(current).set_empty_bool(0);
+            vertex(current).increment_kmer_occurrences();
+        }
+        DBGraphValue & last = vertex(sequence.substr(i, mKmerLength));
+        if(last.get_empty_bool() == 2){
+            last.set_empty_bool(1);
+        }
+        last.increment_endpoint();
+        last.increment_kmer_occurrences();
+    }
+
+    /**
+     * Remove a sequence from the graph. Safe to call from any number of threads.
+     * Validation and removal happen under the same locks, so a concurrent add or remove of an
+     * overlapping sequence can never interleave with it.
+     * @param sequence to remove
+     */
+    void remove_sequence(const string & sequence){
+        auto locks = lock_sequence(sequence);
+        if(!is_valid_locked(sequence)){
+            return;
+        }
+        mSeqSize--;
+        int i = 0;
+        for(; i + mKmerLength < int(sequence.size()); ++i){
+            string current = sequence.substr(i, mKmerLength);
+            string next = sequence.substr(i+1, mKmerLength);
+            DBGraphValue & current_value = vertex(current);
+            current_value.decrement_kmer_occurrences();
+            //if no other sequence uses the edge, break adj & remove edge from graph
+            if(current_value.decrement_edge_count(next) <= 0){
+                if(current_value.valid_adj(next)){
+                    mEdgeCount--;
+                }
+                drop_edge(current, current_value, next);
+            }
+            //if current kmer was only in 1 seq in the pangenome, delete it from the store
+            if(current_value.get_kmer_occurrences() <= 0){
+                remove(current);
+            }
+        }
+        string last = sequence.substr(i, mKmerLength);
+        DBGraphValue & last_value = vertex(last);
+        last_value.decrement_kmer_occurrences();
+        last_value.decrement_endpoint();
+        if(last_value.get_kmer_occurrences() <= 0){
+            remove(last);
+        }
+    }
+
+    /**
+     * Iterate through graph along sequence to make sure the sequence is in the graph.
+     * Safe to call from any number of threads; never inserts vertices.
+     * @param sequence to evaluate
+     * @return true is the sequence is valid, false if it is not in the graph
+     */
+    bool is_valid(const string & sequence) const {
+        auto locks = lock_sequence(sequence);
+        return is_valid_locked(sequence);
+    }
+
+///@remark GETTERS /////////////////////////////////////////////////////////////
+
+    /**
+     * Return size of graph (NOT the total number of sequences in the pangenome)
+     * @return number of vertices the graph contains
+     */
+    int get_size() const { return mSize; }
+
+    /**
+     * Return sequence size of graph
+     * @return number of sequences the graph has added into the total pangenome
+     */
+    int get_sequence_size() const { return mSeqSize; }
+
+    /**
+     * Return length of the k-mer IDs
+     * @return k
+     */
+    int get_kmer_len() const { return mKmerLength; }
+
+    /**
+     * Return length of the most recently added sequence
+     * @return sequence length
+     */
+    int get_sequence_length() const { return mSequenceLength; }
+
+    /**
+     * @return int number of edges in the graph
+     */
+    int edge_count() const { return mEdgeCount; }
+
+    /**
+     * Return the number of shards the vertex store is striped across
+     * @return shard count
+     */
+    size_t shard_count() const { return mShardCount; }
+
+    /**
+     * Get a copy of the value associated with a vertex
+     * @param vertex k-mer to look up
+     * @return Debruijn vertex value object (default-constructed if the vertex is not in the graph)
+     */
+    DBGraphValue get_value(const string & vertex) const {
+        Shard & shard = mShards[shard_index(vertex)];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        auto it = shard.mVertices.find(vertex);
+        return it == shard.mVertices.end() ? DBGraphValue() : it->second;
+    }
+
+    /**
+     * Get the number of times a k-mer is used across all sequences
+     * @param vertex k-mer to look up
+     * @return occurrence count, 0 if the vertex is not in the graph
+     */
+    int get_kmer_occurrences(const string & vertex) const {
+        Shard & shard = mShards[shard_index(vertex)];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        auto it = shard.mVertices.find(vertex);
+        return it == shard.mVertices.end() ? 0 : it->second.get_kmer_occurrences();
+    }
+
+    /**
+     * Given a vertex, return true if the vertex branches
+     * @param vertex to check
+     * @return true if the vertex has more than one vertex in it's adjacency list
+     */
+    bool vertex_branch_check(const string & vertex) const {
+        Shard & shard = mShards[shard_index(vertex)];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        auto it = shard.mVertices.find(vertex);
+        return it != shard.mVertices.end() && it->second.get_branch();
+    }
+
+    /**
+     * Return vector containing all vertices in graph, sorted.
+     * Shards are visited one at a time, so this is not an atomic snapshot while writers are running.
+     * @return vector containing all DeBruijn vertex IDs
+     */
+    vector<string> get_all_vertices() const {
+        vector<string> all_vertices;
+        for(size_t i = 0; i < mShardCount; ++i){
+            std::lock_guard<std::mutex> guard(mShards[i].mMutex);
+            for(auto const & element : mShards[i].mVertices){
+                all_vertices.push_back(element.first);
+            }
+        }
+        std::sort(all_vertices.begin(), all_vertices.end());
+        return all_vertices;
+    }
+
+    /**
+     * Return vector containing vertices with more than one adjacency in graph
+     * @return vector containing branched DeBruijn vertex IDs
+     */
+    vector<string> get_branch_vertices() const {
+        std::lock_guard<std::mutex> guard(mListMutex);
+        return mBranchedVertices;
+    }
+
+    /**
+     * Return vector containing vertices that represent the beginning(s) of the graph
+     * @return vector containing beginning DeBruijn vertex IDs
+     */
+    vector<string> get_start_vertices() const {
+        std::lock_guard<std::mutex> guard(mListMutex);
+        return mStarts;
+    }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_CONCURRENTDEBRUIJNGRAPH_H
@@ -0,0 +1,83 @@
+/**
+ * @file CounterRandom.cpp
+ * @author Anna Catenacci
+ */
+
+#include "CounterRandom.hpp"
+#include <random>
+#include <vector>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("CounterRandom__philox-known-answers", "[CounterRandom.hpp]")
+{
+    {
+        // test vectors from the Random123 distribution
+        CHECK(CounterRandom::philox({0, 0, 0, 0}, {0, 0})
+              == CounterRandom::block_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+        CHECK(CounterRandom::philox({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff})
+              == CounterRandom::block_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+        CHECK(CounterRandom::philox({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0})
+              == CounterRandom::block_t{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+    }
+}
+
+TEST_CASE("CounterRandom__independent-streams", "[CounterRandom.hpp]")
+{
+    {
+        // the same (seed, generation, organism) always gives the same stream
+        CounterRandom a(42, 7, 3), b(42, 7, 3);
+        std::vector<uint32_t> first, second;
+        for(int i = 0; i < 20; ++i){
+            first.push_back(a.next());
+        }
+        for(int i = 0; i < 20; ++i){
+            second.push_back(b.next());
+        }
+        CHECK(first == second);
+
+        // changing any part of the key changes the stream
+        CounterRandom other_organism(42, 7, 4), other_generation(42, 8, 3), other_seed(43, 7, 3);
+        CHECK(other_organism.next() != first[0]);
+        CHECK(other_generation.next() != first[0]);
+        CHECK(other_seed.next() != first[0]);
+
+        // seeking to a block reproduces the stream from there
+        CounterRandom c(42, 7, 3);
+        c.seek(2);
+        CHECK(c.next() == first[8]);
+        CHECK(c.next() == first[9]);
+    }
+}
+
+TEST_CASE("CounterRandom__distributions", "[CounterRandom.hpp]")
+{
+    {
+        CounterRandom random(1);
+        std::vector<int> counts(6, 0);
+        int heads = 0;
+        for(int i = 0; i < 60000; ++i){
+            uint32_t value = random.GetUInt(6);
+            REQUIRE(value < 6);
+            counts[value]++;
+            uint32_t ranged = random.GetUInt(10, 13);
+            CHECK((ranged >= 10 && ranged < 13));
+            double fraction = random.GetDouble();
+            CHECK((fraction >= 0 && fraction < 1));
+            heads += random.P(0.25);
+        }
+        for(int count : counts){
+            CHECK((count > 9500 && count < 10500));
+        }
+        CHECK((heads > 14500 && heads < 15500));
+        CHECK(random.GetUInt(0) == 0);
+        CHECK(random.GetUInt(1) == 0);
+        CHECK(!random.P(0));
+        CHECK(random.P(1));
+
+        // works as a standard generator
+        std::uniform_int_distribution<int> die(1, 6);
+        int roll = die(random);
+        CHECK((roll >= 1 && roll <= 6));
+    }
+}
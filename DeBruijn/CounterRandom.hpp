@@ -0,0 +1,158 @@
+/**
+ * @file CounterRandom.hpp
+ * @author Anna Catenacci
+ *
+ * A counter-based random number generator (Philox4x32-10, Salmon et al. 2011) for reproducible sampling.
+ *
+ * Every number is a pure function of (seed, generation, organism id, position in the stream), so an
+ * organism's offspring walk comes out the same no matter which thread runs it or in what order the
+ * population is processed. Give each organism its own generator:
+ *     CounterRandom random(seed, generation, organism_id);
+ *     string child = graph.sample_path(random, parent);
+ *
+ * It has the GetUInt / GetDouble / P calls the graphs use from emp::Random, and it is also a standard
+ * uniform random bit generator, so it works with <random> distributions and std::shuffle.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COUNTERRANDOM_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COUNTERRANDOM_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+class CounterRandom {
+public:
+    using result_type = uint32_t;
+    using block_t = std::array<uint32_t, 4>;
+    using key_t = std::array<uint32_t, 2>;
+
+private:
+    /// Philox round multipliers and key increments (from the Random123 reference implementation)
+    static constexpr uint32_t MULTIPLIER_0 = 0xD2511F53;
+    static constexpr uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    static constexpr uint32_t KEY_STEP_0 = 0x9E3779B9;
+    static constexpr uint32_t KEY_STEP_1 = 0xBB67AE85;
+    static constexpr int ROUNDS = 10;
+
+    /// Seed of the run
+    key_t mKey;
+
+    /// Counter: [0] block within the stream, [1] organism id, [2] and [3] generation
+    block_t mCounter;
+
+    /// Output of the current block
+    block_t mBlock;
+
+    /// Next unused word of mBlock (4 means the block is used up)
+    int mUsed = 4;
+
+    /**
+     * Split a 32 x 32-bit product into its high and low words
+     */
+    static void multiply(uint32_t a, uint32_t b, uint32_t & high, uint32_t & low){
+        uint64_t product = uint64_t(a) * b;
+        high = uint32_t(product >> 32);
+        low = uint32_t(product);
+    }
+
+public:
+    /**
+     * @param seed seed of the run
+     * @param generation generation being sampled
+     * @param organism_id id of the organism whose offspring is being sampled
+     */
+    CounterRandom(uint64_t seed, uint64_t generation = 0, uint32_t organism_id = 0)
+        : mKey{uint32_t(seed), uint32_t(seed >> 32)},
+          mCounter{0, organism_id, uint32_t(generation), uint32_t(generation >> 32)}, mBlock{} { }
+
+    /**
+     * The Philox4x32-10 block function
+     * @param counter 128-bit counter
+     * @param key 64-bit key
+     * @return four random words
+     */
+    static block_t philox(block_t counter, key_t key){
+        for(int round = 0; round < ROUNDS; ++round){
+            uint32_t high_0, low_0, high_1, low_1;
+            multiply(MULTIPLIER_0, counter[0], high_0, low_0);
+            multiply(MULTIPLIER_1, counter[2], high_1, low_1);
+            counter = {high_1 ^ counter[1] ^ key[0], low_1, high_0 ^ counter[3] ^ key[1], low_0};
+            key[0] += KEY_STEP_0;
+            key[1] += KEY_STEP_1;
+        }
+        return counter;
+    }
+
+    /**
+     * Jump to a position in the stream, e.g. to skip the draws another part of the program makes
+     * @param block number of 4-word blocks to skip from the start of the stream
+     */
+    void seek(uint32_t block){
+        mCounter[0] = block;
+        mUsed = 4;
+    }
+
+    /**
+     * @return next 32 random bits
+     */
+    uint32_t next(){
+        if(mUsed == 4){
+            mBlock = philox(mCounter, mKey);
+            mCounter[0]++;
+            mUsed = 0;
+        }
+        return mBlock[mUsed++];
+    }
+
+///@remark UNIFORM RANDOM BIT GENERATOR /////////////////////////////////////////////////////////////
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() { return next(); }
+
+///@remark emp::Random CALLS /////////////////////////////////////////////////////////////
+
+    /**
+     * Uniform integer below a bound, without modulo bias (Lemire's multiply-and-reject)
+     * @param max one past the largest value
+     * @return value in [0, max), or 0 if max is 0
+     */
+    uint32_t GetUInt(uint32_t max){
+        uint64_t product = uint64_t(next()) * max;
+        uint32_t low = uint32_t(product);
+        if(low < max){
+            uint32_t threshold = uint32_t(-max) % max;
+            while(low < threshold){
+                product = uint64_t(next()) * max;
+                low = uint32_t(product);
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+    /**
+     * @param min smallest value
+     * @param max one past the largest value
+     * @return value in [min, max)
+     */
+    uint32_t GetUInt(uint32_t min, uint32_t max){ return min + GetUInt(max - min); }
+
+    /**
+     * @return value in [0, 1) with 53 random bits
+     */
+    double GetDouble(){
+        uint64_t high = next();
+        uint64_t bits = (high << 21) | (next() >> 11);
+        return bits * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * @param probability chance of returning true
+     * @return true with the given probability
+     */
+    bool P(double probability){ return GetDouble() < probability; }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_COUNTERRANDOM_H
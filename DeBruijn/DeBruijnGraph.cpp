@@ -4,6 +4,12 @@
  */
 
 #include "DeBruijnGraph.hpp"
+#include "CounterRandom.hpp"
+#include "GraphContents.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <sstream>
+#include <random>
+#include <set>
 #define CATCH_CONFIG_MAIN
 #include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
 
@@ -110,4 +116,933 @@ TEST_CASE("DeBruijnGraph__construction-and-removal", "[DeBruijnGraph.hpp]")
         CHECK(g.is_valid(new_genome));
 
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("DeBruijnGraph__copy-on-write-clones", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph ancestor;
+        ancestor.add_sequence("12345678");
+        ancestor.add_sequence("12345000");
+
+        // fork two replicates from the common ancestor and let them diverge
+        DeBruijnGraph replicate_a = ancestor;
+        DeBruijnGraph replicate_b = ancestor;
+        replicate_a.remove_sequence("12345678");
+        replicate_b.add_sequence("99945000");
+
+        CHECK(ancestor.get_sequence_size() == 2);
+        CHECK(ancestor.is_valid("12345678"));
+        CHECK(ancestor.get_all_vertices().size() == 9);
+
+        CHECK(replicate_a.get_sequence_size() == 1);
+        CHECK(!replicate_a.is_valid("12345678"));
+        CHECK(replicate_a.is_valid("12345000"));
+
+        CHECK(replicate_b.get_sequence_size() == 3);
+        CHECK(replicate_b.is_valid("99945000"));
+        CHECK(!ancestor.is_valid("99945000"));
+        CHECK(replicate_b.get_start_vertices().size() == 2);
+        CHECK(ancestor.get_start_vertices().size() == 1);
+
+        // crossover in a clone leaves the ancestor's flags and counts alone
+        emp::Random random;
+        string child = replicate_b.modify_org(random, "12345678");
+        CHECK(replicate_b.is_valid(child));
+        CHECK(ancestor.get_value("123").get_kmer_occurrences() == 2);
+        CHECK(ancestor.get_value("123").get_visitor_flag() == 0);
+    }
+    {
+        // kmer_count on a clone whose directory is private but whose chunks are still shared
+        std::mt19937 engine(1);
+        DeBruijnGraph ancestor(6), twin(6);
+        for(int i = 0; i < 40; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += char('0' + engine() % 4);
+            }
+            ancestor.add_sequence(genome);
+            twin.add_sequence(genome);
+        }
+        vector<string> all = ancestor.get_all_vertices();
+        for(size_t i = 0; i + 1 < all.size(); ++i){
+            DBGraphValue value = ancestor.get_value(all[i]);
+            if(value.adj_list_size() == 0){
+                continue;
+            }
+            DeBruijnGraph clone = ancestor;
+            clone.set_avail_adj_list(all.back());
+            auto counts = clone.kmer_count(value.get_kmer_occurrences(), all[i], value.adjacencies().back());
+            CHECK(counts == DeBruijnGraph(twin).kmer_count(value.get_kmer_occurrences(), all[i], value.adjacencies().back()));
+            CHECK(clone.get_value(all[i]).get_visitor_flag() == 1);
+            CHECK(ancestor.get_value(all[i]).get_visitor_flag() == 0);
+        }
+    }
+}
+
+
+TEST_CASE("DeBruijnGraph__memory-usage", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph g;
+        DeBruijnMemoryUsage empty = g.memory_usage();
+        CHECK(empty.vertex_keys == 0);
+        CHECK(empty.adjacency == 0);
+
+        g.add_sequence("12345678");
+        g.add_sequence("12345000");
+        DeBruijnMemoryUsage two = g.memory_usage();
+        size_t kmer_bytes = two.vertex_keys / 9;
+        CHECK(g.get_all_vertices().size() == 9);
+        CHECK(two.total() > empty.total());
+        // tracked counters agree with a full traversal of the adjacency lists
+        CHECK(two.adjacency == kmer_bytes * g.edge_count());
+        CHECK(two.starts > 0);
+        CHECK(two.branch_index > 0);
+        CHECK(two.available == 0);
+        CHECK(g.get_memory_high_water() == two.total());
+
+        // availability lists only exist while a genome is being built
+        emp::Random random;
+        string child = g.modify_org(random, "12345678");
+        CHECK(g.memory_usage().available == 0);
+        CHECK(g.memory_usage().adjacency == kmer_bytes * g.edge_count());
+
+        // the high-water mark keeps the peak until it is reset for the next generation
+        g.remove_sequence("12345000");
+        g.remove_sequence(child);
+        CHECK(g.get_memory_high_water() >= two.total());
+        g.reset_memory_high_water();
+        CHECK(g.get_memory_high_water() == g.memory_usage().total());
+        CHECK(g.get_memory_high_water() < two.total());
+
+        // the start and branch lists are counted by what they hold, not by how far they once grew
+        DeBruijnGraph direct, regrown;
+        direct.add_sequence("12345678");
+        regrown.add_sequence("12345678");
+        regrown.add_sequence("12345000");
+        regrown.add_sequence("99999999");
+        regrown.remove_sequence("12345000");
+        regrown.remove_sequence("99999999");
+        CHECK(regrown.memory_usage().starts == direct.memory_usage().starts);
+        CHECK(regrown.memory_usage().branch_index == direct.memory_usage().branch_index);
+    }
+}
+
+namespace {
+    /// Everything the public API reports about a graph: its contents, plus the order of each adjacency list and
+    /// what that order decides (the traversal and the CSV)
+    template <typename GraphT>
+    vector<string> observe(GraphT & g){
+        vector<string> seen = graph_contents(g);
+        for(auto const & vertex : g.get_all_vertices()){
+            string line = "order " + vertex + ":";
+            for(auto const & adj : g.get_value(vertex).get_adj_list()){
+                line += adj + ",";
+            }
+            seen.push_back(line);
+        }
+        g.depth_first_traversal([&seen] (string vertex) { seen.push_back("visit " + vertex); });
+        std::stringstream csv;
+        g.write_csv(csv, "7");
+        vector<string> rows;
+        for(string row; std::getline(csv, row); ){
+            rows.push_back(row);
+        }
+        std::sort(rows.begin(), rows.end());
+        seen.insert(seen.end(), rows.begin(), rows.end());
+        return seen;
+    }
+
+    /// Run the same births, deaths and crossovers on the ordered-map reference graph and on another backend
+    template <typename StoreT>
+    void check_backend_conforms(){
+        BasicDeBruijnGraph<OrderedVertexStore> reference;
+        BasicDeBruijnGraph<StoreT> g;
+        emp::Random genomes(11);
+        vector<string> population;
+        for(int i = 0; i < 40; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += genomes.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            reference.add_sequence(genome);
+            g.add_sequence(genome);
+        }
+        CHECK(observe(g) == observe(reference));
+
+        emp::Random reference_random(4), random(4);
+        for(int i = 0; i < 20; ++i){
+            string reference_child = reference.modify_org(reference_random, population[i]);
+            string child = g.modify_org(random, population[i]);
+            CHECK(child == reference_child);
+            CHECK(g.is_valid(child));
+            population[i] = child;
+        }
+        for(int i = 20; i < 30; ++i){
+            reference.remove_sequence(population[i]);
+            g.remove_sequence(population[i]);
+            CHECK(g.is_valid(population[i]) == reference.is_valid(population[i]));
+        }
+        CHECK(observe(g) == observe(reference));
+
+        // the in-place accessors read the same vertices as the copying getters
+        for(auto const & vertex : reference.get_all_vertices()){
+            const DBGraphValue * value = g.find_value(vertex);
+            REQUIRE(value != nullptr);
+            CHECK(value == &g.value_of(vertex));
+            CHECK(g.adjacencies(vertex) == g.get_value(vertex).get_adj_list());
+            CHECK(value->get_kmer_occurrences() == reference.value_of(vertex).get_kmer_occurrences());
+        }
+        CHECK(g.start_vertices() == reference.get_start_vertices());
+        CHECK(g.branch_vertices() == reference.get_branch_vertices());
+
+        // converting to and from the backend keeps the graph intact
+        BasicDeBruijnGraph<OrderedVertexStore> round_trip(g);
+        CHECK(observe(round_trip) == observe(reference));
+    }
+}
+
+TEST_CASE("DeBruijnGraph__storage-backends", "[DeBruijnGraph.hpp]")
+{
+    {
+        check_backend_conforms<OrderedVertexStore>();
+        check_backend_conforms<CowVertexStore>();
+        check_backend_conforms<FlatHashVertexStore>();
+        check_backend_conforms<PackedKeyVertexStore>();
+
+        // a frozen graph answers every read query but refuses changes
+        DeBruijnGraph g;
+        g.add_sequence("12345678");
+        g.add_sequence("12345000");
+        g.add_sequence("99945000");
+        BasicDeBruijnGraph<FrozenVertexStore> frozen(g);
+        CHECK(observe(frozen) == observe(g));
+        CHECK(frozen.is_valid("99945000"));
+        CHECK_THROWS_AS(frozen.add_sequence("12399999"), std::logic_error);
+        CHECK_THROWS_AS(frozen.remove_sequence("12345678"), std::logic_error);
+        emp::Random random;
+        CHECK_THROWS_AS(frozen.modify_org(random, "12345678"), std::logic_error);
+        CHECK(observe(frozen) == observe(g));
+
+        // packed keys only hold short k-mers, and a graph whose k is too long refuses before changing anything
+        BasicDeBruijnGraph<PackedKeyVertexStore> long_kmers(9);
+        CHECK_THROWS_AS(long_kmers.add_sequence("123456789012"), std::length_error);
+        CHECK_THROWS_AS(long_kmers.add_sequences({"123456789012", "000000000000"}), std::length_error);
+        CHECK(long_kmers.get_sequence_size() == 0);
+        CHECK(long_kmers.get_sequence_length() == 0);
+        CHECK(long_kmers.get_size() == 0);
+        CHECK(!long_kmers.contains_genome("123456789012"));
+        CHECK_THROWS_AS(BasicDeBruijnGraph<PackedKeyVertexStore>("123456789012", 9), std::length_error);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__bit-and-integer-genomes", "[DeBruijnGraph.hpp]")
+{
+    {
+        // 100-bit genomes, so the packed form spans two words
+        vector<string> genomes = {
+            "1100010101110001101101101000010000001000101100011011001110101001111001101011101101011000111110110011",
+            "1010110110001010000011000111000101101101100101010001101111000111001000011010101111010110110000001010",
+            "1101011111110101101010010011110101001011010101100011000000001011111110110101100110110111010101010111"};
+        DeBruijnGraph from_strings, from_bools, from_words, from_ints;
+        for(auto const & genome : genomes){
+            vector<bool> bools;
+            vector<uint64_t> words(2, 0);
+            vector<int> ints;
+            for(size_t i = 0; i < genome.size(); ++i){
+                bools.push_back(genome[i] == '1');
+                words[i / 64] |= uint64_t(genome[i] == '1') << (i % 64);
+                ints.push_back(genome[i] - '0');
+            }
+            from_strings.add_sequence(genome);
+            from_bools.add_sequence(bools);
+            from_words.add_sequence(words.data(), genome.size());
+            from_ints.add_sequence(ints);
+        }
+        CHECK(observe(from_bools) == observe(from_strings));
+        CHECK(observe(from_words) == observe(from_strings));
+        CHECK(observe(from_ints) == observe(from_strings));
+        CHECK(from_ints.get_sequence_length() == 100);
+
+        // integer and piecewise genomes are read in full, not just their first k-mer
+        DeBruijnGraph digits, pieces;
+        digits.add_sequence(vector<int>{1, 2, 3, 4, 5, 6, 7, 8});
+        pieces.add_sequence(vector<string>{"123", "45", "678"});
+        CHECK(digits.is_valid("12345678"));
+        CHECK(digits.get_size() == 6);
+        CHECK(observe(pieces) == observe(digits));
+        CHECK_THROWS_AS(digits.add_sequence(vector<int>{1, 2, 30}), std::invalid_argument);
+        CHECK(digits.get_sequence_size() == 1);
+
+        // the integer constructor goes through the same path, so it builds the same graph and rejects the same input
+        DeBruijnGraph constructed(vector<int>{1, 2, 3, 4, 5, 6, 7, 8}, 3);
+        CHECK(observe(constructed) == observe(digits));
+        CHECK_THROWS_AS(DeBruijnGraph(vector<int>{1, 2, 30}, 3), std::invalid_argument);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__packed-genome-validity-and-removal", "[DeBruijnGraph.hpp]")
+{
+    {
+        vector<string> genomes = {
+            "1100010101110001101101101000010000001000101100011011001110101001111001101011101101011000111110110011",
+            "1010110110001010000011000111000101101101100101010001101111000111001000011010101111010110110000001010"};
+        vector<vector<uint64_t>> packed;
+        for(auto const & genome : genomes){
+            vector<uint64_t> words(2, 0);
+            for(size_t i = 0; i < genome.size(); ++i){
+                words[i / 64] |= uint64_t(genome[i] == '1') << (i % 64);
+            }
+            packed.push_back(words);
+        }
+        // k = 3 goes through the KmerKernel codes, k = 70 through the bit-by-bit fallback
+        for(int k : {3, 70}){
+            DeBruijnGraph from_strings(k), from_words(k);
+            for(size_t g = 0; g < genomes.size(); ++g){
+                from_strings.add_sequence(genomes[g]);
+                from_words.add_sequence(packed[g].data(), 100);
+                CHECK(from_words.is_valid(packed[g].data(), 100));
+            }
+            CHECK(observe(from_words) == observe(from_strings));
+
+            vector<uint64_t> flipped = packed[0];
+            flipped[0] ^= uint64_t(1) << 40;
+            CHECK(from_words.is_valid(flipped.data(), 100) == from_strings.is_valid(string(genomes[0]).replace(40, 1, "0")));
+
+            from_words.remove_sequence(packed[0].data(), 100);
+            from_strings.remove_sequence(genomes[0]);
+            CHECK(observe(from_words) == observe(from_strings));
+            CHECK(from_words.get_sequence_size() == 1);
+        }
+    }
+}
+
+TEST_CASE("DeBruijnGraph__batched-removal", "[DeBruijnGraph.hpp]")
+{
+    {
+        // an edge is removed once no sequence uses it, even if both of its vertices are still used elsewhere
+        DeBruijnGraph g;
+        g.add_sequence("1234");
+        g.add_sequence("5123");
+        g.add_sequence("2346");
+        CHECK(g.get_value("123").get_edge_count("234") == 1);
+        g.remove_sequence("1234");
+        CHECK(!g.get_value("123").valid_adj("234"));
+        CHECK(g.get_value("123").get_kmer_occurrences() == 1);
+        CHECK(g.get_value("234").get_kmer_occurrences() == 1);
+        CHECK(g.remove_sequences({"99999"}) == 0);
+        CHECK(g.get_sequence_size() == 2);
+
+        // a generation's deaths removed in one batch match removing them one at a time
+        emp::Random genomes(21);
+        vector<string> population;
+        DeBruijnGraph one_at_a_time, batched;
+        for(int i = 0; i < 60; ++i){
+            string genome;
+            for(int j = 0; j < 50; ++j){
+                genome += genomes.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            one_at_a_time.add_sequence(genome);
+            batched.add_sequence(genome);
+        }
+        population.push_back(population[3]); // the same genome twice
+        one_at_a_time.add_sequence(population[3]);
+        batched.add_sequence(population[3]);
+
+        vector<string> dying;
+        for(size_t i = 0; i < population.size(); i += 3){
+            dying.push_back(population[i]);
+        }
+        for(auto const & genome : dying){
+            one_at_a_time.remove_sequence(genome);
+        }
+        CHECK(batched.remove_sequences(dying) == int(dying.size()));
+        CHECK(observe(batched) == observe(one_at_a_time));
+        CHECK(batched.memory_usage().total() == one_at_a_time.memory_usage().total());
+        for(size_t i = 0; i < population.size(); ++i){
+            if(i % 3 != 0 && i != 3){
+                CHECK(batched.is_valid(population[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("DeBruijnGraph__differential-update", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph g;
+        g.add_sequence("12345678");
+        g.add_sequence("12345000");
+        g.update_sequence("12345678", "12349678");
+        CHECK(!g.is_valid("12345678"));
+        CHECK(g.is_valid("12349678"));
+        CHECK(g.get_sequence_size() == 2);
+        vector<string> vertices = g.get_all_vertices();
+        CHECK(std::find(vertices.begin(), vertices.end(), "456") == vertices.end());
+        CHECK(g.get_value("234").get_kmer_occurrences() == 2);
+        CHECK(g.get_value("234").get_edge_count("349") == 1);
+        CHECK(g.get_value("234").get_edge_count("345") == 1);
+        CHECK(g.get_value("678").get_endpoint() == 1);
+        // a sequence that is not in the graph is left alone and the new one is just added
+        g.update_sequence("99999999", "12345000");
+        CHECK(g.get_sequence_size() == 3);
+        CHECK(g.get_value("000").get_endpoint() == 2);
+
+        // point mutations, insertions and deletions match removing the parent and adding the child
+        emp::Random random(8);
+        vector<string> population;
+        DeBruijnGraph updated, replaced;
+        for(int i = 0; i < 40; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            updated.add_sequence(genome);
+            replaced.add_sequence(genome);
+        }
+        for(int generation = 0; generation < 200; ++generation){
+            size_t i = random.GetUInt(population.size());
+            string child = population[i];
+            int kind = random.GetUInt(4);
+            if(kind == 0){
+                child.insert(child.begin() + random.GetUInt(child.size()), '1');
+            }
+            else if(kind == 1 && child.size() > 5){
+                child.erase(random.GetUInt(child.size()), 1);
+            }
+            else {
+                for(int mutations = random.GetUInt(1, 4); mutations > 0; --mutations){
+                    size_t site = random.GetUInt(child.size());
+                    child[site] = child[site] == '0' ? '1' : '0';
+                }
+            }
+            updated.update_sequence(population[i], child);
+            replaced.remove_sequence(population[i]);
+            replaced.add_sequence(child);
+            population[i] = child;
+        }
+        CHECK(observe(updated) == observe(replaced));
+        CHECK(updated.memory_usage().total() == replaced.memory_usage().total());
+        for(auto const & genome : population){
+            CHECK(updated.is_valid(genome));
+        }
+    }
+}
+
+TEST_CASE("DeBruijnGraph__differential-update-starts", "[DeBruijnGraph.hpp]")
+{
+    {
+        // a new first k-mer that only the old genome had, and a start that is only left inside other genomes
+        DeBruijnGraph updated, replaced;
+        for(auto const & genome : {"1101100011", "1100001010"}){
+            updated.add_sequence(genome);
+            replaced.add_sequence(genome);
+        }
+        updated.update_sequence("1101100011", "0111100011");
+        replaced.remove_sequence("1101100011");
+        replaced.add_sequence("0111100011");
+        CHECK(updated.get_start_vertices() == replaced.get_start_vertices());
+        CHECK(updated.get_start_vertices() == vector<string>{"110", "011"});
+
+        DeBruijnGraph updated_k4(4), replaced_k4(4);
+        updated_k4.add_sequence("0001011000011110101");
+        replaced_k4.add_sequence("0001011000011110101");
+        updated_k4.update_sequence("0001011000011110101", "0011011000010110101");
+        replaced_k4.remove_sequence("0001011000011110101");
+        replaced_k4.add_sequence("0011011000010110101");
+        CHECK(updated_k4.get_start_vertices() == replaced_k4.get_start_vertices());
+        CHECK(updated_k4.get_start_vertices() == vector<string>{"0011"});
+
+        // short genomes mutated anywhere, start included, keep the start list of remove + add at every step
+        // (several seeds, so vertices emptied or recreated by the update turn up in every role)
+        for(int seed = 35; seed < 45; ++seed){
+            for(int kmer_length = 3; kmer_length <= 5; ++kmer_length){
+                emp::Random random(seed * 10 + kmer_length);
+                DeBruijnGraph update_graph(kmer_length), replace_graph(kmer_length);
+                vector<string> population;
+                for(int i = 0; i < 12; ++i){
+                    string genome;
+                    for(int j = 0; j < 12; ++j){
+                        genome += random.P(0.5) ? '1' : '0';
+                    }
+                    population.push_back(genome);
+                    update_graph.add_sequence(genome);
+                    replace_graph.add_sequence(genome);
+                }
+                for(int generation = 0; generation < 300; ++generation){
+                    size_t i = random.GetUInt(population.size());
+                    string child = population[i];
+                    for(int mutations = random.GetUInt(1, 4); mutations > 0; --mutations){
+                        size_t site = random.GetUInt(std::min<size_t>(child.size(), kmer_length + 2));
+                        child[site] = child[site] == '0' ? '1' : '0';
+                    }
+                    if(child.size() > 1 && random.P(0.2)){
+                        child.erase(random.GetUInt(child.size()), 1);
+                    }
+                    update_graph.update_sequence(population[i], child);
+                    replace_graph.remove_sequence(population[i]);
+                    replace_graph.add_sequence(child);
+                    population[i] = child;
+                    REQUIRE(update_graph.get_start_vertices() == replace_graph.get_start_vertices());
+                }
+                CHECK(observe(update_graph) == observe(replace_graph));
+            }
+        }
+    }
+}
+
+TEST_CASE("DeBruijnGraph__reproducible-sampling", "[DeBruijnGraph.hpp]")
+{
+    {
+        emp::Random genomes(13);
+        vector<string> population;
+        DeBruijnGraph g;
+        for(int i = 0; i < 30; ++i){
+            string genome;
+            for(int j = 0; j < 40; ++j){
+                genome += genomes.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            g.add_sequence(genome);
+        }
+        vector<string> before = observe(g);
+
+        // each organism's child depends only on (seed, generation, organism id), not on the order they are sampled in
+        const DeBruijnGraph & view = g;
+        vector<string> forward(population.size()), backward(population.size());
+        for(size_t i = 0; i < population.size(); ++i){
+            CounterRandom random(99, 5, i);
+            forward[i] = view.sample_path(random, population[i]);
+        }
+        for(size_t i = population.size(); i-- > 0; ){
+            CounterRandom random(99, 5, i);
+            backward[i] = view.sample_path(random, population[i], 1, true, false);
+        }
+        CHECK(forward == backward);
+        for(auto const & child : forward){
+            CHECK(int(child.size()) == g.get_sequence_length());
+            CHECK(g.is_valid(child));
+        }
+        // sampling never changes the graph
+        CHECK(observe(g) == before);
+
+        // modify_org makes the same child and then puts it in place of the parent
+        CounterRandom random(99, 5, 0);
+        CHECK(g.modify_org(random, population[0]) == forward[0]);
+        CHECK(g.is_valid(forward[0]));
+        CHECK(g.get_sequence_size() == 30);
+        CHECK_THROWS_AS(view.sample_path(random, "22222"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__any-random-engine", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph g;
+        g.add_sequence("0000110110");
+        g.add_sequence("0001110100");
+        g.add_sequence("0000111000");
+
+        // a standard engine is wrapped in a BufferedRandom for the call, so both give the same child
+        Xoshiro256 engine(17), copy(17);
+        BufferedRandom<Xoshiro256> buffered(copy);
+        string child = g.sample_path(engine, "0000110110");
+        CHECK(child == g.sample_path(buffered, "0000110110"));
+        CHECK(g.is_valid(child));
+
+        std::mt19937_64 standard(2);
+        for(int i = 0; i < 20; ++i){
+            CHECK(g.is_valid(g.sample_path(standard, "0001110100")));
+        }
+        string replaced = g.modify_org(engine, "0000111000");
+        CHECK(g.is_valid(replaced));
+        CHECK(g.get_sequence_size() == 3);
+        CHECK(int(g.next_genome_logic(engine, "000").size()) == g.get_sequence_length());
+
+        // every successor of a branch can be taken, and each step adds the last character of a k-mer of any length
+        DeBruijnGraph branching(4);
+        branching.add_sequence("00011");
+        branching.add_sequence("00010");
+        std::set<string> children;
+        for(int i = 0; i < 40; ++i){
+            children.insert(branching.next_genome_logic(engine, "0001"));
+        }
+        CHECK(children == std::set<string>{"00010", "00011"});
+    }
+}
+
+namespace {
+    /// Recompute the statistics by scanning every vertex, to check the ones the graph keeps
+    template <typename GraphT>
+    void check_statistics(const GraphT & g){
+        DeBruijnStatistics scanned;
+        for(auto const & vertex : g.get_all_vertices()){
+            DBGraphValue value = g.get_value(vertex);
+            int degree = value.adj_list_size();
+            int occurrences = value.get_kmer_occurrences();
+            if(size_t(degree) >= scanned.out_degree_histogram.size()){
+                scanned.out_degree_histogram.resize(degree + 1, 0);
+            }
+            scanned.out_degree_histogram[degree]++;
+            scanned.vertices++;
+            scanned.edges += degree;
+            scanned.branch_vertices += degree > 1;
+            scanned.endpoints += value.get_endpoint();
+            scanned.endpoint_vertices += value.get_endpoint() > 0;
+            scanned.total_occurrences += occurrences;
+            scanned.singleton_kmers += occurrences == 1;
+            if(occurrences > 1){
+                scanned.occurrence_log_sum += occurrences * std::log2(double(occurrences));
+            }
+        }
+        const DeBruijnStatistics & kept = g.statistics();
+        CHECK(kept.vertices == scanned.vertices);
+        CHECK(kept.vertices == g.get_size());
+        CHECK(kept.edges == scanned.edges);
+        CHECK(kept.branch_vertices == scanned.branch_vertices);
+        CHECK(kept.endpoints == scanned.endpoints);
+        CHECK(kept.endpoint_vertices == scanned.endpoint_vertices);
+        CHECK(kept.total_occurrences == scanned.total_occurrences);
+        CHECK(kept.singleton_kmers == scanned.singleton_kmers);
+        CHECK(kept.kmer_entropy() == Approx(scanned.kmer_entropy()).margin(1e-9));
+        vector<long long> histogram = kept.out_degree_histogram;
+        histogram.resize(std::max(histogram.size(), scanned.out_degree_histogram.size()), 0);
+        scanned.out_degree_histogram.resize(histogram.size(), 0);
+        CHECK(histogram == scanned.out_degree_histogram);
+        // the branch index holds each branch point exactly once
+        CHECK(kept.branch_vertices == (long long)(g.get_branch_vertices().size()));
+        for(auto const & branch : g.branch_vertices()){
+            CHECK(g.vertex_branch_check(branch));
+        }
+    }
+}
+
+TEST_CASE("DeBruijnGraph__statistics", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph g;
+        CHECK(g.statistics().vertices == 0);
+        CHECK(g.statistics().kmer_entropy() == 0);
+        g.add_sequence("12345678");
+        g.add_sequence("12345000");
+        const DeBruijnStatistics & stats = g.statistics();
+        CHECK(stats.vertices == 9);
+        CHECK(stats.edges == 8);
+        CHECK(stats.branch_vertices == 1);
+        CHECK(stats.out_degree_histogram[2] == 1);
+        CHECK(stats.endpoints == 2);
+        CHECK(stats.endpoint_vertices == 2);
+        CHECK(stats.total_occurrences == 12);
+        CHECK(stats.singleton_kmers == 6);
+        check_statistics(g);
+
+        // reads never add vertices, so the size does not drift
+        CHECK(!g.vertex_branch_check("999"));
+        CHECK(g.get_value("999").get_kmer_occurrences() == 0);
+        CHECK(!g.is_valid("99999"));
+        CHECK(g.get_size() == 9);
+
+        // a vertex that loses its second successor is no longer a branch point
+        g.remove_sequence("12345678");
+        CHECK(!g.vertex_branch_check("345"));
+        CHECK(g.get_branch_vertices().empty());
+        check_statistics(g);
+
+        DeBruijnGraph constructed("0120120120", 3);
+        check_statistics(constructed);
+
+        // the statistics stay exact through births, deaths, crossovers and batched deaths
+        emp::Random random(31);
+        vector<string> population;
+        DeBruijnGraph pangenome;
+        for(int i = 0; i < 50; ++i){
+            string genome;
+            for(int j = 0; j < 40; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            pangenome.add_sequence(genome);
+        }
+        check_statistics(pangenome);
+        CHECK(pangenome.statistics().kmer_entropy() > 0);
+        CHECK(pangenome.statistics().mean_out_degree() > 1);
+        for(int i = 0; i < 20; ++i){
+            population[i] = pangenome.modify_org(random, population[i]);
+        }
+        check_statistics(pangenome);
+        vector<string> dying(population.begin() + 30, population.end());
+        pangenome.remove_sequences(dying);
+        check_statistics(pangenome);
+        DeBruijnGraph copy = pangenome;
+        copy.remove_sequence(population[0]);
+        check_statistics(copy);
+        check_statistics(pangenome);
+        BasicDeBruijnGraph<FlatHashVertexStore> hashed(pangenome);
+        check_statistics(hashed);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__registered-sequences", "[DeBruijnGraph.hpp]")
+{
+    {
+        // removing by handle matches removing by string
+        emp::Random random(31);
+        DeBruijnGraph by_handle, by_string;
+        vector<string> genomes;
+        vector<SequenceHandle> handles;
+        for(int i = 0; i < 40; ++i){
+            string genome;
+            for(int j = 0; j < 30; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            genomes.push_back(genome);
+            handles.push_back(by_handle.register_sequence(genome));
+            by_string.add_sequence(genome);
+        }
+        handles.push_back(by_handle.register_sequence("01"));   // shorter than k
+        by_string.add_sequence("01");
+        CHECK(by_handle.registered_count() == 41);
+        CHECK(by_handle.get_sequence(handles[7]) == genomes[7]);
+        CHECK(by_handle.memory_usage().paths > 0);
+
+        for(size_t i = 0; i < genomes.size(); i += 2){
+            CHECK(by_handle.remove_sequence(handles[i]));
+            by_string.remove_sequence(genomes[i]);
+        }
+        CHECK(by_handle.remove_sequence(handles.back()));
+        by_string.remove_sequence("01");
+        CHECK(!by_handle.remove_sequence(handles[0]));      // already removed
+        CHECK(!by_handle.remove_sequence(SequenceHandle()));
+        CHECK(by_handle.registered_count() == 20);
+        check_statistics(by_handle);
+        CHECK(observe(by_handle) == observe(by_string));
+
+        // freed handles are reused, and the remaining paths survive
+        SequenceHandle reused = by_handle.register_sequence(genomes[0]);
+        CHECK(reused.valid());
+        CHECK(by_handle.get_sequence(reused) == genomes[0]);
+        for(size_t i = 1; i < genomes.size(); i += 2){
+            CHECK(by_handle.get_sequence(handles[i]) == genomes[i]);
+        }
+        CHECK_THROWS_AS(by_handle.get_sequence(handles[2]), std::out_of_range);
+
+        // a copy shares the paths until one side registers or removes, and neither sees the other's change
+        DeBruijnGraph copy(by_handle);
+        CHECK(copy.remove_sequence(handles[1]));
+        CHECK(copy.registered_count() == 20);
+        CHECK(by_handle.registered_count() == 21);
+        CHECK(by_handle.get_sequence(handles[1]) == genomes[1]);
+        SequenceHandle added = by_handle.register_sequence(genomes[2]);
+        CHECK(by_handle.registered_count() == 22);
+        CHECK(copy.registered_count() == 20);
+        CHECK(by_handle.get_sequence(added) == genomes[2]);
+        CHECK_THROWS_AS(copy.get_sequence(handles[1]), std::out_of_range);
+        CHECK(by_handle.remove_sequence(handles[1]));
+        CHECK(by_handle.remove_sequence(handles[3]));
+        CHECK(copy.get_sequence(handles[3]) == genomes[3]);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__prefilter", "[DeBruijnGraph.hpp]")
+{
+    {
+        // a filtered graph answers every query the way an unfiltered one does
+        emp::Random random(45);
+        DeBruijnGraph filtered(10), plain(10);
+        filtered.enable_prefilter(4000, 0.01);
+        vector<string> parents;
+        for(int i = 0; i < 20; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            parents.push_back(genome);
+            filtered.add_sequence(genome);
+            plain.add_sequence(genome);
+        }
+        auto keys = [] (const DeBruijnGraph & g) { return size_t(g.statistics().vertices + g.statistics().edges); };
+        CHECK(filtered.prefilter().size() == keys(filtered));
+        CHECK(filtered.memory_usage().prefilter > 0);
+
+        // offspring with a few point mutations, most of them novel
+        auto check_agreement = [&] () {
+            for(int i = 0; i < 200; ++i){
+                string child = parents[random.GetUInt(parents.size())];
+                for(int m = random.GetUInt(4); m > 0; --m){
+                    size_t site = random.GetUInt(child.size());
+                    child[site] = child[site] == '0' ? '1' : '0';
+                }
+                CHECK(filtered.is_valid(child) == plain.is_valid(child));
+                string kmer = child.substr(random.GetUInt(child.size() - 10), 10);
+                CHECK(filtered.contains(kmer) == (plain.find_value(kmer) != nullptr));
+            }
+        };
+        check_agreement();
+        CHECK(filtered.prefilter().rejected() > 0);
+        CHECK(filtered.prefilter().measured_false_positive_rate() < 0.2);
+
+        // the filter follows removals, one at a time and in a batch
+        for(int i = 0; i < 5; ++i){
+            filtered.remove_sequence(parents[i]);
+            plain.remove_sequence(parents[i]);
+        }
+        vector<string> batch(parents.begin() + 5, parents.begin() + 10);
+        filtered.remove_sequences(batch);
+        plain.remove_sequences(batch);
+        CHECK(filtered.prefilter().size() == keys(filtered));
+        check_agreement();
+        CHECK(!filtered.is_valid(parents[2]));
+        CHECK(filtered.is_valid(parents[12]));
+
+        // enabling on a populated graph, and turning it off again
+        plain.enable_prefilter();
+        CHECK(plain.prefilter().size() == keys(plain));
+        check_agreement();
+        plain.disable_prefilter();
+        CHECK(!plain.prefilter().enabled());
+        CHECK(plain.memory_usage().prefilter == 0);
+
+        for(size_t i = 10; i < parents.size(); ++i){
+            filtered.remove_sequence(parents[i]);
+        }
+        CHECK(filtered.get_size() == 0);
+        CHECK(filtered.prefilter().size() == 0);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__duplicate-genomes", "[DeBruijnGraph.hpp]")
+{
+    {
+        // a genome whose path is in the graph is not necessarily a genome in the graph
+        DeBruijnGraph g;
+        g.add_sequence("000111");
+        g.add_sequence("111000");
+        CHECK(g.is_valid("000111000"));
+        CHECK(!g.contains_genome("000111000"));
+        CHECK(g.contains_genome("000111"));
+        CHECK(g.contains_genome(FingerprintBuilder::of("111000")));
+        CHECK(!g.contains_genome("00011"));
+
+        // copies are counted, and every way in and out of the graph keeps the count
+        g.add_sequence("000111");
+        CHECK(g.genome_count("000111") == 2);
+        CHECK(g.distinct_genomes() == 2);
+        g.remove_sequence("000111");
+        CHECK(g.genome_count("000111") == 1);
+
+        // the genome a graph is constructed from is in it like any added genome
+        DeBruijnGraph from_string("0110100", 3), from_ints(vector<int>{2, 0, 4, 1}, 2);
+        CHECK(from_string.contains_genome("0110100"));
+        CHECK(from_ints.genome_count("2041") == 1);
+        from_string.remove_sequence("0110100");
+        CHECK(!from_string.contains_genome("0110100"));
+        CHECK(from_string.distinct_genomes() == 0);
+
+        uint64_t packed = 0b110110;     // "011011", bit i is character i
+        g.add_sequence(&packed, 6);
+        CHECK(g.contains_genome("011011"));
+        CHECK(g.contains_genome(&packed, 6));
+
+        g.add_sequences({"0101", "0101", "11"});
+        CHECK(g.genome_count("0101") == 2);
+        CHECK(g.contains_genome("11"));
+
+        SequenceHandle handle = g.register_sequence("001100");
+        CHECK(g.contains_genome("001100"));
+        g.remove_sequence(handle);
+        CHECK(!g.contains_genome("001100"));
+
+        g.update_sequence("111000", "111001");
+        CHECK(!g.contains_genome("111000"));
+        CHECK(g.contains_genome("111001"));
+        // an insertion and a deletion, whose fingerprints are joined from the shared prefix and suffix
+        g.update_sequence("111001", "1110101");
+        CHECK(!g.contains_genome("111001"));
+        CHECK(g.contains_genome("1110101"));
+        g.update_sequence("1110101", "11101");
+        CHECK(g.contains_genome("11101"));
+        g.update_sequence("11101", "111001");
+        CHECK(g.genome_count("111001") == 1);
+        CHECK(!g.contains_genome("11101"));
+
+        CHECK(g.remove_sequences({"0101", "11", "011011"}) == 3);
+        CHECK(g.genome_count("0101") == 1);
+        CHECK(!g.contains_genome("11"));
+        CHECK(!g.contains_genome(&packed, 6));
+        CHECK(g.memory_usage().genomes > 0);
+
+        // the count follows the population through a run of births and deaths
+        emp::Random random(46);
+        DeBruijnGraph population;
+        std::map<string, int> living;
+        vector<string> genomes;
+        for(int i = 0; i < 300; ++i){
+            if(!genomes.empty() && random.P(0.4)){
+                size_t dead = random.GetUInt(genomes.size());
+                population.remove_sequence(genomes[dead]);
+                living[genomes[dead]]--;
+                genomes.erase(genomes.begin() + dead);
+            }
+            else {
+                string genome;
+                for(int j = 0; j < 8; ++j){
+                    genome += random.P(0.8) ? '1' : '0';
+                }
+                population.add_sequence(genome);
+                living[genome]++;
+                genomes.push_back(genome);
+            }
+        }
+        size_t distinct = 0;
+        for(auto const & genome : living){
+            CHECK(population.genome_count(genome.first) == genome.second);
+            distinct += genome.second > 0;
+        }
+        CHECK(population.distinct_genomes() == distinct);
+
+        // a copy shares the fingerprints until one side adds or removes, and neither sees the other's change
+        DeBruijnGraph copy(population);
+        copy.add_sequence("10101010");
+        CHECK(copy.genome_count("10101010") == population.genome_count("10101010") + 1);
+        population.remove_sequence(genomes[0]);
+        CHECK(copy.genome_count(genomes[0]) == living[genomes[0]]);
+        CHECK(population.genome_count(genomes[0]) == living[genomes[0]] - 1);
+    }
+}
+
+TEST_CASE("DeBruijnGraph__in-place-accessors", "[DeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph g;
+        g.add_sequence("0001101");
+        g.add_sequence("0011100");
+        int vertices = g.get_size();
+
+        // string_view keys need not be whole strings, and missing vertices are never inserted
+        string genome = "x0001101";
+        std::string_view view(genome);
+        CHECK(g.contains(view.substr(1, 3)));
+        CHECK(g.find_value(view.substr(2, 3)) == g.find_value("001"));
+        CHECK(g.adjacencies(view.substr(1, 3)) == vector<string>{"001"});
+        CHECK(g.find_value("222") == nullptr);
+        CHECK(g.value_of("222").adj_list_size() == 0);
+        CHECK(g.adjacencies("222").empty());
+        CHECK(!g.vertex_branch_check("222"));
+        CHECK(g.get_value("222").get_kmer_occurrences() == 0);
+        CHECK(g.get_size() == vertices);
+
+        // references stay put and follow the graph while it is not changed behind them
+        const vector<string> & starts = g.start_vertices();
+        CHECK(&starts == &g.start_vertices());
+        CHECK(starts == g.get_start_vertices());
+        CHECK(g.branch_vertices() == g.get_branch_vertices());
+        const DBGraphValue & value = g.value_of("011");
+        CHECK(&value.adjacency(0) == &g.adjacencies("011")[0]);
+        CHECK(value.get_edge_count(view.substr(4, 3)) == g.get_value("011").get_edge_count("110"));
+        CHECK(value.get_edge_count(view.substr(4, 3)) > 0);
+    }
+}
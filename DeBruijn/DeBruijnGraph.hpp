@@ -3,36 +3,138 @@
  * @author Anna Catenacci
  *
  * A class that constructs and describes a DeBruijn Graph
+ *
+ * The vertex container is a storage policy (see VertexStore.hpp), so other containers can be tried
+ * without touching the graph logic. DeBruijnGraph is BasicDeBruijnGraph<CowVertexStore>; a graph can be
+ * converted to another backend with the converting constructor, e.g. to freeze it:
+ *     BasicDeBruijnGraph<FrozenVertexStore> frozen(graph);
+ *
+ * The sampling calls take any random number generator (see RandomPolicy.hpp): emp::Random, CounterRandom,
+ * or a standard engine such as Xoshiro256 or std::mt19937_64.
  */
 
 #ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_DEBRUIJNGRAPH_H
 #define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_DEBRUIJNGRAPH_H
 
-#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
-
 #include "DeBruijnValue.hpp"
+#include "VertexStore.hpp"
+#include "KmerKernel.hpp"
+#include "RandomPolicy.hpp"
+#include "PathStore.hpp"
+#include "BloomFilter.hpp"
+#include "GenomeFingerprint.hpp"
+#include "GraphTraversal.hpp"
+#include "ComponentIndex.hpp"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <fstream>
 #include <functional>
 #include <tuple>
+#include <utility>
+#include <cstdint>
+#include <cmath>
+#include <memory>
 
 using std::string; using std::vector; using std::map;
 using std::cout; using std::endl; using std::tuple;
 
-class DeBruijnGraph {
+/**
+ * Estimated memory held by a DeBruijnGraph, in bytes, broken down by what it is used for.
+ * Computed from counters the graph keeps up to date, so it is cheap enough to log every generation.
+ * Vectors are counted at their size rather than their capacity, so treat this as a lower bound,
+ * and vertex chunks shared with a copy-on-write clone are counted by both graphs.
+ */
+struct DeBruijnMemoryUsage {
+    /// k-mer strings used as vertex IDs
+    size_t vertex_keys = 0;
+    /// DBGraphValue objects themselves (flags, counts and empty container headers)
+    size_t vertex_values = 0;
+    /// Strings stored in adjacency lists
+    size_t adjacency = 0;
+    /// Strings stored in available-adjacency lists (only non-zero after set_avail_adj_list)
+    size_t available = 0;
+    /// Entries of the per-vertex edge-count maps
+    size_t edge_counts = 0;
+    /// Start vertex list
+    size_t starts = 0;
+    /// Branch vertex list and the index of their positions in it
+    size_t branch_index = 0;
+    /// Bookkeeping of the vertex store (tree nodes, chunks or hash slots)
+    size_t store_overhead = 0;
+    /// Estimated malloc headers for every separate allocation above
+    size_t allocator_overhead = 0;
+    /// Paths of registered sequences (see register_sequence)
+    size_t paths = 0;
+    /// Counters of the membership prefilter (only non-zero after enable_prefilter)
+    size_t prefilter = 0;
+    /// Fingerprints of the genomes in the graph (see contains_genome)
+    size_t genomes = 0;
+
+    /**
+     * @return sum of every category
+     */
+    size_t total() const {
+        return vertex_keys + vertex_values + adjacency + available + edge_counts + starts + branch_index
+            + store_overhead + allocator_overhead + paths + prefilter + genomes;
+    }
+};
+
+/**
+ * Summary statistics of a DeBruijnGraph. The graph updates them whenever a vertex changes, so reading them
+ * is O(1) and they can be logged every generation without scanning the graph.
+ */
+struct DeBruijnStatistics {
+    /// Number of vertices
+    long long vertices = 0;
+    /// Number of edges (adjacency list entries)
+    long long edges = 0;
+    /// Vertices with more than one successor
+    long long branch_vertices = 0;
+    /// Times a sequence ends at a vertex, summed over all vertices
+    long long endpoints = 0;
+    /// Vertices at least one sequence ends at
+    long long endpoint_vertices = 0;
+    /// K-mer occurrences summed over all vertices
+    long long total_occurrences = 0;
+    /// K-mers that occur exactly once in the pangenome
+    long long singleton_kmers = 0;
+    /// Sum of c * log2(c) over each vertex's occurrence count c (kept for kmer_entropy())
+    double occurrence_log_sum = 0;
+    /// out_degree_histogram[d] is the number of vertices with d successors
+    vector<long long> out_degree_histogram;
+
+    /**
+     * @return Shannon entropy, in bits, of the k-mer frequency distribution (0 for an empty graph)
+     */
+    double kmer_entropy() const {
+        if(total_occurrences <= 0){
+            return 0;
+        }
+        double entropy = std::log2(double(total_occurrences)) - occurrence_log_sum / total_occurrences;
+        return entropy > 0 ? entropy : 0;
+    }
+
+    /**
+     * @return average number of successors per vertex
+     */
+    double mean_out_degree() const { return vertices == 0 ? 0 : double(edges) / vertices; }
+};
+
+class MultiKDeBruijnGraph;
+
+template <typename VertexStoreT = CowVertexStore>
+class BasicDeBruijnGraph {
 public:
     using fun_t = void(std::ostream &);
     using fun_f = void(std::ofstream &);
 private:
 
-    /// Number of vertices the graph contains
-    int mSize = 0;
-
     /// Number of sequences added to graph in total
     int mSeqSize = 0;
 
@@ -43,55 +145,442 @@ private:
     int mSequenceLength = 0;
 
     /// Map of Debruijn vertex objects to their values/data
-    map<string, DBGraphValue> mVertices;
+    /// (copy-on-write, so copying the graph shares vertex storage until one copy writes to it)
+    VertexStoreT mVertices;
 
     /// Vector of all Vertices the map contains
     // (will this variable be necessary to keep around if I already have a flag attribute in DBValue?)
     vector<string> mBranchedVertices;
 
+    /// Position of each branch vertex in mBranchedVertices, so one can be taken out without searching the list
+    std::unordered_map<string, size_t> mBranchPositions;
+
     /// Vector of all beginning verticies
     vector<string> mStarts;
 
-    std::ofstream file;
+    /// Number of strings held in all adjacency lists (kept for memory_usage())
+    long long mAdjacencyEntries = 0;
+
+    /// Number of strings held in all available-adjacency lists (kept for memory_usage())
+    long long mAvailableEntries = 0;
+
+    /// Number of entries in all edge-count maps (kept for memory_usage())
+    long long mEdgeCountEntries = 0;
+
+    /// Summary statistics, updated with every change to a vertex
+    DeBruijnStatistics mStats;
+
+    /// Paths of the sequences added with register_sequence, by handle; shared by copies until one of them writes
+    std::shared_ptr<PathStore> mPaths = std::make_shared<PathStore>();
+
+    /// Counting Bloom filter over every vertex and edge, checked before the store (empty unless enable_prefilter)
+    CountingBloomFilter mPrefilter;
+
+    /// Fingerprint of every genome in the graph, with its number of copies; shared by copies until one of them writes
+    std::shared_ptr<GenomeMultiset> mGenomes = std::make_shared<GenomeMultiset>();
+
+    /// Largest memory_usage().total() seen since the last reset_memory_high_water()
+    size_t mMemoryHighWater = 0;
+
+    /// Bumped by every change to a vertex, so caches can tell whether the graph has changed
+    uint64_t mVersion = 0;
+
+    /// Last component index built by components(), shared with the callers that asked for it
+    mutable std::shared_ptr<const ComponentIndex> mComponents;
+
+    /// Bytes assumed for each separate heap allocation's malloc header
+    static constexpr size_t ALLOCATION_HEADER_BYTES = 16;
+
+
+    /**
+     * Read-only view of the vertex store. Iterating through this never duplicates shared storage.
+     * @return const reference to the vertex store
+     */
+    const VertexStoreT & vertices() const { return mVertices; }
+
+    /**
+     * Give this graph its own copy of the path store, if it is shared with a copy of the graph
+     * @return the (now private) path store
+     */
+    PathStore & own_paths(){
+        if(mPaths.use_count() > 1){
+            mPaths = std::make_shared<PathStore>(*mPaths);
+        }
+        return *mPaths;
+    }
+
+    /**
+     * Give this graph its own copy of the genome fingerprints, if they are shared with a copy of the graph
+     * @return the (now private) fingerprint multiset
+     */
+    GenomeMultiset & own_genomes(){
+        if(mGenomes.use_count() > 1){
+            mGenomes = std::make_shared<GenomeMultiset>(*mGenomes);
+        }
+        return *mGenomes;
+    }
+
+    /**
+     * Refuse to change a graph whose vertex store is read-only, or cannot hold k-mers of this length,
+     * before anything is modified
+     * @param caller name of the function, for the error message
+     */
+    void check_writable(const string & caller) const {
+        if(VertexStoreT::READ_ONLY){
+            throw std::logic_error("DeBruijnGraph::" + caller + ": the graph's vertex store is read-only");
+        }
+        if(size_t(mKmerLength) > VertexStoreT::MAX_KMER_LENGTH){
+            throw std::length_error("DeBruijnGraph::" + caller + ": the graph's vertex store cannot hold k-mers of length "
+                                    + std::to_string(mKmerLength));
+        }
+    }
+
+    /**
+     * Symbol used for one element of an integer genome
+     * @param value element (0-9)
+     * @return its digit character
+     */
+    static char int_symbol(int value){
+        if(value < 0 || value > 9){
+            throw std::invalid_argument("DeBruijnGraph::add_sequence: integer genomes must hold one digit (0-9) per element");
+        }
+        return char('0' + value);
+    }
+
+    /**
+     * Number of k-mers a sequence is walked as (a sequence shorter than k is one short "k-mer")
+     * @param length number of characters in the sequence
+     * @return k-mer count
+     */
+    size_t walk_length(size_t length) const {
+        return length > size_t(mKmerLength) ? length - mKmerLength + 1 : 1;
+    }
+
+    /**
+     * Adapt a character accessor to the k-mer accessor the sequence functions below take
+     * @param symbol_at lambda taking a position and returning the character there
+     * @param length number of characters in the sequence
+     * @return lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     */
+    template <typename SymbolFunc>
+    auto symbol_kmers(SymbolFunc symbol_at, size_t length) const {
+        size_t kmer_length = mKmerLength;
+        return [symbol_at, length, kmer_length] (size_t i, string & kmer) {
+            kmer.resize(std::min(kmer_length, length - i));
+            for(size_t j = 0; j < kmer.size(); ++j){
+                kmer[j] = symbol_at(i + j);
+            }
+        };
+    }
+
+    /**
+     * Run a sequence function on a packed bit genome, taking the k-mers from the KmerKernel codes when
+     * they fit in a word and reading bit by bit otherwise
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     * @param body lambda taking (kmer_at, count), e.g. one of the sequence functions below
+     */
+    template <typename FuncType>
+    auto with_packed_kmers(const uint64_t * words, size_t num_bits, FuncType body) const {
+        if(mKmerLength <= KmerKernel::MAX_KMER_LENGTH && num_bits >= size_t(mKmerLength)){
+            vector<uint64_t> codes(KmerKernel::kmer_count(num_bits, mKmerLength));
+            KmerKernel::extract(words, num_bits, mKmerLength, codes.data());
+            int kmer_length = mKmerLength;
+            return body([&codes, kmer_length] (size_t i, string & kmer) { KmerKernel::decode(codes[i], kmer_length, kmer); },
+                        codes.size());
+        }
+        return body(symbol_kmers([words] (size_t i) { return (words[i / 64] >> (i % 64)) & 1 ? '1' : '0'; }, num_bits),
+                    walk_length(num_bits));
+    }
+
+    /**
+     * Add a sequence given k-mer by k-mer, so any genome representation can be added without
+     * first being converted to a string. Each k-mer is built in a reused buffer.
+     * @param kmer_at lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     * @param count number of k-mers (see walk_length)
+     * @param length number of characters in the sequence
+     */
+    template <typename KmerFunc>
+    void add_kmers(KmerFunc kmer_at, size_t count, size_t length){
+        check_writable("add_sequence");
+        mSeqSize += 1;
+        mSequenceLength = length;
+        string current, next;
+        FingerprintBuilder fingerprint;
+        kmer_at(0, current);
+        fingerprint.append(current);
+        // if the beginning string is not in the graph, add a new beginning vertex
+        if(mVertices.count(current) <= 0){
+            mStarts.push_back(current);
+            set_empty_vertex(current);
+        }
+        // go through the entire new sequence and add edges:
+        for(size_t i = 1; i < count; ++i){
+            kmer_at(i, next);
+            fingerprint.append(next.back());
+            add_edge(current, next);
+            update_lists(current, [] (DBGraphValue & value) {
+                value.set_empty_bool(0); //set that we know this adj_list has something in it
+                value.increment_kmer_occurrences(); //increment number of times we've seen this kmer in the pangenome
+            });
+            //if future vertex is not already in map, set it as an empty vertex
+            if(mVertices.count(next) <= 0){
+                set_empty_vertex(next);
+            }
+            current.swap(next); //update our kmer and repeat!
+        }
+        //flag that this node's adj_list as empty only if we haven't seen it before (value of 2)
+        //if it has previously been flagged with a value of 0, we know it has something in the adj_list
+        update_lists(current, [] (DBGraphValue & last) {
+            if(last.get_empty_bool() == 2){
+                last.set_empty_bool(1);
+            }
+            last.increment_endpoint(); //increment number of times this kmer is an endpoint of a seq in the pangenome
+            last.increment_kmer_occurrences(); //increment number of times we've seen this kmer in the pangenome
+        });
+        own_genomes().insert(fingerprint.finish());
+        update_memory_high_water();
+    }
+
+    /**
+     * Remove a sequence given k-mer by k-mer (see add_kmers); does nothing if it is not valid
+     * @param kmer_at lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     * @param count number of k-mers
+     */
+    template <typename KmerFunc>
+    void remove_kmers(KmerFunc kmer_at, size_t count){
+        check_writable("remove_sequence");
+        if(!valid_kmers(kmer_at, count)){
+            return;
+        }
+        decrement_kmers(kmer_at, count);
+    }
+
+    /**
+     * Take a sequence known to be in the graph back out, k-mer by k-mer, without checking it first
+     * @param kmer_at lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     * @param count number of k-mers
+     */
+    template <typename KmerFunc>
+    void decrement_kmers(KmerFunc kmer_at, size_t count){
+        mSeqSize--;
+        string current, next;
+        FingerprintBuilder fingerprint;
+        kmer_at(0, current);
+        fingerprint.append(current);
+        // while we still have sequence left:
+        for(size_t i = 1; i < count; ++i){
+            kmer_at(i, next);
+            fingerprint.append(next.back());
+            //decrement the kmer and the edge; if no other sequence uses the edge, break adj & remove edge from graph
+            update_lists(current, [&] (DBGraphValue & value) {
+                value.decrement_kmer_occurrences();
+                if(value.decrement_edge_count(next) <= 0){
+                    drop_edge(value, current, next);
+                }
+            });
+            //if current kmer was only in 1 seq in the pangenome, delete it from mVerticies
+            if (vertices().find(current)->second.get_kmer_occurrences() <= 0){
+                remove(current);
+            }
+            current.swap(next);
+        }
+        update_lists(current, [] (DBGraphValue & value) {
+            value.decrement_kmer_occurrences();
+            value.decrement_endpoint();
+        });
+        if (vertices().find(current)->second.get_kmer_occurrences() <= 0){
+            remove(current);
+        }
+        own_genomes().erase(fingerprint.finish());
+    }
+
+    /**
+     * Check a sequence given k-mer by k-mer (see add_kmers); like is_valid, the last edge is not checked
+     * @param kmer_at lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     * @param count number of k-mers
+     * @return true if every checked edge is in the graph
+     */
+    template <typename KmerFunc>
+    bool valid_kmers(KmerFunc kmer_at, size_t count) const {
+        if(count < 3){
+            return true;
+        }
+        string current, next;
+        // with the prefilter on, turn away sequences with an edge it has never seen before touching the store
+        if(mPrefilter.enabled()){
+            kmer_at(0, current);
+            for(size_t i = 1; i + 1 < count; ++i){
+                kmer_at(i, next);
+                if(!mPrefilter.may_contain(CountingBloomFilter::edge_hash(current, next.back()))){
+                    return false;
+                }
+                current.swap(next);
+            }
+        }
+        kmer_at(0, current);
+        for(size_t i = 1; i + 1 < count; ++i){
+            kmer_at(i, next);
+            // if the path from this vertex to it's adjacency is invalid, return false
+            auto it = mVertices.find(current);
+            if(it == mVertices.end() || !it->second.valid_adj(next)){
+                if(mPrefilter.enabled()){
+                    mPrefilter.record_false_positive();
+                }
+                return false;
+            }
+            current.swap(next);
+        }
+        return true;
+    }
+
+    /**
+     * Apply a change to a vertex (creating it if needed), keeping the memory counters and statistics in step.
+     * Every change to a vertex's lists or counts goes through here. A vertex left with fewer than two
+     * successors stops being a branch point.
+     * @param kmer vertex to change
+     * @param update lambda taking the vertex's DBGraphValue &
+     */
+    template <typename FuncType>
+    void update_lists(const string & kmer, FuncType update){
+        mVersion++;
+        set_empty_vertex(kmer);
+        DBGraphValue & value = mVertices[kmer];
+        int adj_size = value.adj_list_size();
+        int available_size = value.adj_availible_size();
+        int edge_count_size = value.edge_count_size();
+        count_vertex(value, -1);
+        update(value);
+        count_vertex(value, 1);
+        mAdjacencyEntries += value.adj_list_size() - adj_size;
+        mAvailableEntries += value.adj_availible_size() - available_size;
+        mEdgeCountEntries += value.edge_count_size() - edge_count_size;
+        if(value.get_branch() && value.adj_list_size() < 2){
+            value.set_branch(false);
+            drop_branch(kmer);
+        }
+    }
+
+    /**
+     * Take a vertex out of the branch list in constant time; the last branch vertex moves into its place
+     * @param kmer vertex to take out (nothing happens if it is not listed)
+     */
+    void drop_branch(const string & kmer){
+        auto it = mBranchPositions.find(kmer);
+        if(it == mBranchPositions.end()){
+            return;
+        }
+        size_t position = it->second;
+        mBranchPositions.erase(it);
+        if(position + 1 < mBranchedVertices.size()){
+            mBranchedVertices[position].swap(mBranchedVertices.back());
+            mBranchPositions[mBranchedVertices[position]] = position;
+        }
+        mBranchedVertices.pop_back();
+    }
+
+    /**
+     * Add a vertex's share of the statistics to mStats, or take it away
+     * @param value vertex
+     * @param sign 1 to add, -1 to take away
+     */
+    void count_vertex(const DBGraphValue & value, int sign){
+        int degree = value.adj_list_size();
+        int occurrences = value.get_kmer_occurrences();
+        int endpoint = value.get_endpoint();
+        if(size_t(degree) >= mStats.out_degree_histogram.size()){
+            mStats.out_degree_histogram.resize(degree + 1, 0);
+        }
+        mStats.out_degree_histogram[degree] += sign;
+        mStats.vertices += sign;
+        mStats.edges += sign * degree;
+        mStats.branch_vertices += sign * (degree > 1);
+        mStats.endpoints += sign * endpoint;
+        mStats.endpoint_vertices += sign * (endpoint > 0);
+        mStats.total_occurrences += sign * occurrences;
+        mStats.singleton_kmers += sign * (occurrences == 1);
+        if(occurrences > 1){
+            mStats.occurrence_log_sum += sign * occurrences * std::log2(double(occurrences));
+        }
+    }
 
+    /**
+     * Bytes used by a string of the given length, including its heap buffer if it needs one
+     * @param length number of characters
+     * @return sizeof(string) plus any heap allocation
+     */
+    static size_t string_footprint(int length){
+        string probe(length, '0');
+        const char * inline_begin = reinterpret_cast<const char *>(&probe);
+        bool inline_buffer = probe.data() >= inline_begin && probe.data() < inline_begin + sizeof(string);
+        return sizeof(string) + (inline_buffer ? 0 : probe.capacity() + 1);
+    }
+
+    /**
+     * Raise the high-water mark if the graph is larger than it has been
+     */
+    void update_memory_high_water(){
+        mMemoryHighWater = std::max(mMemoryHighWater, memory_usage().total());
+    }
 
     /**
      * Set a vertex with no value as a place-holder
      * @param v vertex object to add to the graph's list of vertices
      */
-    void set_empty_vertex(string v){
-        mVertices[v];
+    void set_empty_vertex(const string & v){
+        if(mVertices.count(v) <= 0){
+            mVersion++;
+            count_vertex(mVertices[v], 1);
+            if(mPrefilter.enabled()){
+                mPrefilter.insert(CountingBloomFilter::kmer_hash(v));
+            }
+        }
     }
 
     /**
      * Add an edge between two vertices
      * @param start_v Starting Debruijn vertex
      * @param end_v Vertex being pointed to
+     * @param uses number of sequences that use the edge
      */
-    void add_edge(string start_v, string end_v){
-        int initial_adj_size = mVertices[start_v].adj_list_size();
-        mVertices[start_v].add_to_adj_list(end_v);
-        if(initial_adj_size > 0){ //if the adj_list was not empty, AND new adj_list size > old_adj_list.size, then
-            if(initial_adj_size < mVertices[start_v].adj_list_size()){ //this implies the vertex is a branch point
-                mVertices[start_v].set_branch(true);
-                mBranchedVertices.push_back(start_v);
-                vector<string>::iterator it;
-                mBranchedVertices.erase( std::unique( mBranchedVertices.begin(), mBranchedVertices.end() ), mBranchedVertices.end() );
+    void add_edge(const string & start_v, const string & end_v, int uses = 1){
+        bool new_branch = false;
+        update_lists(start_v, [&] (DBGraphValue & value) {
+            int initial_adj_size = value.adj_list_size();
+            value.add_to_adj_list(end_v);
+            value.increment_edge_count(end_v, uses);
+            if(mPrefilter.enabled() && initial_adj_size < value.adj_list_size()){
+                mPrefilter.insert(CountingBloomFilter::edge_hash(start_v, end_v.back()));
             }
-        }        
+            //if the adj_list was not empty, AND new adj_list size > old_adj_list.size, this implies the vertex is a branch point
+            if(initial_adj_size > 0 && initial_adj_size < value.adj_list_size() && !value.get_branch()){
+                value.set_branch(true);
+                new_branch = true;
+            }
+        });
+        if(new_branch){
+            mBranchPositions.emplace(start_v, mBranchedVertices.size());
+            mBranchedVertices.push_back(start_v);
+        }
     }
 
     /**
-     * Create a useable sequence from the input to construct the graph
-     * @param num_input vector of numbers to create a graph from
-     * @param kmer_length length of each vertex ID
+     * Take an edge out of a vertex's adjacency list (call from inside update_lists).
+     * A vertex that loses its last successor is flagged as an endpoint, as it would be if it were added again:
+     * every sequence still using it ends there. Without this, removing and re-adding a sequence would leave
+     * a different flag than replacing it in place.
+     * @param value the edge's source vertex
+     * @param from its k-mer
+     * @param to vertex being pointed to
      */
-    void construct_from_sequence(vector<int> num_input, int kmer_length){
-        string input = "";
-        for(int i = 0; i < int(num_input.size()); ++i){
-            input += std::to_string(num_input[i]);
+    void drop_edge(DBGraphValue & value, const string & from, const string & to){
+        if(mPrefilter.enabled() && value.valid_adj(to)){
+            mPrefilter.erase(CountingBloomFilter::edge_hash(from, to.back()));
+        }
+        value.remove_from_adj_list(to);
+        if(value.adj_list_size() == 0){
+            value.set_empty_bool(1);
         }
-        construct_from_string(input, kmer_length);
     }
 
     /**
@@ -100,51 +589,68 @@ private:
      * @param input string containing all genetic data sequentially
      */
     void construct_from_string(string input, int kmer_length){
+        mKmerLength = kmer_length;
+        check_writable("DeBruijnGraph");
+        own_genomes().insert(FingerprintBuilder::of(input));
         mSeqSize ++;
         mSequenceLength = input.size();
-        mKmerLength = kmer_length;
         mStarts.push_back(input.substr(0, kmer_length));
         //if the graph is one vertex long:
         if(int(input.length()) == kmer_length){
             set_empty_vertex(input);
         }
-        // if the vertex is already in the graph, then skip this and don't add to size
-        if(mVertices.count(input.substr(0, mKmerLength)) <= 0){
-            mSize++;
-            set_empty_vertex(input.substr(0, mKmerLength));
-        }
-        //add to size and add an edge for each vertex, and an empty vertex for the end
+        set_empty_vertex(input.substr(0, mKmerLength));
+        //add an edge for each vertex, and an empty vertex for the end
         while(int(input.length()) >= kmer_length + 1){
-            if(mVertices.count(input.substr(1, mKmerLength)) <= 0){
-                mSize++;
-            }
             add_edge(input.substr(0, kmer_length), input.substr(1, kmer_length));
             //change the set_empty_bool here so we don't run into endpoint troubles later.
-            mVertices[input.substr(0, kmer_length)].set_empty_bool(0);
+            update_lists(input.substr(0, kmer_length), [] (DBGraphValue & value) { value.set_empty_bool(0); });
             set_empty_vertex(input.substr(1, kmer_length));
             //take one character off the input, continue
             input = input.substr(1, input.length()-1);
         }
-        mVertices[input].set_empty_bool(1);
-        mVertices[input].increment_endpoint();
-        mVertices[input].increment_kmer_occurrences();
+        update_lists(input, [] (DBGraphValue & value) {
+            value.set_empty_bool(1);
+            value.increment_endpoint();
+            value.increment_kmer_occurrences();
+        });
+        update_memory_high_water();
     }
 
 public:
-    DeBruijnGraph()=default;
-    ~DeBruijnGraph()=default;
-    DeBruijnGraph(const DeBruijnGraph &) = default;
+    BasicDeBruijnGraph()=default;
+    ~BasicDeBruijnGraph()=default;
+    BasicDeBruijnGraph(const BasicDeBruijnGraph &) = default;
+
+    template <typename> friend class BasicDeBruijnGraph;
+    friend class MultiKDeBruijnGraph;
+    template <typename> friend class GraphTraversal;
+    template <typename> friend class ParallelTraversal;
 
 ///@remark CONSTRUCTORS /////////////////////////////////////////////////////////////
 
-    DeBruijnGraph(int kmer_length) : mKmerLength(kmer_length) {  };
+    BasicDeBruijnGraph(int kmer_length) : mKmerLength(kmer_length) {  };
+
+    /**
+     * Copy a graph that uses a different vertex store
+     * @param other graph to copy
+     */
+    template <typename OtherStoreT>
+    explicit BasicDeBruijnGraph(const BasicDeBruijnGraph<OtherStoreT> & other)
+        : mSeqSize(other.mSeqSize), mKmerLength(other.mKmerLength), mSequenceLength(other.mSequenceLength),
+          mVertices(other.vertices().begin(), other.vertices().end()), mBranchedVertices(other.mBranchedVertices),
+          mBranchPositions(other.mBranchPositions),
+          mStarts(other.mStarts), mAdjacencyEntries(other.mAdjacencyEntries), mAvailableEntries(other.mAvailableEntries),
+          mEdgeCountEntries(other.mEdgeCountEntries), mStats(other.mStats), mPaths(other.mPaths),
+          mPrefilter(other.mPrefilter), mGenomes(other.mGenomes), mMemoryHighWater(other.mMemoryHighWater),
+          mVersion(other.mVersion) { }
 
     /**
      * Construct a De Bruijn Graph object from a vector of strings
      * @param input a vector containing strings to convert to a graph
      * @param kmer_length length of indecies to pull from input to create a kmer ID
      */
-    DeBruijnGraph(vector<string> input, int kmer_length){
+    BasicDeBruijnGraph(vector<string> input, int kmer_length){
         string result = "";
         for(int i = 0; i < int(input.size()); ++i){
             result += input[i];
@@ -153,12 +659,12 @@ public:
     }
 
     /**
-     * Construct a De Bruijn Graph object from a vector of integers
-     * @param input a vector containing ints to convert to a graph
+     * Construct a De Bruijn Graph object from a vector of integers, read in place as add_sequence does
+     * @param input a vector containing ints (one symbol, 0-9, per element) to convert to a graph
      * @param kmer_length length of indecies to pull from input to create a kmer ID
      */
-    DeBruijnGraph(vector<int> input, int kmer_length){
-        construct_from_sequence(input, kmer_length);
+    BasicDeBruijnGraph(const vector<int> & input, int kmer_length) : mKmerLength(kmer_length) {
+        add_sequence(input.data(), input.size());
     }
 
     /**
@@ -166,7 +672,7 @@ public:
      * @param input a integer to convert to a graph
      * @param kmer_length length of indecies to pull from input to create a kmer ID
      */
-    DeBruijnGraph(int input, int kmer_length){
+    BasicDeBruijnGraph(int input, int kmer_length){
         construct_from_string(std::to_string(input), kmer_length);
     }
 
@@ -175,7 +681,7 @@ public:
      * @param input a string to convert to a graph
      * @param kmer_length length of indecies to pull from input to create a kmer ID
      */
-    DeBruijnGraph(string input, int kmer_length){
+    BasicDeBruijnGraph(string input, int kmer_length){
         construct_from_string(input, kmer_length);
     }
 
@@ -184,77 +690,123 @@ public:
     /**
      * Recursive function to traverse through a single path in the graph, with branches chosen at random
      * To be used in selecting the genetic information for the next generation organism
-     * @param seed random seed to be used when choosing a branching path
-     * @param organism whose genome we are modifying--here I am just going to insert a 3-char string to represent the start
-     */
-    string next_genome_logic(emp::Random & random, string organism){
-        string path = organism;
-        string current = organism;
-        // this will work while all sequences are the same length (looks like this is the case in MABE)
-        while (int(path.size()) < mSequenceLength){
-            // generate index using the empirical random library when we have empirical hooked up
-            current = mVertices[current].get_adj_list()[random.GetUInt(mVertices[current].adj_list_size()-1)]; ///random seed here?!
-            path+= current.substr(2,1);
-        }
-        return path;
+     * @param random random number generator (see RandomPolicy.hpp) to be used when choosing a branching path
+     * @param organism whose genome we are modifying--here I am just going to insert its first k-mer to represent the start
+     */
+    template <typename RandomT>
+    string next_genome_logic(RandomT & random, const string & organism){
+        return with_random_calls(random, [&] (auto & calls) {
+            string path = organism;
+            string current = organism;
+            // this will work while all sequences are the same length (looks like this is the case in MABE)
+            while (int(path.size()) < mSequenceLength){
+                const DBGraphValue * value = find_value(current);
+                if(value == nullptr || value->adj_list_size() == 0){
+                    break;
+                }
+                current = value->adjacency(calls.GetUInt(value->adj_list_size()));
+                path+= current.substr(mKmerLength - 1, 1);
+            }
+            return path;
+        });
     }
 
     /**
-     * Given the genome of an organism, do crossover (if probability allows) by randomly choosing branches of existing 
-     * genomes in the graph to pursue
-     * @param random Empirical random number generator
-     * @param organism whose genome we are modifying--here I am just going to insert a 3-char string to represent the start
-     * @param probability that the modifcation will take place
-     * @param seq_count "Sequence Counting" - if true, kmers are labeled unavailible if they have been used the same number 
+     * Build a new genome by walking the graph from the organism's first k-mer and choosing branches at random, without
+     * changing the graph. The walk keeps its visit counts and available choices to itself, so any number of threads
+     * can sample from the same graph at once; with a CounterRandom per organism the result does not depend on
+     * which thread samples which organism, or in what order.
+     * @param random random number generator (see RandomPolicy.hpp), such as emp::Random, CounterRandom or Xoshiro256
+     * @param organism whose genome we are modifying
+     * @param probability that the modifcation will take place (otherwise organism is returned)
+     * @param seq_count "Sequence Counting" - if true, kmers are labeled unavailible if they have been used the same number
      *                   of times that they have appeared in entire living genome.
      * @param variable_length false if the genome must be a fixed, standard length
+     * @return the new genome
      */
-    string modify_org(emp::Random & random, std::string organism, double probability = 1, bool seq_count = 1, bool variable_length = 0){
-        string path = organism.substr(0, mKmerLength);          // initialize string variables we use to change and go down the path
-        string current = organism.substr(0, mKmerLength);
-        string next = "";
-        mVertices[current].increment_visitor_flag(); // mark 1st kmer as visited
-        int index;
-        bool variable_length_end_reached = false;
-
-        // If P() then we will modify this genome, else do nothing
-        if( random.P( probability ) ) {
-            while ( int(path.size()) < mSequenceLength) { // while our path hasn't reached the sequence length
-
-                if(mVertices[current].get_visitor_flag() == 1) {         
-                    mVertices[current].set_adj_availible(); // available choices = full adj_list if this is our first time seeing it
-                }
+    template <typename RandomT>
+    string sample_path(RandomT & random, const string & organism, double probability = 1, bool seq_count = 1,
+                       bool variable_length = 0) const {
+        return with_random_calls(random, [&] (auto & calls) {
+            return walk_path(calls, organism, probability, seq_count, variable_length);
+        });
+    }
 
-                if(variable_length && mVertices[current].get_endpoint() > 0) { // if genome can be variable length and current kmer is an availible endpoint
-                    index = random.GetUInt(mVertices[current].adj_availible_size() + 1);  // index will be randomly generated number
-                    if( index == mVertices[current].adj_availible_size() ) { // if we have randomly chosen to keep this kmer as an endpoint
-                        variable_length_end_reached = true;
-                        break;
-                    }
-                }
-                else { // if genome must be fixed length
-                    index = random.GetUInt(mVertices[current].adj_availible_size());  // index will be randomly generated number
+private:
+    /**
+     * sample_path with a generator that has the GetUInt / P calls
+     */
+    template <typename RandomT>
+    string walk_path(RandomT & random, const string & organism, double probability, bool seq_count,
+                     bool variable_length) const {
+        string path = organism.substr(0, mKmerLength);
+        string current = path;
+        const DBGraphValue * found = mVertices.lookup(current);
+        if(found == nullptr){
+            throw std::invalid_argument("DeBruijnGraph::sample_path: organism does not start at a vertex of the graph");
+        }
+        if(!random.P(probability)){
+            return organism;
+        }
+        map<string, int> visits;
+        map<string, vector<string>> available;
+        visits[current]++; // mark 1st kmer as visited
+        while(int(path.size()) < mSequenceLength){ // while our path hasn't reached the sequence length
+            const DBGraphValue & value = *found;
+            vector<string> & choices = available[current];
+            if(visits[current] == 1){
+                choices = value.adjacencies(); // available choices = full adj_list if this is our first time seeing it
+            }
+            size_t index;
+            if(variable_length && value.get_endpoint() > 0){ // if genome can be variable length and current kmer is an availible endpoint
+                index = random.GetUInt(choices.size() + 1);
+                if(index == choices.size()){ // if we have randomly chosen to keep this kmer as an endpoint
+                    break;
                 }
-                next = mVertices[current].get_adj_availible(index);                 // record next kmer using index
-                path += next.substr(2,1);
-
-                mVertices[next].increment_visitor_flag();  // mark next as visited
-                if(seq_count){
-                    if(mVertices[next].get_visitor_flag() == mVertices[current].get_kmer_occurrences()){
-                        mVertices[current].remove_adj_availible(next);  // remove kmer from availible seq.s if it has been visited as many times
-                    } // as it appears in all sequences in graph
+            }
+            else { // if genome must be fixed length
+                if(choices.empty()){
+                    break;
                 }
-                current = next;
+                index = random.GetUInt(choices.size());
+            }
+            string next = choices[index];
+            path += next.substr(mKmerLength - 1, 1);
+            visits[next]++; // mark next as visited
+            if(seq_count && visits[next] == value.get_kmer_occurrences()){
+                // remove kmer from availible seq.s if it has been visited as many times as it appears in all sequences in graph
+                choices.erase(std::remove(choices.begin(), choices.end(), next), choices.end());
+            }
+            current = next;
+            found = mVertices.lookup(current);
+            if(found == nullptr){
+                break;
             }
-            remove_sequence(organism);
-            add_sequence(path);
-            reset_vertex_flags();
-            return path;
         }
-        else {
-            reset_vertex_flags();
-            return organism;
+        return path;
+    }
+
+public:
+
+    /**
+     * Given the genome of an organism, do crossover (if probability allows) by randomly choosing branches of existing 
+     * genomes in the graph to pursue, then replace the organism's genome with the new one (see sample_path)
+     * @param random random number generator (see RandomPolicy.hpp), such as emp::Random, CounterRandom or Xoshiro256
+     * @param organism whose genome we are modifying
+     * @param probability that the modifcation will take place
+     * @param seq_count "Sequence Counting" - if true, kmers are labeled unavailible if they have been used the same number 
+     *                   of times that they have appeared in entire living genome.
+     * @param variable_length false if the genome must be a fixed, standard length
+     * @return the new genome
+     */
+    template <typename RandomT>
+    string modify_org(RandomT & random, const string & organism, double probability = 1, bool seq_count = 1, bool variable_length = 0){
+        check_writable("modify_org");
+        string path = sample_path(random, organism, probability, seq_count, variable_length);
+        if(path != organism){
+            update_sequence(organism, path);
         }
+        return path;
     }
 
     /**
@@ -267,24 +819,52 @@ public:
 
     /**
      * Add an entirely new possible sequence into the graph
-     * @param sequence to add to the graph
+     * @param sequence to add to the graph, one symbol (0-9) per element
      */
-    void add_sequence(vector<int> sequence){
-        string input = "";
-        for(int i = 0; i < mKmerLength; ++i){
-            input += std::to_string(sequence[i]);
+    void add_sequence(const vector<int> & sequence){
+        add_sequence(sequence.data(), sequence.size());
+    }
+
+    /**
+     * Add an integer genome straight from its buffer, without building a string first
+     * @param sequence pointer to the first element, one symbol (0-9) per element
+     * @param length number of elements
+     */
+    void add_sequence(const int * sequence, size_t length){
+        // every element is checked first, so a genome with a bad one is refused before the graph changes
+        for(size_t i = 0; i < length; ++i){
+            int_symbol(sequence[i]);
         }
-        add_sequence(input);
+        add_kmers(symbol_kmers([sequence] (size_t i) { return int_symbol(sequence[i]); }, length), walk_length(length), length);
+    }
+
+    /**
+     * Add a bit genome, read as a string of '0' and '1'
+     * @param sequence bits of the genome
+     */
+    void add_sequence(const vector<bool> & sequence){
+        add_kmers(symbol_kmers([&sequence] (size_t i) { return sequence[i] ? '1' : '0'; }, sequence.size()),
+                  walk_length(sequence.size()), sequence.size());
+    }
+
+    /**
+     * Add a bit genome straight from its packed words, without building a string first.
+     * Bit i is bit (i % 64) of word i / 64, the layout emp::BitVector uses.
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     */
+    void add_sequence(const uint64_t * words, size_t num_bits){
+        with_packed_kmers(words, num_bits, [this, num_bits] (auto kmer_at, size_t count) { add_kmers(kmer_at, count, num_bits); });
     }
 
     /**
      * Add an entirely new possible sequence into the graph
-     * @param sequence to add to the graph
+     * @param sequence to add to the graph, as consecutive pieces
      */
-    void add_sequence(vector<string> sequence){
+    void add_sequence(const vector<string> & sequence){
         string input = "";
-        for(int i = 0; i < mKmerLength; ++i){
-            input += sequence[i];
+        for(auto const & piece : sequence){
+            input += piece;
         }
         add_sequence(input);
     }
@@ -295,36 +875,9 @@ public:
      * traverse through and randomly do crossovers when we hit a branch.
      * @param sequence to add to the graph
      */
-    void add_sequence(string sequence){
-        mSeqSize += 1;
-        mSequenceLength = sequence.size();
-        // if the beginning string is not in the graph, add a new beginning vertex
-        if(mVertices.count(sequence.substr(0, mKmerLength)) <= 0){
-            mStarts.push_back(sequence.substr(0, mKmerLength));
-            set_empty_vertex(sequence.substr(0, mKmerLength));
-            mSize++;
-        }
-        // go through the entire new sequence and add edges:
-        while(int(sequence.length()) >= mKmerLength+1){
-            if(mVertices.count(sequence.substr(1, mKmerLength)) <= 0){
-                mSize++;
-            }
-            add_edge(sequence.substr(0, mKmerLength), sequence.substr(1, mKmerLength));
-            mVertices[sequence.substr(0, mKmerLength)].set_empty_bool(0); //set that we know this adj_list has something in it
-            mVertices[sequence.substr(0, mKmerLength)].increment_kmer_occurrences(); //increment number of times we've seen this kmer in the pangenome
-            //if future vertex is not already in map, set it as an empty vertex
-            if(mVertices.count(sequence.substr(1, mKmerLength)) <= 0){
-                set_empty_vertex(sequence.substr(1, mKmerLength));
-            }
-            sequence = sequence.substr(1, sequence.length()-1); //update our kmer and repeat!
-        }
-        //flag that this node's adj_list as empty only if we haven't seen it before (value of 2)
-        //if it has previously been flagged with a value of 0, we know it has something in the adj_list
-        if(mVertices[sequence].get_empty_bool() == 2){
-            mVertices[sequence].set_empty_bool(1);
-        }
-        mVertices[sequence].increment_endpoint(); //increment number of times this kmer is an endpoint of a seq in the pangenome
-        mVertices[sequence].increment_kmer_occurrences(); //increment number of times we've seen this kmer in the pangenome
+    void add_sequence(const string & sequence){
+        add_kmers([&sequence, this] (size_t i, string & kmer) { kmer.assign(sequence, i, mKmerLength); },
+                  walk_length(sequence.size()), sequence.size());
     }
 
 private:
@@ -332,51 +885,486 @@ private:
      * remove_sequence helper function to make sure sequence is removed from all containers
      * @param sequence to remove
      */
-    void remove(string sequence){
-        mSize--;
-        mVertices.erase(sequence);
+    void remove(const string & sequence){
+        auto it = mVertices.find(sequence);
+        if(it != mVertices.end()){
+            mVersion++;
+            if(mPrefilter.enabled()){
+                for(auto const & adj : it->second.adjacencies()){
+                    mPrefilter.erase(CountingBloomFilter::edge_hash(sequence, adj.back()));
+                }
+                mPrefilter.erase(CountingBloomFilter::kmer_hash(sequence));
+            }
+            count_vertex(it->second, -1);
+            mAdjacencyEntries -= it->second.adj_list_size();
+            mAvailableEntries -= it->second.adj_availible_size();
+            mEdgeCountEntries -= it->second.edge_count_size();
+            mVertices.erase(sequence);
+        }
         mStarts.erase(std::remove(mStarts.begin(), mStarts.end(), sequence), mStarts.end());
-        mBranchedVertices.erase(std::remove(mBranchedVertices.begin(), mBranchedVertices.end(), sequence), mBranchedVertices.end());
+        drop_branch(sequence);
+    }
+
+    /// Net change to one vertex's counts, summed over several sequences
+    struct VertexDelta {
+        int occurrences = 0;
+        int endpoints = 0;
+    };
+    using VertexDeltas = map<string, VertexDelta>;
+    using EdgeDeltas = map<std::pair<string, string>, int>;
+
+    /**
+     * Add the k-mers [begin, end) of a sequence, and every edge that touches them, to a set of deltas.
+     * An empty window (begin == end) still counts the edge across it.
+     * @param kmer_at lambda taking (i, string & kmer) that writes the i-th k-mer into kmer
+     * @param count number of k-mers in the sequence
+     * @param begin first k-mer of the window
+     * @param end one past the last k-mer of the window
+     * @param sign 1 for a sequence being added, -1 for one being removed
+     * @param vertex_deltas occurrence changes, by vertex
+     * @param edge_deltas use changes, by (from, to)
+     * @param fingerprint if not nullptr, the window's symbols are appended to it (for a window of the whole sequence,
+     * this fingerprints the sequence)
+     */
+    template <typename KmerFunc>
+    void count_window(KmerFunc kmer_at, size_t count, size_t begin, size_t end, int sign,
+                      VertexDeltas & vertex_deltas, EdgeDeltas & edge_deltas, FingerprintBuilder * fingerprint = nullptr){
+        string current, next;
+        for(size_t i = begin; i < end; ++i){
+            kmer_at(i, current);
+            vertex_deltas[current].occurrences += sign;
+            if(fingerprint){
+                if(i == begin){
+                    fingerprint->append(current);
+                }
+                else {
+                    fingerprint->append(current.back());
+                }
+            }
+        }
+        for(size_t i = begin > 0 ? begin - 1 : 0; i < std::min(end, count - 1); ++i){
+            kmer_at(i, current);
+            kmer_at(i + 1, next);
+            edge_deltas[{current, next}] += sign;
+        }
+    }
+
+    /**
+     * Apply summed deltas to the graph. Vertices that gain uses are created first and edges that lose uses are
+     * dropped before new ones are added, so no vertex is deleted only to be re-added and branch points are
+     * judged against the edges that stay. Vertices that lost uses are deleted last if nothing uses them.
+     * @param vertex_deltas occurrence and endpoint changes, by vertex
+     * @param edge_deltas use changes, by (from, to)
+     */
+    void apply_deltas(const VertexDeltas & vertex_deltas, const EdgeDeltas & edge_deltas){
+        for(auto const & vertex : vertex_deltas){
+            if(vertex.second.occurrences > 0){
+                set_empty_vertex(vertex.first);
+            }
+        }
+        // edges first, while every vertex they start from is still there
+        for(auto const & edge : edge_deltas){
+            const string & from = edge.first.first;
+            const string & to = edge.first.second;
+            if(edge.second >= 0 || mVertices.count(from) <= 0){
+                continue;
+            }
+            update_lists(from, [&] (DBGraphValue & value) {
+                if(value.decrement_edge_count(to, -edge.second) <= 0){
+                    drop_edge(value, from, to);
+                }
+            });
+        }
+        for(auto const & edge : edge_deltas){
+            if(edge.second > 0){
+                add_edge(edge.first.first, edge.first.second, edge.second);
+                update_lists(edge.first.first, [] (DBGraphValue & value) { value.set_empty_bool(0); });
+            }
+        }
+        for(auto const & vertex : vertex_deltas){
+            if(mVertices.count(vertex.first) <= 0){
+                continue;
+            }
+            update_lists(vertex.first, [&] (DBGraphValue & value) {
+                value.decrement_kmer_occurrences(-vertex.second.occurrences);
+                value.decrement_endpoint(-vertex.second.endpoints);
+                if(vertex.second.endpoints > 0 && value.get_empty_bool() == 2){
+                    value.set_empty_bool(1);
+                }
+            });
+            if(vertex.second.occurrences < 0 && vertices().find(vertex.first)->second.get_kmer_occurrences() <= 0){
+                remove(vertex.first);
+            }
+        }
     }
 
 public:
+    /**
+     * K-mer, edge and endpoint counts of a batch of sequences, gathered without touching any graph so that
+     * separate threads can each count part of a population. Counts of consecutive parts are merged in order
+     * and then added to the graph at once with add_counts.
+     */
+    class SequenceCounts {
+        friend class BasicDeBruijnGraph;
+
+        /// Length of the k-mers counted
+        int mKmerLength;
+
+        /// Occurrences and endpoints, by k-mer
+        VertexDeltas mVertexDeltas;
+
+        /// Uses, by edge
+        EdgeDeltas mEdgeDeltas;
+
+        /// First k-mers of sequences that had not been seen earlier in the batch, in order
+        vector<string> mStarts;
+
+        /// Fingerprint of each sequence counted
+        vector<GenomeFingerprint> mGenomes;
+
+        /// Number of sequences counted
+        int mSequences = 0;
+
+        /// Length of the last sequence counted
+        size_t mLastLength = 0;
+
+    public:
+        /**
+         * @param kmer_length length of the k-mers of the graph the counts will be added to
+         */
+        explicit SequenceCounts(int kmer_length) : mKmerLength(kmer_length) { }
+
+        /**
+         * Count one sequence, read in place
+         * @param sequence first character of the sequence
+         * @param length number of characters
+         */
+        void count(const char * sequence, size_t length){
+            size_t kmer_length = mKmerLength;
+            size_t kmers = length > kmer_length ? length - kmer_length + 1 : 1;
+            string current(sequence, std::min(kmer_length, length)), next;
+            FingerprintBuilder fingerprint;
+            fingerprint.append(current);
+            if(mVertexDeltas.count(current) <= 0){
+                mStarts.push_back(current);
+            }
+            mVertexDeltas[current].occurrences++;
+            for(size_t i = 1; i < kmers; ++i){
+                next.assign(sequence + i, kmer_length);
+                fingerprint.append(next.back());
+                mEdgeDeltas[{current, next}]++;
+                mVertexDeltas[next].occurrences++;
+                current.swap(next);
+            }
+            mVertexDeltas[current].endpoints++;
+            mGenomes.push_back(fingerprint.finish());
+            mSequences++;
+            mLastLength = length;
+        }
+
+        /**
+         * Count one sequence
+         * @param sequence to count
+         */
+        void count(const string & sequence){ count(sequence.data(), sequence.size()); }
+
+        /**
+         * Take over the counts of the sequences that come right after these ones
+         * @param later counts of the next part of the population (left empty)
+         */
+        void merge(SequenceCounts && later){
+            for(auto & start : later.mStarts){
+                if(mVertexDeltas.count(start) <= 0){
+                    mStarts.push_back(std::move(start));
+                }
+            }
+            // move over the nodes of k-mers and edges only the later part has, then add up the rest
+            mVertexDeltas.merge(later.mVertexDeltas);
+            for(auto const & vertex : later.mVertexDeltas){
+                mVertexDeltas[vertex.first].occurrences += vertex.second.occurrences;
+                mVertexDeltas[vertex.first].endpoints += vertex.second.endpoints;
+            }
+            mEdgeDeltas.merge(later.mEdgeDeltas);
+            for(auto const & edge : later.mEdgeDeltas){
+                mEdgeDeltas[edge.first] += edge.second;
+            }
+            mGenomes.insert(mGenomes.end(), later.mGenomes.begin(), later.mGenomes.end());
+            if(later.mSequences > 0){
+                mLastLength = later.mLastLength;
+            }
+            mSequences += later.mSequences;
+            later = SequenceCounts(mKmerLength);
+        }
+
+        /**
+         * @return number of sequences counted
+         */
+        int sequences() const { return mSequences; }
+
+        /**
+         * @return number of distinct k-mers counted
+         */
+        size_t kmers() const { return mVertexDeltas.size(); }
+    };
+
+    /**
+     * Add every sequence in a set of counts, as if each had been passed to add_sequence in order.
+     * Each vertex and edge is updated once, in sorted order, so adjacency lists may list their vertices in
+     * a different order than one-by-one adds would.
+     * @param counts sequences counted for a graph with this k-mer length
+     */
+    void add_counts(const SequenceCounts & counts){
+        check_writable("add_counts");
+        if(counts.mKmerLength != mKmerLength){
+            throw std::invalid_argument("add_counts: the sequences were counted with a different k-mer length");
+        }
+        vector<string> new_starts;
+        for(auto const & start : counts.mStarts){
+            if(mVertices.count(start) <= 0){
+                new_starts.push_back(start);
+            }
+        }
+        apply_deltas(counts.mVertexDeltas, counts.mEdgeDeltas);
+        mStarts.insert(mStarts.end(), new_starts.begin(), new_starts.end());
+        for(auto const & genome : counts.mGenomes){
+            own_genomes().insert(genome);
+        }
+        mSeqSize += counts.mSequences;
+        if(counts.mSequences > 0){
+            mSequenceLength = counts.mLastLength;
+        }
+        update_memory_high_water();
+    }
+
+    /**
+     * Add a whole batch of sequences at once (see add_counts)
+     * @param sequences to add
+     */
+    void add_sequences(const vector<string> & sequences){
+        SequenceCounts counts(mKmerLength);
+        for(auto const & sequence : sequences){
+            counts.count(sequence);
+        }
+        add_counts(counts);
+    }
+
     /**
      * Remove a sequence from the graph
      * To be used in BeforeDeath in MABE
      * @param sequence to remove
      */
-    void remove_sequence(string sequence){
-        if(is_valid(sequence)){
-            mSeqSize--;
-            string current, next;
-            bool current_appears_once, next_appears_once;
-            // while we still have sequence left:
-            while(int(sequence.size()) > mKmerLength){
-
-                current = sequence.substr(0,mKmerLength);
-                next = sequence.substr(1,mKmerLength);
-                current_appears_once = mVertices[current].get_kmer_occurrences() <= 1;
-                next_appears_once = mVertices[next].get_kmer_occurrences() <= 1;
-
-                mVertices[current].decrement_kmer_occurrences();
-                //if current or next vertex only appeared once in pangenome, break adj & remove edge from graph
-                if(current_appears_once || next_appears_once){
-                    mVertices[current].remove_from_adj_list(next);
+    void remove_sequence(const string & sequence){
+        remove_kmers([&sequence, this] (size_t i, string & kmer) { kmer.assign(sequence, i, mKmerLength); },
+                     walk_length(sequence.size()));
+        //else{ throw std::invalid_argument( "input sequence to DeBruijn remove_sequence() is invalid" ); }
+    }
+
+    /**
+     * Add a sequence and keep its path, so it can later be removed by handle without the caller keeping the
+     * genome string. Sequences added this way should only be removed through their handle.
+     * To be used in OnOffspringReady in MABE, storing the handle on the organism
+     * @param sequence to add to the graph
+     * @return handle of the sequence
+     */
+    SequenceHandle register_sequence(const string & sequence){
+        add_sequence(sequence);
+        return own_paths().store(sequence);
+    }
+
+    /**
+     * Remove a registered sequence by walking its recorded path. The path is known to be in the graph, so it is
+     * not checked first and no genome string is rebuilt.
+     * To be used in BeforeDeath in MABE
+     * @param handle returned by register_sequence
+     * @return true if the sequence was removed (false if the handle names no registered sequence)
+     */
+    bool remove_sequence(SequenceHandle handle){
+        check_writable("remove_sequence");
+        if(!mPaths->contains(handle)){
+            return false;
+        }
+        PathStore & paths = own_paths();
+        std::string_view path = paths.path(handle);
+        size_t kmer_length = mKmerLength;
+        decrement_kmers([path, kmer_length] (size_t i, string & kmer) {
+            kmer.assign(path.data() + i, std::min(path.size() - i, kmer_length));
+        }, walk_length(path.size()));
+        paths.release(handle);
+        return true;
+    }
+
+    /**
+     * @param handle returned by register_sequence
+     * @return the registered sequence
+     */
+    string get_sequence(SequenceHandle handle) const { return string(mPaths->path(handle)); }
+
+    /**
+     * @return number of registered sequences still in the graph
+     */
+    size_t registered_count() const { return mPaths->size(); }
+
+    /**
+     * Remove a whole batch of sequences (e.g. every organism dying this generation) at once.
+     * The k-mer, edge and endpoint decrements of all the sequences are summed first, then applied once per
+     * vertex and edge in sorted order, and vertices and edges nothing uses any more are deleted once.
+     * The result is the same as calling remove_sequence on each sequence, as long as each one was added.
+     * To be used in BeforeDeath in MABE
+     * @param sequences to remove
+     * @return number of sequences removed (sequences that are not valid are skipped)
+     */
+    int remove_sequences(const vector<string> & sequences){
+        check_writable("remove_sequences");
+        VertexDeltas vertex_deltas;
+        EdgeDeltas edge_deltas;
+        int removed = 0;
+        string last;
+        for(auto const & sequence : sequences){
+            auto kmer_at = [&sequence, this] (size_t i, string & kmer) { kmer.assign(sequence, i, mKmerLength); };
+            size_t count = walk_length(sequence.size());
+            if(!valid_kmers(kmer_at, count)){
+                continue;
+            }
+            removed++;
+            FingerprintBuilder fingerprint;
+            count_window(kmer_at, count, 0, count, -1, vertex_deltas, edge_deltas, &fingerprint);
+            own_genomes().erase(fingerprint.finish());
+            kmer_at(count - 1, last);
+            vertex_deltas[last].endpoints--;
+        }
+        mSeqSize -= removed;
+        apply_deltas(vertex_deltas, edge_deltas);
+        return removed;
+    }
+
+    /**
+     * Replace a sequence with one that differs from it in a few places (e.g. a mutated or recombined offspring
+     * replacing its parent). Only the k-mers and edges that overlap a changed site are touched, so the result
+     * (start vertices included) is the same as remove_sequence(old_sequence) followed by
+     * add_sequence(new_sequence) without looking up every k-mer of either sequence. Sequences of equal length
+     * are compared site by site; if the lengths differ, everything between the shared prefix and the shared
+     * suffix is treated as changed.
+     * @param old_sequence sequence in the graph to replace; if it is not valid the new one is just added
+     * @param new_sequence sequence to add in its place
+     */
+    void update_sequence(const string & old_sequence, const string & new_sequence){
+        check_writable("update_sequence");
+        auto old_at = [&old_sequence, this] (size_t i, string & kmer) { kmer.assign(old_sequence, i, mKmerLength); };
+        auto new_at = [&new_sequence, this] (size_t i, string & kmer) { kmer.assign(new_sequence, i, mKmerLength); };
+        size_t old_count = walk_length(old_sequence.size());
+        size_t new_count = walk_length(new_sequence.size());
+        if(!valid_kmers(old_at, old_count)){
+            add_sequence(new_sequence);
+            return;
+        }
+        VertexDeltas vertex_deltas;
+        EdgeDeltas edge_deltas;
+        size_t k = mKmerLength;
+        // the old genome is hashed while it is compared with the new one, and the new genome's fingerprint
+        // is derived from it at the changed sites
+        FingerprintBuilder old_fingerprint, new_fingerprint;
+        if(old_sequence.size() == new_sequence.size()){
+            // every k-mer overlapping a changed site, with overlapping windows merged
+            size_t begin = 0, end = 0;
+            vector<size_t> changed;
+            for(size_t site = 0; site < old_sequence.size(); ++site){
+                old_fingerprint.append(old_sequence[site]);
+                if(old_sequence[site] == new_sequence[site]){
+                    continue;
                 }
-                //if current kmer was only in 1 seq in the pangenome, delete it from mVerticies
-                if (current_appears_once){
-                    remove(current);
+                changed.push_back(site);
+                size_t first = site + 1 > k ? site + 1 - k : 0;
+                if(end > 0 && first > end){
+                    count_window(old_at, old_count, begin, end, -1, vertex_deltas, edge_deltas);
+                    count_window(new_at, new_count, begin, end, 1, vertex_deltas, edge_deltas);
+                    begin = first;
                 }
-                sequence = sequence.substr(1, sequence.length()-1);
-
+                else if(end == 0){
+                    begin = first;
+                }
+                end = std::min(site + 1, old_count);
             }
-            mVertices[sequence].decrement_kmer_occurrences();
-            mVertices[sequence].decrement_endpoint();
-            if (mVertices[sequence].get_kmer_occurrences() <= 0){
-                remove(sequence);
+            if(end > 0){
+                count_window(old_at, old_count, begin, end, -1, vertex_deltas, edge_deltas);
+                count_window(new_at, new_count, begin, end, 1, vertex_deltas, edge_deltas);
+            }
+            new_fingerprint = old_fingerprint;
+            for(size_t site : changed){
+                new_fingerprint.replace(site, old_sequence[site], new_sequence[site]);
             }
         }
-        //else{ throw std::invalid_argument( "input sequence to DeBruijn remove_sequence() is invalid" ); }
+        else {
+            // a sequence shorter than k is one clipped k-mer that matches nothing in the other, so all of it changed
+            size_t shorter = std::min(old_sequence.size(), new_sequence.size());
+            if(shorter < k){
+                shorter = 0;
+            }
+            size_t prefix = 0, suffix = 0;
+            while(prefix < shorter && old_sequence[prefix] == new_sequence[prefix]){
+                old_fingerprint.append(old_sequence[prefix]);
+                prefix++;
+            }
+            while(prefix + suffix < shorter
+                  && old_sequence[old_sequence.size() - 1 - suffix] == new_sequence[new_sequence.size() - 1 - suffix]){
+                suffix++;
+            }
+            // shared prefix, then each genome's own middle, then the shared suffix
+            FingerprintBuilder shared_suffix;
+            shared_suffix.append(std::string_view(old_sequence).substr(old_sequence.size() - suffix));
+            new_fingerprint = old_fingerprint;
+            old_fingerprint.append(std::string_view(old_sequence).substr(prefix, old_sequence.size() - suffix - prefix));
+            new_fingerprint.append(std::string_view(new_sequence).substr(prefix, new_sequence.size() - suffix - prefix));
+            old_fingerprint.append(shared_suffix);
+            new_fingerprint.append(shared_suffix);
+            // k-mers that lie wholly inside the shared prefix or the shared suffix are unchanged
+            size_t begin = prefix + 1 > k ? prefix + 1 - k : 0;
+            count_window(old_at, old_count, std::min(begin, old_count), std::min(old_sequence.size() - suffix, old_count), -1,
+                         vertex_deltas, edge_deltas);
+            count_window(new_at, new_count, std::min(begin, new_count), std::min(new_sequence.size() - suffix, new_count), 1,
+                         vertex_deltas, edge_deltas);
+        }
+        string old_last, new_last, new_first;
+        old_at(old_count - 1, old_last);
+        new_at(new_count - 1, new_last);
+        if(old_last != new_last){
+            vertex_deltas[old_last].endpoints--;
+            vertex_deltas[new_last].endpoints++;
+        }
+        // starts end up as remove_sequence(old) then add_sequence(new) leave them: the removal deletes (and so
+        // un-starts) every vertex whose uses all lie in the old sequence, and the addition makes the new first
+        // k-mer a start if it is absent by then. Counting the old k-mers takes no vertex lookups.
+        std::unordered_map<std::string_view, int> old_uses;
+        for(size_t i = 0; i < old_count; ++i){
+            old_uses[std::string_view(old_sequence).substr(i, k)]++;
+        }
+        auto gone_after_removal = [this, &old_uses] (const string & kmer) {
+            const DBGraphValue * value = mVertices.lookup(kmer);
+            if(value == nullptr){
+                return true;
+            }
+            auto uses = old_uses.find(kmer);
+            return uses != old_uses.end() && value->get_kmer_occurrences() <= uses->second;
+        };
+        new_at(0, new_first);
+        bool new_start = gone_after_removal(new_first);
+        mStarts.erase(std::remove_if(mStarts.begin(), mStarts.end(), gone_after_removal), mStarts.end());
+        mSequenceLength = new_sequence.size();
+        own_genomes().erase(old_fingerprint.finish());
+        own_genomes().insert(new_fingerprint.finish());
+        apply_deltas(vertex_deltas, edge_deltas);
+        if(new_start){
+            mStarts.push_back(new_first);
+        }
+        update_memory_high_water();
+    }
+
+    /**
+     * Remove a packed bit genome (same layout as add_sequence) without converting it to a string
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     */
+    void remove_sequence(const uint64_t * words, size_t num_bits){
+        with_packed_kmers(words, num_bits, [this] (auto kmer_at, size_t count) { remove_kmers(kmer_at, count); });
     }
 
     /**
@@ -387,20 +1375,60 @@ public:
      * @param sequence to evaluate
      * @return true is the sequence is valid, false if it is not in the graph
      */
-    bool is_valid(string sequence){
-        string current, next;
-        while(int(sequence.size()) > mKmerLength+1){
-            current = sequence.substr(0,mKmerLength);
-            next = sequence.substr(1,mKmerLength);
-            // if the path from this vertex to it's adjacency is invalid, return false
-            if(!mVertices[current].valid_adj(next)){
-                return false;
-            }
-            sequence = sequence.substr(1, sequence.length()-1);
+    bool is_valid(const string & sequence) const {
+        return valid_kmers([&sequence, this] (size_t i, string & kmer) { kmer.assign(sequence, i, mKmerLength); },
+                           walk_length(sequence.size()));
+    }
+
+    /**
+     * Check a packed bit genome (same layout as add_sequence) without converting it to a string
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     * @return true is the sequence is valid, false if it is not in the graph
+     */
+    bool is_valid(const uint64_t * words, size_t num_bits) const {
+        return with_packed_kmers(words, num_bits, [this] (auto kmer_at, size_t count) { return valid_kmers(kmer_at, count); });
+    }
+
+    /**
+     * Check whether an exact genome is in the graph, e.g. to skip evaluating an offspring that duplicates a
+     * living organism. Unlike is_valid, this is only true for genomes that were added and not yet removed.
+     * @param fingerprint FingerprintBuilder::of(genome), so one hash can be reused across several lookups
+     * @return true if at least one copy of the genome is in the graph
+     */
+    bool contains_genome(const GenomeFingerprint & fingerprint) const { return mGenomes->contains(fingerprint); }
+
+    /**
+     * @param genome to look for
+     * @return true if at least one copy of the genome is in the graph
+     */
+    bool contains_genome(const string & genome) const { return mGenomes->contains(FingerprintBuilder::of(genome)); }
+
+    /**
+     * Check a packed bit genome (same layout as add_sequence) without converting it to a string
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     * @return true if at least one copy of the genome is in the graph
+     */
+    bool contains_genome(const uint64_t * words, size_t num_bits) const {
+        FingerprintBuilder fingerprint;
+        for(size_t i = 0; i < num_bits; ++i){
+            fingerprint.append((words[i / 64] >> (i % 64)) & 1 ? '1' : '0');
         }
-        return true;
+        return mGenomes->contains(fingerprint.finish());
     }
 
+    /**
+     * @param genome to look for
+     * @return number of copies of the genome in the graph
+     */
+    int genome_count(const string & genome) const { return int(mGenomes->count(FingerprintBuilder::of(genome))); }
+
+    /**
+     * @return number of different genomes in the graph
+     */
+    size_t distinct_genomes() const { return mGenomes->distinct(); }
+
 ///@remark DISPLAY AND TRAVERSAL /////////////////////////////////////////////////////////////
 
     template <typename FuncType>
@@ -413,7 +1441,7 @@ public:
      */
     void depth_first_traversal(FuncType func){
         // edge case--this traversal did not work for size of 1 without it
-        if(mSize == 1){
+        if(mVertices.size() == 1){
             func(mStarts[0]);
         }
         else{
@@ -431,7 +1459,7 @@ public:
                     // otherwise, the adjacencies are already in there somewhere, so not needed
                     if(mVertices[current].get_visitor_flag() < 1){
                         for(int i = mVertices[current].adj_list_size(); i > 0; i--){
-                            path.push_back(mVertices[current].get_adj_list()[i-1]);
+                            path.push_back(mVertices[current].adjacency(i-1));
                         }
                     }
                     mVertices[current].increment_visitor_flag();
@@ -440,16 +1468,82 @@ public:
         }
         reset_vertex_flags();
     }
+
+    template <typename FuncType>
+    /**
+     * Read-only version of the traversal above, for use on a const graph (such as a pinned snapshot).
+     * Visit counts are kept locally instead of in the vertex flags, so any number of readers can
+     * traverse the same graph at once. Vertices are visited in the same order as the mutable traversal.
+     * @param func lambda function to use when visiting the current vertex
+     */
+    void depth_first_traversal(FuncType func) const {
+        if(mVertices.size() == 1){
+            func(mStarts[0]);
+            return;
+        }
+        map<string, int> visits;
+        vector<string> path = mStarts;
+        string current = "";
+        while(path.size() > 0){
+            current = path.back();
+            path.pop_back();
+            auto it = mVertices.find(current);
+            int adj_size = it == mVertices.end() ? 0 : it->second.adj_list_size();
+            int & visited = visits[current];
+            if(visited <= adj_size){
+                func(current);
+                if(visited < 1){
+                    for(int i = adj_size; i > 0; i--){
+                        path.push_back(it->second.get_adjacency(i-1));
+                    }
+                }
+                visited++;
+            }
+        }
+    }
+
+    /**
+     * Visit every vertex once, depth first from the start vertices (see GraphTraversal). Read-only and reentrant:
+     *     for(const string & kmer : graph.depth_first()){ ... }
+     * @return traversal to iterate over (its edges() gives the out-edges in the same order)
+     */
+    GraphTraversal<BasicDeBruijnGraph> depth_first() const {
+        return GraphTraversal<BasicDeBruijnGraph>(*this, TraversalOrder::DEPTH_FIRST);
+    }
+
+    /**
+     * Visit every vertex once, breadth first from the start vertices (see GraphTraversal)
+     * @return traversal to iterate over
+     */
+    GraphTraversal<BasicDeBruijnGraph> breadth_first() const {
+        return GraphTraversal<BasicDeBruijnGraph>(*this, TraversalOrder::BREADTH_FIRST);
+    }
+
+    /**
+     * Call a function on every vertex from several threads, for whole-graph analyses (see ParallelTraversal)
+     * @param func lambda taking (const string & kmer, const DBGraphValue & value); must be thread-safe
+     * @param threads number of threads (0 for one per hardware thread)
+     */
+    template <typename FuncType>
+    void parallel_traversal(FuncType func, unsigned threads = 0) const {
+        ParallelTraversal<BasicDeBruijnGraph>(*this, threads).run(func);
+    }
     
     /**
      * Reset all vertex flags to show they are Unvisited
      * To be used in traversals
      */
     void reset_vertex_flags() {
-        vector<string> all_vertices;
-        for (auto & element : mVertices) {
-            element.second.change_visitor_flag(0);
-            element.second.clear_adj_availible();
+        // only write to vertices that were actually flagged, so a cloned graph keeps sharing the rest
+        vector<string> flagged;
+        for (auto const & element : vertices()) {
+            if (element.second.get_visitor_flag() != 0 || element.second.adj_availible_size() > 0) {
+                flagged.push_back(element.first);
+            }
+        }
+        for (auto & vertex : flagged) {
+            mVertices[vertex].change_visitor_flag(0);
+            update_lists(vertex, [] (DBGraphValue & value) { value.clear_adj_availible(); });
         }
     }
 
@@ -457,22 +1551,23 @@ public:
      * Print all vertices on the map to disply them
      * @todo Would like to eventually use Julia to display the graph as a whole
      */
-    void display(){
+    void display() const {
         depth_first_traversal( [&] (string vertex) { 
+            const DBGraphValue & value = value_of(vertex);
             cout<<vertex;
             // if there is one, non-empty vertex in the list, print it
-            if (mVertices[vertex].get_empty_bool()==0 && mVertices[vertex].adj_list_size() == 1){
-                cout<<" -> "<<mVertices[vertex].get_adj_list()[0];
+            if (value.get_empty_bool()==0 && value.adj_list_size() == 1){
+                cout<<" -> "<<value.get_adjacency(0);
             }
             // if the adj_list has more than one node in it, print them
-            else if (mVertices[vertex].adj_list_size() >= 1){
+            else if (value.adj_list_size() >= 1){
                 cout<<" -> ";
-                for(auto i: mVertices[vertex].get_adj_list()){
+                for(auto const & i : value.adjacencies()){
                     cout<<i<<", ";
                 }
             }
             // if the adj_list contains an endpoint/empty vertex, show that
-            if (mVertices[vertex].get_empty_bool()==1){
+            if (value.get_empty_bool()==1){
                 cout << "(an endpoint)";
             }
             cout<<"\n";
@@ -488,18 +1583,28 @@ public:
      * more than one adjacency)
      * @param time (generation) in string form that we are recording that graph at
      */
-    void csv(string time){
-        file.open("dbg_"+time+".csv");
-        file<<"Time,Count,From,To"<<"\n";
+    void csv(const string & time) const {
+        std::ofstream file("dbg_"+time+".csv");
+        write_csv(file, time);
+    }
+
+    /**
+     * Write the CSV described above to any stream.
+     * Read-only, so analysis code can call it on a pinned snapshot while the next generation is applied.
+     * @param out stream to write to
+     * @param time (generation) in string form that we are recording that graph at
+     */
+    void write_csv(std::ostream & out, const string & time) const {
+        out<<"Time,Count,From,To"<<"\n";
 
         string traits;
-        for(auto vertex : get_all_vertices()){
-            for(auto adj : get_value(vertex).get_adj_list()){
+        for(auto const & vertex : mVertices){
+            for(auto const & adj : vertex.second.adjacencies()){
                 traits+=time+",";
-                traits+=std::to_string(get_value(vertex).get_kmer_occurrences())+",";
-                traits+=vertex+",";
+                traits+=std::to_string(vertex.second.get_kmer_occurrences())+",";
+                traits+=vertex.first+",";
                 traits+=adj+",";
-                file << traits << "\n";
+                out << traits << "\n";
                 traits = "";
             }
         }
@@ -510,8 +1615,8 @@ public:
      * The reason why those work is because we iterate through the graph in the same order in each function.
      */
     void example_iteration(){
-        for(auto vertex : mVertices){
-            for(auto adj : mVertices[vertex.first].get_adj_list()){
+        for(auto const & vertex : vertices()){
+            for(auto const & adj : vertex.second.adjacencies()){
                 cout<<vertex.first<<"->"<<adj<<endl;
             }
         }
@@ -523,10 +1628,10 @@ public:
      * @return int sequence count, starting vertex, starting vertex's 1st adjacency
      */
     tuple<int,string,string> csv_start_values(){
-        vector<string> temp = get_all_vertices();
-        for(auto vertex : temp){
-            for(auto adj : mVertices[vertex].get_adj_list()){
-                return std::make_tuple(mVertices[vertex].get_kmer_occurrences(), vertex, adj);
+        for(auto const & vertex : get_all_vertices()){
+            const DBGraphValue & value = value_of(vertex);
+            for(auto const & adj : value.adjacencies()){
+                return std::make_tuple(value.get_kmer_occurrences(), vertex, adj);
             }
         } return std::make_tuple(-1, "", "");
     }
@@ -539,22 +1644,28 @@ public:
      * @param to current adjacency of current vertex
      * @return tuple<int, int> current and next sequence count
      */
-    tuple<int, int> kmer_count(int count, string from, string to){
-        int current = 0, next = 0;
-        for(auto vertex : mVertices){
-            for(auto adj : mVertices[vertex.first].get_adj_list()){
+    tuple<int, int> kmer_count(int count, const string & from, const string & to){
+        int current = 0, next = -1;
+        bool found_next = false;
+        for(auto const & vertex : vertices()){
+            for(auto const & adj : vertex.second.adjacencies()){
                 if(current > 0){ // record the next count
-                    next = mVertices[vertex.first].get_kmer_occurrences();
-                    return std::make_tuple(current, next);
+                    next = vertex.second.get_kmer_occurrences();
+                    found_next = true;
+                    break;
                 }
-                if(mVertices[vertex.first].get_kmer_occurrences()==count && mVertices[vertex.first].get_visitor_flag()<mVertices[vertex.first].adj_list_size() && vertex.first==from && adj==to){ // match current count
+                if(vertex.second.get_kmer_occurrences()==count && vertex.second.get_visitor_flag()<vertex.second.adj_list_size() && vertex.first==from && adj==to){ // match current count
                     current = count;
-                    mVertices[vertex.first].increment_visitor_flag();
                 }
             }
+            if(found_next){
+                break;
+            }
         }
         if(current > 0){ // if we're on the last vertex of the graph, there will not be a next count
-            return std::make_tuple(current, -1);
+            // flag the match only once the walk is over, since the write may copy the chunk being read
+            mVertices[from].increment_visitor_flag();
+            return std::make_tuple(current, next);
         }
         return std::make_tuple(-1, -1); // return invalid tuple if no other case is matched
     }
@@ -571,15 +1682,15 @@ public:
      *       Currently do not have a count for specific edges of From to To, only count of From
      *       How would we even represent this though? if From has multiple edges
      */
-    tuple<int, int> edge_count(int count, string from, string to){
+    tuple<int, int> edge_count(int count, const string & from, const string & to){
         int current = 0, next = 0;
-        for(auto vertex : mVertices){
-            for(auto adj : mVertices[vertex.first].get_adj_list()){
+        for(auto const & vertex : vertices()){
+            for(auto const & adj : vertex.second.adjacencies()){
                 if(current > 0){ // record the next count
-                    //next = mVertices[vertex.first].get_kmer_occurrences();
+                    //next = vertex.second.get_kmer_occurrences();
                     return std::make_tuple(current, next);
                 }
-                if(mVertices[vertex.first].get_kmer_occurrences()==count && mVertices[vertex.first].get_visitor_flag()<mVertices[vertex.first].adj_list_size() && vertex.first==from && adj==to){ // match current count
+                if(vertex.second.get_kmer_occurrences()==count && vertex.second.get_visitor_flag()<vertex.second.adj_list_size() && vertex.first==from && adj==to){ // match current count
                     //current = count;
                     //mVertices[vertex.first].increment_visitor_flag();
                 }
@@ -599,15 +1710,15 @@ public:
      * @param to current adjacency of current vertex
      * @return tuple<string, string> current and next IDs for the kmer of the vertex
      */
-    tuple<string, string> from(int count, string from, string to){
+    tuple<string, string> from(int count, const string & from, const string & to){
         string current = "", next = "";
-        for(auto vertex : mVertices){
-            for(auto adj : mVertices[vertex.first].get_adj_list()){
+        for(auto const & vertex : vertices()){
+            for(auto const & adj : vertex.second.adjacencies()){
                 if(!current.empty()){ //same pattern as above
                     next = vertex.first;
                     return std::make_tuple(current, next);
                 }
-                if(vertex.first==from && mVertices[vertex.first].get_visitor_flag()<=mVertices[vertex.first].adj_list_size() && adj==to){ //on 123
+                if(vertex.first==from && vertex.second.get_visitor_flag()<=vertex.second.adj_list_size() && adj==to){ //on 123
                     current = from;
                 }
             }
@@ -626,11 +1737,12 @@ public:
      * @param to current adjacency of current vertex
      * @return tuple<string, string> current and next adjacencies to the current vertex
      */
-    tuple<string, string> to(int count, string from, string to){
+    tuple<string, string> to(int count, const string & from, const string & to){
         if(count == -1 && from.empty()){ //if this is the last edge in the whole graph iteration
             return std::make_tuple(to, "");
         }
-        return std::make_tuple(to, mVertices[from].get_adj_list()[mVertices[from].get_visitor_flag()]);
+        const DBGraphValue & value = mVertices[from];
+        return std::make_tuple(to, value.adjacency(value.get_visitor_flag()));
     }
 
 ///@remark GETTERS AND SETTERS /////////////////////////////////////////////////////////////
@@ -639,81 +1751,263 @@ public:
      * Return size of graph (NOT the total number of sequences in the pangenome)
      * @return number of vertices the graph contains
      */
-    int get_size() { return mSize; }
+    int get_size() const { return int(mVertices.size()); }
 
     /**
      * Return sequence size of graph
      * @return number of sequences the graph has added into the total pangenome
      */
-    int get_sequence_size() { return mSeqSize; }
+    int get_sequence_size() const { return mSeqSize; }
 
     /**
      * Return sequence size of graph
      * @return number of sequences the graph has added into the total pangenome
      */
-    int get_kmer_len() { return mKmerLength; }
+    int get_kmer_len() const { return mKmerLength; }
+
+    /**
+     * Return the length of the most recently added sequence (the length new genomes are built to)
+     * @return sequence length
+     */
+    int get_sequence_length() const { return mSequenceLength; }
 
     /**
      * @return int number of edges in the graph
      */
-    int edge_count(){
-        int count = 0;
-        for(auto i : mVertices){
-            count += i.second.adj_list_size();
-        }
-        return count;
-    }
+    int edge_count() const { return int(mStats.edges); }
 
     /**
-     * Return vector containing all vertices in graph
-     * @return vector containing all DeBruijn vertex objects
+     * Summary statistics (vertices, edges, branch points, out-degree histogram, endpoints, k-mer occurrences
+     * and their entropy), kept up to date as sequences are added and removed
+     * @return statistics of the graph as it is now
      */
-    vector<string> get_all_vertices() {
+    const DeBruijnStatistics & statistics() const { return mStats; }
+
+    /**
+     * Return vector containing all vertices in graph (for_each_vertex visits them without building it)
+     * @return vector containing all DeBruijn vertex objects, sorted whatever the vertex store
+     */
+    vector<string> get_all_vertices() const {
         vector<string> all_vertices;
         for (auto const& element : mVertices) {
             all_vertices.push_back(element.first);
         }
+        if(!VertexStoreT::ORDERED){
+            std::sort(all_vertices.begin(), all_vertices.end());
+        }
         return all_vertices; 
     }
 
     /**
-     * Return vector containing vertices with more than one adjacency in graph
+     * Call a function on every vertex in the vertex store's own order, without building a list of vertices first
+     * @param func lambda taking (const string & kmer, const DBGraphValue & value)
+     */
+    template <typename FuncType>
+    void for_each_vertex(FuncType func) const {
+        for(auto const & vertex : mVertices){
+            func(vertex.first, vertex.second);
+        }
+    }
+
+    /**
+     * Look up a vertex without copying or inserting it
+     * @param vertex to look up
+     * @return the vertex's value, or nullptr if it is not in the graph (valid until the graph changes)
+     */
+    const DBGraphValue * find_value(std::string_view vertex) const { return mVertices.lookup(vertex); }
+
+    /**
+     * Read a vertex's value in place, without copying or inserting it
+     * @param vertex to look up
+     * @return the vertex's value, or an empty value if it is not in the graph (valid until the graph changes)
+     */
+    const DBGraphValue & value_of(std::string_view vertex) const {
+        static const DBGraphValue empty;
+        const DBGraphValue * value = mVertices.lookup(vertex);
+        return value == nullptr ? empty : *value;
+    }
+
+    /**
+     * Read a vertex's adjacency list in place
+     * @param vertex to look up
+     * @return its adjacencies, or an empty list if it is not in the graph (valid until the graph changes)
+     */
+    const vector<string> & adjacencies(std::string_view vertex) const { return value_of(vertex).adjacencies(); }
+
+    /**
+     * Check whether a k-mer is a vertex, asking the prefilter first if it is on
+     * @param kmer to look up
+     * @return true if the k-mer is in the graph
+     */
+    bool contains(std::string_view kmer) const {
+        if(mPrefilter.enabled() && !mPrefilter.may_contain(CountingBloomFilter::kmer_hash(kmer))){
+            return false;
+        }
+        bool found = mVertices.lookup(kmer) != nullptr;
+        if(!found && mPrefilter.enabled()){
+            mPrefilter.record_false_positive();
+        }
+        return found;
+    }
+
+///@remark CYCLE STRUCTURE /////////////////////////////////////////////////////////////
+
+    /**
+     * @return a number that changes whenever a vertex or edge changes (copies start from their source's)
+     */
+    uint64_t version() const { return mVersion; }
+
+    /**
+     * Strongly connected components and condensation of the graph (see ComponentIndex). The index is built on
+     * the first call after the graph changes and shared until the next change, so it can be asked for every
+     * generation; an index already handed out stays valid, describing the graph as it was.
+     * @return the index of the graph as it is now
+     */
+    std::shared_ptr<const ComponentIndex> components() const {
+        std::shared_ptr<const ComponentIndex> cached = std::atomic_load(&mComponents);
+        if(!cached || cached->version() != mVersion){
+            cached = std::make_shared<const ComponentIndex>(*this);
+            std::atomic_store(&mComponents, cached);
+        }
+        return cached;
+    }
+
+///@remark PREFILTER /////////////////////////////////////////////////////////////
+
+    /**
+     * Put a counting Bloom filter in front of the vertex store, so is_valid and contains can reject most novel
+     * genomes and k-mers without a lookup. The filter is filled from the current graph and kept in step with
+     * every later change; it only ever answers "no" for things that really are absent.
+     * @param expected_keys number of vertices plus edges the graph is expected to reach (0 for twice the current count)
+     * @param false_positive_rate target rate of novel edges and k-mers let through at that size
+     */
+    void enable_prefilter(size_t expected_keys = 0, double false_positive_rate = 0.01){
+        if(expected_keys == 0){
+            expected_keys = 2 * size_t(mStats.vertices + mStats.edges);
+        }
+        mPrefilter.reset(expected_keys, false_positive_rate);
+        for(auto const & vertex : vertices()){   // read-only walk: a COW clone keeps sharing its chunks
+            mPrefilter.insert(CountingBloomFilter::kmer_hash(vertex.first));
+            for(auto const & adj : vertex.second.adjacencies()){
+                mPrefilter.insert(CountingBloomFilter::edge_hash(vertex.first, adj.back()));
+            }
+        }
+    }
+
+    /**
+     * Take the prefilter away and free its counters
+     */
+    void disable_prefilter(){ mPrefilter.clear(); }
+
+    /**
+     * @return the prefilter, to read its query counters and false-positive rates
+     */
+    const CountingBloomFilter & prefilter() const { return mPrefilter; }
+
+    /**
+     * Return vector containing vertices with more than one adjacency in graph, in no particular order
      * @return vector containing branched DeBruijn vertex objects
      */
-    vector<string> get_branch_vertices() { return mBranchedVertices; }
+    vector<string> get_branch_vertices() const { return mBranchedVertices; }
+
+    /**
+     * Read the branch vertices in place, without copying them
+     * @return vertices with more than one adjacency (valid until the graph changes)
+     */
+    const vector<string> & branch_vertices() const { return mBranchedVertices; }
 
     /**
      * Return vector containing vertices that represent the beginning(s) of the graph
      * @return vector containing beginning DeBruijn vertex objects
      */
-    vector<string> get_start_vertices() { return mStarts; }
+    vector<string> get_start_vertices() const { return mStarts; }
+
+    /**
+     * Read the start vertices in place, without copying them
+     * @return vertices that begin a sequence (valid until the graph changes)
+     */
+    const vector<string> & start_vertices() const { return mStarts; }
 
     /**
      * Given a vertex, retrun true if the vertex branches
      * @param vertex to check
      * @return true if the vertex has more than 2 verticies in it's adjacency list
      */
-    bool vertex_branch_check(string vertex) { return mVertices[vertex].get_branch(); }
+    bool vertex_branch_check(std::string_view vertex) const { return value_of(vertex).get_branch(); }
 
     /**
-     * Get the value associated with a vertex
-     * @return Debruijn vertex value object
+     * Get a copy of the value associated with a vertex without inserting it (value_of reads it in place)
+     * @return Debruijn vertex value object (default-constructed if the vertex is not in the graph)
      */
-    DBGraphValue get_value(string vertex) { return mVertices[vertex]; }
+    DBGraphValue get_value(std::string_view vertex) const { return value_of(vertex); }
 
     /**
      * Set the availible adj list object to have all adjacencies possible
      * @param kmer we are currently adding
      */
-    void set_avail_adj_list(string kmer) { mVertices[kmer].set_adj_availible(); }
+    void set_avail_adj_list(const string & kmer) {
+        update_lists(kmer, [] (DBGraphValue & value) { value.set_adj_availible(); });
+    }
 
     /**
      * Remove an adjacency from availible adj list
      * @param kmer we are adjusting the value of
      * @param adj string we are removing
      */
-    void remove_avail_adj_list(string kmer, int adj) { mVertices[kmer].remove_adj_availible(mVertices[kmer].get_adj_availible(0)); }
+    void remove_avail_adj_list(const string & kmer, int adj) {
+        update_lists(kmer, [] (DBGraphValue & value) { value.remove_adj_availible(value.get_adj_availible(0)); });
+    }
+
+///@remark MEMORY ACCOUNTING /////////////////////////////////////////////////////////////
+
+    /**
+     * Estimate how much memory the graph is using, without traversing it
+     * @return breakdown of bytes by category
+     */
+    DeBruijnMemoryUsage memory_usage() const {
+        DeBruijnMemoryUsage usage;
+        size_t kmer_bytes = string_footprint(mKmerLength);
+        size_t kmer_heap_bytes = kmer_bytes - sizeof(string);
+        size_t vertex_count = mVertices.size();
+        usage.vertex_keys = vertex_count * kmer_bytes;
+        usage.vertex_values = vertex_count * sizeof(DBGraphValue);
+        usage.adjacency = mAdjacencyEntries * kmer_bytes;
+        usage.available = mAvailableEntries * kmer_bytes;
+        usage.edge_counts = mEdgeCountEntries * (OrderedVertexStore::NODE_OVERHEAD_BYTES + kmer_bytes + sizeof(int));
+        usage.starts = mStarts.size() * kmer_bytes;
+        // each position entry is a hash node: next link, key, position and the cached hash
+        usage.branch_index = mBranchedVertices.size() * kmer_bytes
+            + mBranchPositions.size() * (sizeof(void *) + kmer_bytes + 2 * sizeof(size_t));
+        usage.store_overhead = mVertices.overhead_bytes();
+        usage.paths = mPaths->memory_bytes();
+        usage.prefilter = mPrefilter.memory_bytes();
+        usage.genomes = mGenomes->memory_bytes();
+
+        // the store's own allocations and one per edge-count or branch-position node, plus roughly one adjacency
+        // buffer per vertex
+        size_t allocations = vertex_count + mEdgeCountEntries + mBranchPositions.size() + mVertices.allocation_count();
+        if(kmer_heap_bytes > 0){ // every k-mer string also has its own buffer
+            allocations += vertex_count + mAdjacencyEntries + mAvailableEntries + mEdgeCountEntries
+                + mStarts.size() + mBranchedVertices.size() + mBranchPositions.size();
+        }
+        usage.allocator_overhead = allocations * ALLOCATION_HEADER_BYTES;
+        return usage;
+    }
+
+    /**
+     * Get the largest estimated footprint since the last reset (e.g. the peak of this generation)
+     * @return bytes
+     */
+    size_t get_memory_high_water() const { return std::max(mMemoryHighWater, memory_usage().total()); }
+
+    /**
+     * Start a new high-water period, such as at the beginning of a generation
+     */
+    void reset_memory_high_water() { mMemoryHighWater = memory_usage().total(); }
 
 };
 
+/// The graph used throughout the module, backed by the copy-on-write vertex store
+using DeBruijnGraph = BasicDeBruijnGraph<CowVertexStore>;
+
 #endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_DEBRUIJNGRAPH_H
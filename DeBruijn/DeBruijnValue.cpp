@@ -85,3 +85,32 @@ TEST_CASE("DeBruijnValue__adj-lists", "[DeBruijnValue.hpp]")
         CHECK( 1 == 1 );
     }
 }
+
+TEST_CASE("DeBruijnValue__edge-counts", "[DeBruijnValue.hpp]")
+{
+    {
+        DBGraphValue value;
+        value.increment_edge_count("234");
+        value.increment_edge_count("234");
+        value.increment_edge_count("235");
+        CHECK(value.get_edge_count("234") == 2);
+        CHECK(value.edge_count_size() == 2);
+        CHECK(value.decrement_edge_count("234") == 1);
+        CHECK(value.decrement_edge_count("235", 2) == -1);
+        CHECK(value.get_edge_count("235") == 0);
+        CHECK(value.edge_count_size() == 1);
+        CHECK(value.decrement_edge_count("999") == -1);
+
+        // in-place reads: string_view arguments and references into the value
+        string buffer = "[234]";
+        CHECK(value.get_edge_count(std::string_view(buffer).substr(1, 3)) == 1);
+        value.add_to_adj_list("235");
+        value.add_to_adj_list("234");
+        value.set_adj_availible();
+        CHECK(&value.adjacency(1) == &value.adjacencies()[1]);
+        CHECK(value.adjacency(0) == "234");
+        CHECK(value.valid_adj(std::string_view(buffer).substr(1, 3)));
+        CHECK(!value.valid_adj("999"));
+        CHECK(value.available_adjacencies() == value.adjacencies());
+    }
+}
@@ -11,6 +11,7 @@
 #define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_DEBRUIJNVALUE_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <iterator>
@@ -26,8 +27,8 @@ private:
     /// Adjacency list--vector of all verticies this vertex points to
     vector<string> mAdjList = {};
 
-    /// Count of specific edges in graph
-    std::map<string, int> mEdgeCount = {};
+    /// Count of specific edges in graph: how many times each outgoing edge is used by the sequences in the graph
+    std::map<string, int, std::less<>> mEdgeCount = {};
 
     /// Adjacencies availible to use in genome modification
     vector<string> mAvailableAdj = {};
@@ -66,18 +67,31 @@ public:
      */
     vector<string> get_adj_list() const{ return mAdjList; }
 
+    /**
+     * Read the adjacency list in place, without copying it
+     * @return vector of adjacent verticies (valid until the vertex changes)
+     */
+    const vector<string> & adjacencies() const { return mAdjList; }
+
     /**
      * Get the adjacent DeBruijn Vertex
      * @param index at which to pull the vertex from
      * @return string reresenting kmer adjacency 
      */
-    string get_adjacency(int index) { return mAdjList[index]; }
+    string get_adjacency(int index) const { return mAdjList[index]; }
+
+    /**
+     * Read one adjacency in place, without copying it
+     * @param index at which to pull the vertex from
+     * @return string reresenting kmer adjacency (valid until the vertex changes)
+     */
+    const string & adjacency(size_t index) const { return mAdjList[index]; }
 
     /**
      * Return size of adjacency list
      * @return size
      */
-    int adj_list_size(){ return mAdjList.size(); }
+    int adj_list_size() const { return mAdjList.size(); }
 
     /**
      * Add to adjacency list (creates edge)
@@ -98,12 +112,54 @@ public:
         mAdjList.erase(std::remove(mAdjList.begin(), mAdjList.end(), removal), mAdjList.end());
     }
 
+    /**
+     * Count more uses of the edge to an adjacency
+     * @param adj vertex the edge points to
+     * @param amount number of uses to add
+     */
+    void increment_edge_count(const string & adj, int amount = 1) { mEdgeCount[adj] += amount; }
+
+    /**
+     * Count fewer uses of the edge to an adjacency, forgetting the edge once it is unused
+     * @param adj vertex the edge points to
+     * @param amount number of uses to take away
+     * @return number of uses left (0 or less means no sequence uses the edge any more)
+     */
+    int decrement_edge_count(const string & adj, int amount = 1) {
+        auto it = mEdgeCount.find(adj);
+        if (it == mEdgeCount.end()){
+            return -amount;
+        }
+        it->second -= amount;
+        int remaining = it->second;
+        if (remaining <= 0){
+            mEdgeCount.erase(it);
+        }
+        return remaining;
+    }
+
+    /**
+     * Get the number of times the edge to an adjacency is used
+     * @param adj vertex the edge points to
+     * @return number of uses (0 if the edge is not counted)
+     */
+    int get_edge_count(std::string_view adj) const {
+        auto it = mEdgeCount.find(adj);
+        return it == mEdgeCount.end() ? 0 : it->second;
+    }
+
+    /**
+     * Return the number of edges with a use count
+     * @return size of the edge count map
+     */
+    int edge_count_size() const { return mEdgeCount.size(); }
+
     /**
      * Check to see whether this vertex-to-adjacency path is valid
      * @param adj adjacency to check
      * @return true if the adjacency is in the adj_list for this vertex
      */
-    bool valid_adj(string adj){
+    bool valid_adj(std::string_view adj) const {
         if (std::find(mAdjList.begin(), mAdjList.end(), adj) != mAdjList.end()){
             return true;
         }
@@ -114,7 +170,7 @@ public:
      * Get the visitor flag object
      * @return true if this vertex has already been visited in a traversal
      */
-    int get_visitor_flag(){ return mVisits; }
+    int get_visitor_flag() const { return mVisits; }
 
     /**
      * Set visitor flag
@@ -139,7 +195,7 @@ public:
      * Get the branch truth value
      * @return true if there is more than one value in the adjacency list
      */
-    bool get_branch() { return mContainsBranch; }
+    bool get_branch() const { return mContainsBranch; }
 
     /**
      * Set the bool for whether the adjacency list is empty
@@ -151,13 +207,13 @@ public:
      * Get the empty_adj_list truth value
      * @return 2 if unassigned, 1 if list contains either nothing or an empty vertex, 0 if no empty vertex
      */
-    int get_empty_bool() { return mEmptyAdjList; }
+    int get_empty_bool() const { return mEmptyAdjList; }
 
     /**
      * Get the count of kmer occurrences in the pangenome
      * @return number of sequences this kmer is  used in
      */
-    int get_kmer_occurrences() { return mKmerOccurrences; }
+    int get_kmer_occurrences() const { return mKmerOccurrences; }
 
     /**
      * Increment number of sequences this kmer is  used in
@@ -166,8 +222,9 @@ public:
 
     /**
      * Decrement number of sequences this kmer is  used in
+     * @param amount number of uses to take away
      */
-    void decrement_kmer_occurrences() { mKmerOccurrences--; }
+    void decrement_kmer_occurrences(int amount = 1) { mKmerOccurrences -= amount; }
 
     /**
      * Set the available adjacencies to be all adjacencies of vertex
@@ -190,13 +247,19 @@ public:
      * @param index of adjacency
      * @return string kmer
      */
-    string get_adj_availible(int index) { return mAvailableAdj[index]; }
+    string get_adj_availible(int index) const { return mAvailableAdj[index]; }
+
+    /**
+     * Read the available adjacencies in place, without copying them
+     * @return vector of kmers still available (valid until the vertex changes)
+     */
+    const vector<string> & available_adjacencies() const { return mAvailableAdj; }
 
     /**
      * Get the number of adjacencies that are still valid&available to append to a new genome
      * @return int 
      */
-    int adj_availible_size() { return mAvailableAdj.size(); }
+    int adj_availible_size() const { return mAvailableAdj.size(); }
 
     /**
      * When we've used a kmer in a new genome as many times it appears in our sequences, we want to make it unavailable for further use
@@ -216,7 +279,7 @@ public:
      * Get the endpoint truth value
      * @return the number of times the vertex has been observed to be an enpoint
      */
-    int get_endpoint() { return mEndpoint; }
+    int get_endpoint() const { return mEndpoint; }
 
     /**
      * Append to the times this vertex is an endpoint if it has been observed ending another sequence
@@ -226,8 +289,9 @@ public:
     /**
      * Decrement the times this vertex is an endpoint the 
      * sequence it is in is being removed
+     * @param amount number of sequences being removed that end here
      */
-    void decrement_endpoint() { mEndpoint--; }
+    void decrement_endpoint(int amount = 1) { mEndpoint -= amount; }
 
 };
 
@@ -0,0 +1,89 @@
+/**
+ * @file GenomeFingerprint.cpp
+ * @author Anna Catenacci
+ */
+
+#include "GenomeFingerprint.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <string>
+#include <set>
+#include <utility>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("GenomeFingerprint__fingerprints", "[GenomeFingerprint.hpp]")
+{
+    {
+        // built symbol by symbol or all at once, the fingerprint is the same
+        FingerprintBuilder builder;
+        builder.append("0110");
+        builder.append('1');
+        CHECK(builder.finish() == FingerprintBuilder::of("01101"));
+        CHECK(FingerprintBuilder::of("") == FingerprintBuilder().finish());
+
+        // replacing symbols and joining builders give the fingerprint of the resulting genome
+        std::string long_genome(1000, '0');
+        for(size_t i = 0; i < long_genome.size(); ++i){
+            long_genome[i] = char('0' + (i * i) % 7);
+        }
+        FingerprintBuilder edited;
+        edited.append(long_genome);
+        std::string mutated = long_genome;
+        for(size_t site : {size_t(0), size_t(517), size_t(999)}){
+            edited.replace(site, mutated[site], 'x');
+            mutated[site] = 'x';
+        }
+        CHECK(edited.finish() == FingerprintBuilder::of(mutated));
+        FingerprintBuilder head, tail;
+        head.append(std::string_view(long_genome).substr(0, 300));
+        tail.append(std::string_view(long_genome).substr(300));
+        head.append(tail);
+        CHECK(head.finish() == FingerprintBuilder::of(long_genome));
+        FingerprintBuilder empty;
+        empty.append(FingerprintBuilder());
+        CHECK(empty.finish() == FingerprintBuilder::of(""));
+
+        // length, order and leading zeros all matter
+        CHECK(FingerprintBuilder::of("0") != FingerprintBuilder::of("00"));
+        CHECK(FingerprintBuilder::of("01") != FingerprintBuilder::of("10"));
+        CHECK(FingerprintBuilder::of("") != FingerprintBuilder::of("0"));
+
+        // no collisions among many similar genomes
+        emp::Random random(12);
+        std::set<std::pair<uint64_t, uint64_t>> seen;
+        std::set<std::string> genomes;
+        std::string parent(200, '0');
+        for(int i = 0; i < 20000; ++i){
+            std::string genome = parent;
+            for(int m = 0; m < 3; ++m){
+                genome[random.GetUInt(genome.size())] = random.P(0.5) ? '1' : '0';
+            }
+            GenomeFingerprint fingerprint = FingerprintBuilder::of(genome);
+            if(genomes.insert(genome).second){
+                CHECK(seen.insert({fingerprint.high, fingerprint.low}).second);
+            }
+        }
+    }
+}
+
+TEST_CASE("GenomeFingerprint__multiset", "[GenomeFingerprint.hpp]")
+{
+    {
+        GenomeMultiset genomes;
+        GenomeFingerprint a = FingerprintBuilder::of("0101"), b = FingerprintBuilder::of("0110");
+        genomes.insert(a);
+        genomes.insert(a);
+        genomes.insert(b);
+        CHECK(genomes.size() == 3);
+        CHECK(genomes.distinct() == 2);
+        CHECK(genomes.count(a) == 2);
+        CHECK(genomes.erase(a));
+        CHECK(genomes.contains(a));
+        CHECK(genomes.erase(a));
+        CHECK(!genomes.contains(a));
+        CHECK(!genomes.erase(a));
+        CHECK(genomes.count(a) == 0);
+        CHECK(genomes.size() == 1);
+        CHECK(genomes.memory_bytes() > 0);
+    }
+}
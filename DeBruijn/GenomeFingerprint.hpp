@@ -0,0 +1,234 @@
+/**
+ * @file GenomeFingerprint.hpp
+ * @author Anna Catenacci
+ *
+ * 128-bit fingerprints of whole genomes, and a multiset of them, so a DeBruijnGraph can say whether a genome
+ * is carried by a living organism (is_valid only says that its path exists, which it may for a genome nobody has).
+ *
+ * A fingerprint is two polynomial hashes of the genome's symbols modulo the prime 2^61 - 1, with different
+ * bases, combined with the genome's length. It is built one symbol at a time, so add_sequence, remove_sequence,
+ * add_sequences and remove_sequences compute it in the same pass that walks a genome's k-mers. Because the
+ * hashes are polynomials, a symbol can also be swapped out, or two builders joined, with one precomputed power
+ * of each base: update_sequence hashes the old genome while it compares it with the new one, then turns that
+ * into the new genome's fingerprint at the changed sites only. Two different genomes of length L share a
+ * fingerprint with probability about (L / 2^61)^2.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GENOMEFINGERPRINT_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GENOMEFINGERPRINT_H
+
+#include <unordered_map>
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+struct GenomeFingerprint {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const GenomeFingerprint & other) const { return high == other.high && low == other.low; }
+    bool operator!=(const GenomeFingerprint & other) const { return !(*this == other); }
+
+    /// Hash for unordered containers
+    struct Hash {
+        size_t operator()(const GenomeFingerprint & fingerprint) const {
+            return size_t(fingerprint.low ^ (fingerprint.high * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+};
+
+/**
+ * Builds a GenomeFingerprint one symbol at a time
+ */
+class FingerprintBuilder {
+private:
+    static constexpr uint64_t PRIME = (uint64_t(1) << 61) - 1;
+    static constexpr uint64_t HIGH_BASE = 0x1F3D5B79A2C4E681ULL % PRIME;
+    static constexpr uint64_t LOW_BASE = 0x0B7E151628AED2A7ULL % PRIME;
+
+    uint64_t mHigh = 0;
+    uint64_t mLow = 0;
+    uint64_t mLength = 0;
+
+    /**
+     * @return (a * b) mod 2^61 - 1, for a and b below 2^61 - 1
+     */
+    static uint64_t multiply(uint64_t a, uint64_t b){
+        unsigned __int128 product = (unsigned __int128)a * b;
+        uint64_t folded = uint64_t(product & PRIME) + uint64_t(product >> 61);
+        return folded >= PRIME ? folded - PRIME : folded;
+    }
+
+    /**
+     * @return (a + b) mod 2^61 - 1, for a and b below 2^61 - 1
+     */
+    static uint64_t add(uint64_t a, uint64_t b){
+        uint64_t sum = a + b;
+        return sum >= PRIME ? sum - PRIME : sum;
+    }
+
+    /**
+     * @return hash * base + symbol, mod 2^61 - 1
+     */
+    static uint64_t step(uint64_t hash, uint64_t base, char symbol){
+        return add(multiply(hash, base), uint8_t(symbol) + 1);
+    }
+
+    /**
+     * @return BASE^exponent mod 2^61 - 1, multiplied together from the precomputed BASE^(2^j)
+     */
+    template <uint64_t BASE>
+    static uint64_t power(uint64_t exponent){
+        static const std::array<uint64_t, 64> squares = [] {
+            std::array<uint64_t, 64> table{};
+            table[0] = BASE;
+            for(size_t j = 1; j < table.size(); ++j){
+                table[j] = multiply(table[j-1], table[j-1]);
+            }
+            return table;
+        }();
+        uint64_t result = 1;
+        for(size_t j = 0; exponent != 0; ++j, exponent >>= 1){
+            if(exponent & 1){
+                result = multiply(result, squares[j]);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @return hash with the term of old_symbol at weight `weight` swapped for new_symbol
+     */
+    static uint64_t swap_term(uint64_t hash, uint64_t weight, char old_symbol, char new_symbol){
+        return add(add(hash, multiply(weight, uint8_t(new_symbol) + 1)), PRIME - multiply(weight, uint8_t(old_symbol) + 1));
+    }
+
+public:
+    /**
+     * @param symbol next symbol of the genome
+     */
+    void append(char symbol){
+        mHigh = step(mHigh, HIGH_BASE, symbol);
+        mLow = step(mLow, LOW_BASE, symbol);
+        mLength++;
+    }
+
+    /**
+     * @param symbols next symbols of the genome
+     */
+    void append(std::string_view symbols){
+        for(char symbol : symbols){
+            append(symbol);
+        }
+    }
+
+    /**
+     * @param other builder whose symbols come next in the genome
+     */
+    void append(const FingerprintBuilder & other){
+        mHigh = add(multiply(mHigh, power<HIGH_BASE>(other.mLength)), other.mHigh);
+        mLow = add(multiply(mLow, power<LOW_BASE>(other.mLength)), other.mLow);
+        mLength += other.mLength;
+    }
+
+    /**
+     * Change one symbol that has already been appended, without hashing the others again
+     * @param position index of the symbol among those appended
+     * @param old_symbol the symbol appended there
+     * @param new_symbol the symbol it becomes
+     */
+    void replace(size_t position, char old_symbol, char new_symbol){
+        uint64_t exponent = mLength - 1 - position;
+        mHigh = swap_term(mHigh, power<HIGH_BASE>(exponent), old_symbol, new_symbol);
+        mLow = swap_term(mLow, power<LOW_BASE>(exponent), old_symbol, new_symbol);
+    }
+
+    /**
+     * @return fingerprint of the symbols appended so far
+     */
+    GenomeFingerprint finish() const {
+        return GenomeFingerprint{mHigh ^ (mLength << 61) ^ (mLength >> 3), mLow};
+    }
+
+    /**
+     * @param genome whole genome
+     * @return its fingerprint
+     */
+    static GenomeFingerprint of(std::string_view genome){
+        FingerprintBuilder builder;
+        builder.append(genome);
+        return builder.finish();
+    }
+};
+
+/**
+ * Number of copies of each genome, by fingerprint
+ */
+class GenomeMultiset {
+private:
+    std::unordered_map<GenomeFingerprint, uint32_t, GenomeFingerprint::Hash> mCounts;
+
+    /// Copies held, over all genomes
+    size_t mTotal = 0;
+
+public:
+    /**
+     * @param fingerprint genome to add a copy of
+     */
+    void insert(const GenomeFingerprint & fingerprint){
+        mCounts[fingerprint]++;
+        mTotal++;
+    }
+
+    /**
+     * @param fingerprint genome to take a copy of out
+     * @return false if there was no copy of it
+     */
+    bool erase(const GenomeFingerprint & fingerprint){
+        auto it = mCounts.find(fingerprint);
+        if(it == mCounts.end()){
+            return false;
+        }
+        if(--it->second == 0){
+            mCounts.erase(it);
+        }
+        mTotal--;
+        return true;
+    }
+
+    /**
+     * @param fingerprint genome
+     * @return number of copies held
+     */
+    uint32_t count(const GenomeFingerprint & fingerprint) const {
+        auto it = mCounts.find(fingerprint);
+        return it == mCounts.end() ? 0 : it->second;
+    }
+
+    /**
+     * @param fingerprint genome
+     * @return true if at least one copy is held
+     */
+    bool contains(const GenomeFingerprint & fingerprint) const { return mCounts.count(fingerprint) > 0; }
+
+    /**
+     * @return number of copies held, over all genomes
+     */
+    size_t size() const { return mTotal; }
+
+    /**
+     * @return number of different genomes held
+     */
+    size_t distinct() const { return mCounts.size(); }
+
+    /**
+     * @return estimated bytes used (bucket array plus one node per genome)
+     */
+    size_t memory_bytes() const {
+        return mCounts.bucket_count() * sizeof(void *)
+            + mCounts.size() * (sizeof(void *) + sizeof(size_t) + sizeof(GenomeFingerprint) + sizeof(uint64_t));
+    }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GENOMEFINGERPRINT_H
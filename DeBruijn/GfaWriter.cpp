@@ -0,0 +1,161 @@
+/**
+ * @file GfaWriter.cpp
+ * @author Anna Catenacci
+ */
+
+#include "GfaWriter.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <sstream>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Records of one type ("S", "L" or "P"), each split into its fields
+    vector<vector<string>> records(const string & gfa, const string & type){
+        vector<vector<string>> found;
+        std::stringstream lines(gfa);
+        for(string line; std::getline(lines, line); ){
+            vector<string> fields;
+            std::stringstream split(line);
+            for(string field; std::getline(split, field, '\t'); ){
+                fields.push_back(field);
+            }
+            if(!fields.empty() && fields[0] == type){
+                found.push_back(fields);
+            }
+        }
+        return found;
+    }
+
+    /// Spell a genome back out of its path through the segments (links overlap by k - 1)
+    string spell(const string & gfa, const vector<string> & path, int kmer_length){
+        map<string, string> sequences;
+        for(auto const & segment : records(gfa, "S")){
+            sequences[segment[1]] = segment[2];
+        }
+        string genome;
+        std::stringstream steps(path[2]);
+        for(string step; std::getline(steps, step, ','); ){
+            string sequence = sequences[step.substr(0, step.size() - 1)];
+            genome += genome.empty() ? sequence : sequence.substr(kmer_length - 1);
+        }
+        return genome;
+    }
+}
+
+TEST_CASE("GfaWriter__kmer-segments", "[GfaWriter.hpp]")
+{
+    {
+        DeBruijnGraph graph;
+        vector<string> genomes = {"12345678", "12345000"};
+        for(auto const & genome : genomes){
+            graph.add_sequence(genome);
+        }
+        std::stringstream out;
+        GfaWriter(out, 16).write(graph, GfaSegments::KMER, &genomes);
+        string gfa = out.str();
+        CHECK(gfa.substr(0, 11) == "H\tVN:Z:1.0\n");
+        vector<vector<string>> segments = records(gfa, "S");
+        CHECK(int(segments.size()) == graph.get_size());
+        for(auto const & segment : segments){
+            CHECK(segment[1] == segment[2]);
+            CHECK(segment[3] == "KC:i:" + std::to_string(graph.get_value(segment[1]).get_kmer_occurrences()));
+        }
+        vector<vector<string>> links = records(gfa, "L");
+        CHECK(int(links.size()) == graph.edge_count());
+        CHECK(links[0][5] == "2M");
+        vector<vector<string>> paths = records(gfa, "P");
+        REQUIRE(paths.size() == 2);
+        CHECK(spell(gfa, paths[0], 3) == genomes[0]);
+        CHECK(spell(gfa, paths[1], 3) == genomes[1]);
+    }
+}
+
+TEST_CASE("GfaWriter__unitig-segments", "[GfaWriter.hpp]")
+{
+    {
+        DeBruijnGraph graph;
+        vector<string> genomes = {"12345678", "12345000", "99945000", "0120120"};
+        for(auto const & genome : genomes){
+            graph.add_sequence(genome);
+        }
+        std::stringstream out;
+        GfaWriter(out).write(graph, GfaSegments::UNITIG, &genomes);
+        string gfa = out.str();
+        vector<vector<string>> segments = records(gfa, "S");
+        // 123-234-345 | 456-567-678 | 999-994-945 | 450-500-000 | 012-120 | 201, the cycle being broken
+        // where 0120120 starts (012) and ends (120)
+        CHECK(segments.size() == 6);
+        size_t kmers = 0;
+        long long count = 0;
+        for(auto const & segment : segments){
+            kmers += segment[2].size() - 2;
+            count += std::stoll(segment[3].substr(5));
+        }
+        CHECK(int(kmers) == graph.get_size());
+        CHECK(count == graph.statistics().total_occurrences);
+        // links only leave the ends of unitigs: 345->456, 345->450, 945->450, 120->201 and 201->012
+        CHECK(records(gfa, "L").size() == 5);
+        vector<vector<string>> paths = records(gfa, "P");
+        REQUIRE(paths.size() == genomes.size());
+        for(size_t i = 0; i < genomes.size(); ++i){
+            CHECK(spell(gfa, paths[i], 3) == genomes[i]);
+        }
+        CHECK(paths[3][2] == "012+,201+,012+");
+
+        // genomes that start and end inside what would otherwise be one unitig
+        DeBruijnGraph shifted;
+        vector<string> shifted_genomes = {"0123456", "1234567"};
+        for(auto const & genome : shifted_genomes){
+            shifted.add_sequence(genome);
+        }
+        std::stringstream shifted_out;
+        GfaWriter(shifted_out).write(shifted, GfaSegments::UNITIG, &shifted_genomes);
+        string shifted_gfa = shifted_out.str();
+        // 012 | 123-234-345-456 | 567
+        CHECK(records(shifted_gfa, "S").size() == 3);
+        vector<vector<string>> shifted_paths = records(shifted_gfa, "P");
+        REQUIRE(shifted_paths.size() == 2);
+        CHECK(shifted_paths[0][2] == "012+,123+");
+        CHECK(shifted_paths[1][2] == "123+,567+");
+        for(size_t i = 0; i < shifted_genomes.size(); ++i){
+            CHECK(spell(shifted_gfa, shifted_paths[i], 3) == shifted_genomes[i]);
+        }
+        // without paths the unitig is left whole
+        std::stringstream whole_out;
+        GfaWriter(whole_out).write(shifted, GfaSegments::UNITIG);
+        CHECK(records(whole_out.str(), "S").size() == 1);
+
+        // a larger random graph: every k-mer lands in exactly one unitig
+        DeBruijnGraph wide(5);
+        emp::Random random(6);
+        vector<string> wide_genomes;
+        for(int i = 0; i < 100; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            wide.add_sequence(genome);
+            wide_genomes.push_back(genome);
+        }
+        std::stringstream wide_out;
+        GfaWriter(wide_out).write(wide, GfaSegments::UNITIG);
+        size_t wide_kmers = 0;
+        for(auto const & segment : records(wide_out.str(), "S")){
+            wide_kmers += segment[2].size() - 4;
+        }
+        CHECK(int(wide_kmers) == wide.get_size());
+        CHECK(records(wide_out.str(), "P").empty());
+
+        // unitigs are broken at every genome's first and last k-mer, so each path spells exactly its genome
+        std::stringstream paths_out;
+        GfaWriter(paths_out).write(wide, GfaSegments::UNITIG, &wide_genomes);
+        string wide_gfa = paths_out.str();
+        vector<vector<string>> wide_paths = records(wide_gfa, "P");
+        REQUIRE(wide_paths.size() == wide_genomes.size());
+        for(size_t i = 0; i < wide_genomes.size(); ++i){
+            string spelled = spell(wide_gfa, wide_paths[i], 5);
+            CHECK(spelled == wide_genomes[i]);
+        }
+    }
+}
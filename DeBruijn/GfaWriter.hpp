@@ -0,0 +1,277 @@
+/**
+ * @file GfaWriter.hpp
+ * @author Anna Catenacci
+ *
+ * Writes a DeBruijnGraph as GFA 1.0, so it can be loaded by standard pangenome tools (Bandage, vg, odgi, ...).
+ *
+ * Segments are either one per k-mer, or one per compacted unitig (a maximal path whose inner vertices have
+ * exactly one edge in and one edge out). Segments are named by their first k-mer, links overlap by k - 1
+ * characters, and each segment carries its total k-mer count as a KC:i: tag. If genomes are given, each one
+ * is written as a path through the segments it touches; unitigs are then also broken where one of those
+ * genomes starts or ends, so that every path spells exactly its genome.
+ *
+ * The graph's vertex store is read directly and output goes through a large buffer, so even very large
+ * graphs are written in one streaming pass (plus a second pass over the in-degrees for unitigs):
+ *     std::ofstream out("pangenome.gfa");
+ *     GfaWriter(out).write(graph, GfaSegments::UNITIG);
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GFAWRITER_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GFAWRITER_H
+
+#include "DeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <initializer_list>
+#include <stdexcept>
+
+/// What each GFA segment stands for
+enum class GfaSegments {
+    /// One segment per vertex
+    KMER,
+    /// One segment per maximal non-branching path
+    UNITIG
+};
+
+class GfaWriter {
+private:
+    /// Stream the GFA is written to
+    std::ostream & mOut;
+
+    /// Text waiting to be written
+    string mBuffer;
+
+    /// Write the buffer out once it holds this many bytes
+    size_t mBufferBytes;
+
+    /**
+     * Append text, writing the buffer out once it is full
+     */
+    void put(const string & text){
+        mBuffer += text;
+        if(mBuffer.size() >= mBufferBytes){
+            flush();
+        }
+    }
+
+    /**
+     * Append one record (a tab-separated line)
+     * @param fields fields of the record
+     */
+    void record(std::initializer_list<string> fields){
+        bool first = true;
+        for(auto const & field : fields){
+            if(!first){
+                mBuffer += '\t';
+            }
+            mBuffer += field;
+            first = false;
+        }
+        put("\n");
+    }
+
+    /**
+     * Link record from the end of one segment to the start of the next
+     */
+    void link(const string & from, const string & to, int kmer_length){
+        record({"L", from, "+", to, "+", std::to_string(kmer_length - 1) + "M"});
+    }
+
+    /**
+     * Write a path record
+     * @param name path name
+     * @param segments segment names in order
+     */
+    void path(const string & name, const vector<string> & segments){
+        string steps;
+        for(size_t i = 0; i < segments.size(); ++i){
+            steps += (i > 0 ? "," : "") + segments[i] + "+";
+        }
+        record({"P", name, steps, "*"});
+    }
+
+    /**
+     * Write one segment per k-mer, then one link per edge
+     */
+    template <typename GraphT>
+    void write_kmers(const GraphT & graph, const vector<string> * genomes){
+        graph.for_each_vertex([this] (const string & kmer, const DBGraphValue & value) {
+            record({"S", kmer, kmer, "KC:i:" + std::to_string(value.get_kmer_occurrences())});
+        });
+        int kmer_length = graph.get_kmer_len();
+        graph.for_each_vertex([this, kmer_length] (const string & kmer, const DBGraphValue & value) {
+            for(int i = 0; i < value.adj_list_size(); ++i){
+                link(kmer, value.get_adjacency(i), kmer_length);
+            }
+        });
+        if(genomes){
+            for(size_t g = 0; g < genomes->size(); ++g){
+                const string & genome = (*genomes)[g];
+                vector<string> segments;
+                for(size_t i = 0; i + kmer_length <= genome.size(); ++i){
+                    segments.push_back(genome.substr(i, kmer_length));
+                }
+                path("genome" + std::to_string(g), segments);
+            }
+        }
+    }
+
+    /**
+     * Write one segment per compacted unitig, then the links between unitigs
+     */
+    template <typename GraphT>
+    void write_unitigs(const GraphT & graph, const vector<string> * genomes){
+        int kmer_length = graph.get_kmer_len();
+        std::unordered_map<string, int> in_degree;
+        graph.for_each_vertex([&in_degree] (const string & kmer, const DBGraphValue & value) {
+            in_degree.emplace(kmer, 0);
+            for(int i = 0; i < value.adj_list_size(); ++i){
+                in_degree[value.get_adjacency(i)]++;
+            }
+        });
+        // when paths are written, a genome's first k-mer must start a unitig and its last k-mer must end one
+        // (the graph's own start vertices are not enough: a genome that begins on a k-mer already in the graph
+        // adds none)
+        std::unordered_set<string> starts, ends;
+        if(genomes){
+            for(auto const & genome : *genomes){
+                if(int(genome.size()) >= kmer_length){
+                    starts.insert(genome.substr(0, kmer_length));
+                    ends.insert(genome.substr(genome.size() - kmer_length));
+                }
+            }
+        }
+        // the vertex after `kmer` joins its unitig only if it is the one way out of `kmer` and the one way in to it
+        auto continues = [&] (const string & kmer, const DBGraphValue & value) {
+            if(value.adj_list_size() != 1 || in_degree[value.get_adjacency(0)] != 1){
+                return false;
+            }
+            return ends.count(kmer) <= 0 && starts.count(value.get_adjacency(0)) <= 0;
+        };
+        // a vertex starts a unitig unless it continues the unitig of its only predecessor;
+        // the vertices that continue one are marked once they have been written
+        std::unordered_map<string, bool> continued;
+        graph.for_each_vertex([&] (const string & kmer, const DBGraphValue & value) {
+            if(continues(kmer, value)){
+                continued.emplace(value.get_adjacency(0), false);
+            }
+        });
+
+        std::unordered_map<string, string> unitig_of; // only filled when paths are written
+        vector<std::pair<string, string>> unitigs; // first and last vertex of each unitig
+        auto write_unitig = [&] (const string & first) {
+            string sequence = first;
+            long long count = 0;
+            string current = first;
+            const DBGraphValue * value = graph.find_value(current);
+            while(true){
+                count += value->get_kmer_occurrences();
+                if(genomes){
+                    unitig_of[current] = first;
+                }
+                if(!continues(current, *value) || value->get_adjacency(0) == first){
+                    break;
+                }
+                current = value->get_adjacency(0);
+                sequence += current.back();
+                value = graph.find_value(current);
+                continued[current] = true;
+            }
+            record({"S", first, sequence, "KC:i:" + std::to_string(count)});
+            unitigs.emplace_back(first, current);
+        };
+        graph.for_each_vertex([&] (const string & kmer, const DBGraphValue &) {
+            if(continued.count(kmer) <= 0){
+                write_unitig(kmer);
+            }
+        });
+        // whatever is left lies on cycles with no way in or out; break each one at an arbitrary vertex
+        for(auto & vertex : continued){
+            if(!vertex.second){
+                vertex.second = true;
+                write_unitig(vertex.first);
+            }
+        }
+        for(auto const & unitig : unitigs){
+            // every successor of a unitig's last vertex starts a unitig of its own
+            const DBGraphValue * value = graph.find_value(unitig.second);
+            for(int i = 0; i < value->adj_list_size(); ++i){
+                link(unitig.first, value->get_adjacency(i), kmer_length);
+            }
+        }
+        if(genomes){
+            for(size_t g = 0; g < genomes->size(); ++g){
+                const string & genome = (*genomes)[g];
+                vector<string> segments;
+                string kmer;
+                for(size_t i = 0; i + kmer_length <= genome.size(); ++i){
+                    kmer.assign(genome, i, kmer_length);
+                    auto it = unitig_of.find(kmer);
+                    // a genome enters a new unitig at its first vertex
+                    if(it != unitig_of.end() && it->second == kmer){
+                        segments.push_back(it->second);
+                    }
+                }
+                path("genome" + std::to_string(g), segments);
+            }
+        }
+    }
+
+public:
+    /**
+     * @param out stream to write to
+     * @param buffer_bytes size of the output buffer
+     */
+    explicit GfaWriter(std::ostream & out, size_t buffer_bytes = size_t(1) << 20)
+        : mOut(out), mBufferBytes(buffer_bytes) {
+        mBuffer.reserve(buffer_bytes + 256);
+    }
+
+    GfaWriter(const GfaWriter &) = delete;
+    GfaWriter & operator=(const GfaWriter &) = delete;
+
+    ~GfaWriter(){
+        try {
+            flush();
+        }
+        catch(...){
+        }
+    }
+
+    /**
+     * Write a graph as GFA
+     * @param graph graph to write
+     * @param segments one segment per k-mer or per unitig
+     * @param genomes if not nullptr, also write each of these genomes as a path ("genome0", "genome1", ...)
+     */
+    template <typename GraphT>
+    void write(const GraphT & graph, GfaSegments segments = GfaSegments::KMER, const vector<string> * genomes = nullptr){
+        record({"H", "VN:Z:1.0"});
+        if(segments == GfaSegments::KMER){
+            write_kmers(graph, genomes);
+        }
+        else {
+            write_unitigs(graph, genomes);
+        }
+        flush();
+    }
+
+    /**
+     * Write out everything in the buffer
+     */
+    void flush(){
+        mOut.write(mBuffer.data(), mBuffer.size());
+        mBuffer.clear();
+        mOut.flush();
+        if(!mOut){
+            throw std::runtime_error("GfaWriter: could not write the graph");
+        }
+    }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GFAWRITER_H
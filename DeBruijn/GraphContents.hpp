@@ -0,0 +1,59 @@
+/**
+ * @file GraphContents.hpp
+ * @author Anna Catenacci
+ *
+ * Test helper shared by the test files: everything a DeBruijnGraph (of any vertex store) holds, as a list of
+ * strings two graphs can be compared by. Adjacency lists are sorted, so graphs that hold the same edges compare
+ * equal however their lists were filled in; tests that also care about order check it themselves.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHCONTENTS_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHCONTENTS_H
+
+#include "DeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+
+/**
+ * @param g graph to list
+ * @return one line per vertex (k-mer, occurrences, endpoints, empty flag, branch flag and successors with their
+ *         edge counts), then the start vertices in order, the branch vertices sorted, the sizes and statistics,
+ *         and the memory categories that follow from the graph's content
+ */
+template <typename GraphT>
+std::vector<std::string> graph_contents(const GraphT & g){
+    std::vector<std::string> seen;
+    for(auto const & vertex : g.get_all_vertices()){
+        DBGraphValue value = g.get_value(vertex);
+        std::vector<std::string> adjacent = value.get_adj_list();
+        std::sort(adjacent.begin(), adjacent.end());
+        std::string line = vertex + ":" + std::to_string(value.get_kmer_occurrences()) + ":" + std::to_string(value.get_endpoint())
+            + ":" + std::to_string(value.get_empty_bool()) + ":" + std::to_string(value.get_branch()) + ":";
+        for(auto const & adj : adjacent){
+            line += adj + "x" + std::to_string(value.get_edge_count(adj)) + ",";
+        }
+        seen.push_back(line);
+    }
+    for(auto const & start : g.get_start_vertices()){
+        seen.push_back("start " + start);
+    }
+    std::vector<std::string> branches = g.get_branch_vertices();
+    std::sort(branches.begin(), branches.end());
+    for(auto const & branch : branches){
+        seen.push_back("branch " + branch);
+    }
+    const DeBruijnStatistics & stats = g.statistics();
+    seen.push_back("sizes " + std::to_string(g.get_size()) + " " + std::to_string(g.get_sequence_size()) + " "
+        + std::to_string(g.get_sequence_length()) + " " + std::to_string(g.edge_count()) + " "
+        + std::to_string(stats.total_occurrences) + " " + std::to_string(stats.singleton_kmers) + " "
+        + std::to_string(stats.endpoints));
+    // the store and allocator overheads depend on the order vertices were inserted in, so they are left out
+    DeBruijnMemoryUsage usage = g.memory_usage();
+    seen.push_back("memory " + std::to_string(usage.vertex_keys) + " " + std::to_string(usage.vertex_values) + " "
+        + std::to_string(usage.adjacency) + " " + std::to_string(usage.edge_counts) + " "
+        + std::to_string(usage.starts) + " " + std::to_string(usage.branch_index));
+    return seen;
+}
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHCONTENTS_H
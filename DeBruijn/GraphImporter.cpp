@@ -0,0 +1,149 @@
+/**
+ * @file GraphImporter.cpp
+ * @author Anna Catenacci
+ */
+
+#include "GraphImporter.hpp"
+#include "GfaWriter.hpp"
+#include "GraphContents.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// A random population of bit-string genomes
+    vector<string> population(int seed, int size, int length){
+        emp::Random random(seed);
+        vector<string> genomes;
+        for(int i = 0; i < size; ++i){
+            string genome;
+            for(int j = 0; j < length; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            genomes.push_back(genome);
+        }
+        return genomes;
+    }
+}
+
+TEST_CASE("GraphImporter__matches-one-by-one-adds", "[GraphImporter.hpp]")
+{
+    {
+        vector<string> genomes = population(3, 200, 40);
+        genomes.push_back(genomes[5]);   // the same genome twice
+        genomes.push_back("0110");       // shorter than the others
+        genomes.push_back("01");         // shorter than k
+        DeBruijnGraph one_by_one(4);
+        for(auto const & genome : genomes){
+            one_by_one.add_sequence(genome);
+        }
+
+        DeBruijnGraph batched(4);
+        batched.add_sequences(genomes);
+        CHECK(graph_contents(batched) == graph_contents(one_by_one));
+
+        // one genome per line, with a blank line and Windows line endings, on any number of threads
+        string lines;
+        for(auto const & genome : genomes){
+            lines += genome + (genome.size() % 2 ? "\n" : "\r\n");
+        }
+        lines += "\n";
+        for(unsigned threads : {1u, 2u, 3u, 8u, 64u}){
+            DeBruijnGraph imported(4);
+            CHECK(GraphImporter(threads).import_text(imported, lines) == int(genomes.size()));
+            CHECK(graph_contents(imported) == graph_contents(one_by_one));
+        }
+
+        // importing into a graph that already has genomes
+        DeBruijnGraph seeded(4), extended(4);
+        vector<string> earlier = population(4, 30, 40);
+        for(auto const & genome : earlier){
+            seeded.add_sequence(genome);
+            extended.add_sequence(genome);
+        }
+        for(auto const & genome : genomes){
+            seeded.add_sequence(genome);
+        }
+        GraphImporter(4).import_text(extended, lines, ImportFormat::LINES);
+        CHECK(graph_contents(extended) == graph_contents(seeded));
+
+        // counts are tied to one k-mer length
+        DeBruijnGraph::SequenceCounts counts(3);
+        counts.count("0101");
+        CHECK_THROWS_AS(batched.add_counts(counts), std::invalid_argument);
+    }
+}
+
+TEST_CASE("GraphImporter__fasta-gfa-and-files", "[GraphImporter.hpp]")
+{
+    {
+        vector<string> genomes = population(5, 50, 60);
+        DeBruijnGraph expected(5);
+        for(auto const & genome : genomes){
+            expected.add_sequence(genome);
+        }
+
+        // FASTA, with sequences split over several lines
+        string fasta;
+        for(size_t i = 0; i < genomes.size(); ++i){
+            fasta += ">genome" + std::to_string(i) + " from generation 100\n";
+            for(size_t j = 0; j < genomes[i].size(); j += 25){
+                fasta += genomes[i].substr(j, 25) + "\n";
+            }
+        }
+        for(unsigned threads : {1u, 3u, 16u}){
+            DeBruijnGraph imported(5);
+            CHECK(GraphImporter(threads).import_text(imported, fasta) == int(genomes.size()));
+            CHECK(graph_contents(imported) == graph_contents(expected));
+        }
+
+        // GFAs written by GfaWriter, whose paths leave their overlaps to the links
+        for(GfaSegments segments : {GfaSegments::KMER, GfaSegments::UNITIG}){
+            std::stringstream gfa;
+            GfaWriter(gfa).write(expected, segments, &genomes);
+            for(unsigned threads : {1u, 4u}){
+                DeBruijnGraph imported(5);
+                CHECK(GraphImporter(threads).import_text(imported, gfa.str()) == int(genomes.size()));
+                CHECK(graph_contents(imported) == graph_contents(expected));
+            }
+        }
+        // genomes starting and ending inside a unitig come back as they went in
+        vector<string> shifted = {"0123456", "1234567"};
+        DeBruijnGraph shifted_expected(3);
+        for(auto const & genome : shifted){
+            shifted_expected.add_sequence(genome);
+        }
+        std::stringstream shifted_gfa;
+        GfaWriter(shifted_gfa).write(shifted_expected, GfaSegments::UNITIG, &shifted);
+        DeBruijnGraph shifted_imported(3);
+        CHECK(GraphImporter(2).import_text(shifted_imported, shifted_gfa.str()) == 2);
+        CHECK(graph_contents(shifted_imported) == graph_contents(shifted_expected));
+
+        // a hand-written GFA with overlaps given on the path
+        DeBruijnGraph small(3);
+        string hand_written = "H\tVN:Z:1.0\nS\ta\t0110\nS\tb\t1001\nS\tc\t111\nP\tp\ta+,b+,c+\t2M,0M\n";
+        CHECK(GraphImporter(2).import_text(small, hand_written) == 1);
+        CHECK(small.is_valid("011001111"));
+        CHECK(small.get_sequence_size() == 1);
+        DeBruijnGraph reversed(3);
+        CHECK_THROWS_AS(GraphImporter(2).import_text(reversed, "S\ta\t0110\nP\tp\ta-\t*\n"), std::runtime_error);
+
+        // the same population read from a mapped file
+        const string path = "GraphImporter_test_population.fa";
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << fasta;
+        }
+        DeBruijnGraph from_file(5);
+        CHECK(GraphImporter().import_file(from_file, path) == int(genomes.size()));
+        CHECK(graph_contents(from_file) == graph_contents(expected));
+        std::remove(path.c_str());
+        CHECK_THROWS_AS(GraphImporter().import_file(from_file, path), std::runtime_error);
+
+        MappedFile empty_file("/dev/null");
+        CHECK(empty_file.size() == 0);
+    }
+}
@@ -0,0 +1,496 @@
+/**
+ * @file GraphImporter.hpp
+ * @author Anna Catenacci
+ *
+ * Seeds a DeBruijnGraph from a stored population or pangenome file, so experiments can start from an archive
+ * of millions of genomes without a loop of add_sequence calls.
+ *
+ * Three file formats are read:
+ *  - LINES: one genome per line,
+ *  - FASTA: a '>' header line before each genome, whose sequence may be split over several lines,
+ *  - GFA: the genomes are the P (path) lines, spelled out from their segments. Overlaps between steps are
+ *    taken from the path itself, or from the matching L (link) line if the path leaves them out ('*'), as
+ *    GfaWriter does. Only forward ('+') steps can be read.
+ * AUTO picks GFA if the file starts with an H or S record, FASTA if it starts with '>', and LINES otherwise.
+ *
+ * The file is memory-mapped (read into memory where mmap is not available) and split into one chunk per
+ * thread at record boundaries. Each thread parses its chunk in place and counts its k-mers and edges into
+ * its own SequenceCounts; the counts are merged pairwise in parallel and added to the graph in one pass:
+ *     DeBruijnGraph graph(3);
+ *     GraphImporter().import_file(graph, "population.txt");
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHIMPORTER_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHIMPORTER_H
+
+#include "DeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <exception>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PANGENOMES_IMPORTER_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A whole file, read-only, mapped into memory
+ */
+class MappedFile {
+private:
+    /// First byte of the file
+    const char * mData = nullptr;
+
+    /// Number of bytes in the file
+    size_t mSize = 0;
+
+    /// True if mData points to a mapping rather than into mCopy
+    bool mMapped = false;
+
+    /// The file's contents, where it could not be mapped
+    string mCopy;
+
+public:
+    /**
+     * @param path file to map
+     */
+    explicit MappedFile(const string & path){
+#ifdef PANGENOMES_IMPORTER_MMAP
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if(descriptor < 0){
+            throw std::runtime_error("MappedFile: could not open " + path);
+        }
+        struct stat status;
+        bool empty = fstat(descriptor, &status) == 0 && status.st_size == 0;
+        if(!empty){
+            void * mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if(mapping != MAP_FAILED){
+                mData = static_cast<const char *>(mapping);
+                mSize = status.st_size;
+                mMapped = true;
+                madvise(mapping, mSize, MADV_SEQUENTIAL);
+            }
+        }
+        close(descriptor);
+        if(mMapped || empty){
+            return;
+        }
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if(!in){
+            throw std::runtime_error("MappedFile: could not open " + path);
+        }
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        mCopy = contents.str();
+        mData = mCopy.data();
+        mSize = mCopy.size();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    ~MappedFile(){
+#ifdef PANGENOMES_IMPORTER_MMAP
+        if(mMapped){
+            munmap(const_cast<char *>(mData), mSize);
+        }
+#endif
+    }
+
+    /**
+     * @return first byte of the file
+     */
+    const char * data() const { return mData; }
+
+    /**
+     * @return number of bytes in the file
+     */
+    size_t size() const { return mSize; }
+};
+
+/// Layout of a file being imported
+enum class ImportFormat {
+    /// Decide from the first character of the file
+    AUTO,
+    /// One genome per line
+    LINES,
+    /// '>' header lines, each followed by one genome over one or more lines
+    FASTA,
+    /// GFA 1.0; each path is one genome
+    GFA
+};
+
+class GraphImporter {
+private:
+    using view = std::string_view;
+
+    /// Number of threads to parse and count with
+    unsigned mThreads;
+
+    /**
+     * @param text whole file
+     * @return the format AUTO stands for
+     */
+    static ImportFormat detect(view text){
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if(first == view::npos){
+            return ImportFormat::LINES;
+        }
+        if(text[first] == '>'){
+            return ImportFormat::FASTA;
+        }
+        if((text[first] == 'H' || text[first] == 'S') && first + 1 < text.size() && text[first + 1] == '\t'){
+            return ImportFormat::GFA;
+        }
+        return ImportFormat::LINES;
+    }
+
+    /**
+     * Call func on every line of a text, without its line ending
+     * @param text text to split
+     * @param func lambda taking a view of one line
+     */
+    template <typename FuncType>
+    static void for_each_line(view text, FuncType func){
+        size_t begin = 0;
+        while(begin < text.size()){
+            size_t end = text.find('\n', begin);
+            if(end == view::npos){
+                end = text.size();
+            }
+            view line = text.substr(begin, end - begin);
+            if(!line.empty() && line.back() == '\r'){
+                line.remove_suffix(1);
+            }
+            func(line);
+            begin = end + 1;
+        }
+    }
+
+    /**
+     * Split a text into about one chunk per thread, each ending right before a line that begins a record
+     * @param text text to split
+     * @param record_start character a record's first line begins with, or 0 if every line is a record
+     * @return the chunks, in order
+     */
+    vector<view> split(view text, char record_start) const {
+        vector<view> chunks;
+        size_t begin = 0;
+        for(unsigned i = 1; i <= mThreads && begin < text.size(); ++i){
+            size_t end = i == mThreads ? text.size() : std::max(begin, text.size() / mThreads * i);
+            // move the cut to the start of the next record
+            while(end < text.size()){
+                end = text.find('\n', end);
+                if(end == view::npos){
+                    end = text.size();
+                    break;
+                }
+                end++;
+                if(record_start == 0 || (end < text.size() && text[end] == record_start)){
+                    break;
+                }
+            }
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+        return chunks;
+    }
+
+    /**
+     * Run work(i) for every i below count, each on its own thread, and pass on the first exception any of them throws
+     */
+    template <typename FuncType>
+    static void run_parallel(size_t count, FuncType work){
+        vector<std::exception_ptr> errors(count);
+        vector<std::thread> threads;
+        for(size_t i = 0; i < count; ++i){
+            threads.emplace_back([&work, &errors, i] () {
+                try {
+                    work(i);
+                }
+                catch(...){
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+        for(auto const & error : errors){
+            if(error){
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    /**
+     * Run count on every chunk, each on its own thread with its own SequenceCounts, then merge the counts in
+     * order, adjacent pairs in parallel
+     * @param kmer_length length of the graph's k-mers
+     * @param chunks parts of the input, in order
+     * @param count lambda taking (chunk, counts) that counts every genome in the chunk
+     * @return counts of every chunk
+     */
+    template <typename CountsT, typename ChunkT, typename FuncType>
+    static CountsT count_chunks(int kmer_length, const vector<ChunkT> & chunks, FuncType count){
+        vector<CountsT> counts(chunks.size(), CountsT(kmer_length));
+        run_parallel(chunks.size(), [&] (size_t i) { count(chunks[i], counts[i]); });
+        for(size_t step = 1; step < counts.size(); step *= 2){
+            run_parallel((counts.size() - step + 2 * step - 1) / (2 * step), [&counts, step] (size_t pair) {
+                counts[2 * step * pair].merge(std::move(counts[2 * step * pair + step]));
+            });
+        }
+        return counts.empty() ? CountsT(kmer_length) : std::move(counts[0]);
+    }
+
+    /**
+     * Split a GFA record into its tab-separated fields
+     */
+    static vector<view> fields(view line){
+        vector<view> result;
+        size_t begin = 0;
+        while(true){
+            size_t end = line.find('\t', begin);
+            result.push_back(line.substr(begin, end == view::npos ? view::npos : end - begin));
+            if(end == view::npos){
+                return result;
+            }
+            begin = end + 1;
+        }
+    }
+
+    /**
+     * @param cigar GFA overlap, e.g. "3M"
+     * @return its length, or -1 if it is left out ('*')
+     */
+    static int overlap_length(view cigar){
+        if(cigar.empty() || cigar == "*"){
+            return -1;
+        }
+        int length = 0;
+        size_t i = 0;
+        for(; i < cigar.size() && cigar[i] >= '0' && cigar[i] <= '9'; ++i){
+            length = length * 10 + (cigar[i] - '0');
+        }
+        if(i + 1 != cigar.size() || cigar[i] != 'M'){
+            throw std::runtime_error("GraphImporter: only exact-match overlaps (\"<n>M\") are supported");
+        }
+        return length;
+    }
+
+    /**
+     * Spell out the genome a GFA path walks
+     * @param path fields of the P record
+     * @param segments sequence of each segment, by name
+     * @param links overlap of each link, by (from, to)
+     * @param genome set to the genome
+     */
+    static void spell_path(const vector<view> & path, const std::unordered_map<view, view> & segments,
+                           const map<std::pair<view, view>, int> & links, string & genome){
+        if(path.size() < 3){
+            throw std::runtime_error("GraphImporter: a GFA path has too few fields");
+        }
+        vector<view> overlaps;
+        if(path.size() > 3 && path[3] != "*"){
+            view list = path[3];
+            size_t begin = 0;
+            while(begin <= list.size()){
+                size_t end = std::min(list.find(',', begin), list.size());
+                overlaps.push_back(list.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        }
+        genome.clear();
+        view steps = path[2];
+        view previous;
+        size_t begin = 0, step = 0;
+        while(begin < steps.size()){
+            size_t end = std::min(steps.find(',', begin), steps.size());
+            if(end - begin < 2 || steps[end - 1] != '+'){
+                throw std::runtime_error("GraphImporter: only forward ('+') GFA path steps are supported");
+            }
+            view name = steps.substr(begin, end - begin - 1);
+            auto segment = segments.find(name);
+            if(segment == segments.end()){
+                throw std::runtime_error("GraphImporter: a GFA path steps through an unknown segment");
+            }
+            int overlap = 0;
+            if(step > 0){
+                overlap = step - 1 < overlaps.size() ? overlap_length(overlaps[step - 1]) : -1;
+                if(overlap < 0){
+                    auto link = links.find({previous, name});
+                    overlap = link == links.end() ? 0 : link->second;
+                }
+            }
+            if(size_t(overlap) > segment->second.size()){
+                throw std::runtime_error("GraphImporter: a GFA overlap is longer than its segment");
+            }
+            genome.append(segment->second.substr(overlap));
+            previous = name;
+            step++;
+            begin = end + 1;
+        }
+    }
+
+    /**
+     * Count every genome of a GFA file: segments and links are collected in parallel, then the paths are
+     * spelled out and counted in parallel
+     */
+    template <typename CountsT>
+    CountsT count_gfa(view text, int kmer_length) const {
+        struct Records {
+            vector<std::pair<view, view>> segments;
+            vector<std::pair<std::pair<view, view>, int>> links;
+            vector<view> paths;
+        };
+        vector<view> chunks = split(text, 0);
+        vector<Records> records(chunks.size());
+        run_parallel(chunks.size(), [&] (size_t i) {
+            for_each_line(chunks[i], [&] (view line) {
+                if(line.size() < 2 || line[1] != '\t'){
+                    return;
+                }
+                if(line[0] == 'S'){
+                    vector<view> segment = fields(line);
+                    if(segment.size() < 3 || segment[2] == "*"){
+                        throw std::runtime_error("GraphImporter: a GFA segment has no sequence");
+                    }
+                    records[i].segments.emplace_back(segment[1], segment[2]);
+                }
+                else if(line[0] == 'L'){
+                    vector<view> link = fields(line);
+                    if(link.size() >= 6 && link[2] == "+" && link[4] == "+"){
+                        records[i].links.push_back({{link[1], link[3]}, std::max(0, overlap_length(link[5]))});
+                    }
+                }
+                else if(line[0] == 'P'){
+                    records[i].paths.push_back(line);
+                }
+            });
+        });
+
+        std::unordered_map<view, view> segments;
+        map<std::pair<view, view>, int> links;
+        vector<view> paths;
+        for(auto const & chunk : records){
+            segments.insert(chunk.segments.begin(), chunk.segments.end());
+            links.insert(chunk.links.begin(), chunk.links.end());
+            paths.insert(paths.end(), chunk.paths.begin(), chunk.paths.end());
+        }
+
+        vector<std::pair<size_t, size_t>> path_chunks;
+        size_t per_thread = (paths.size() + mThreads - 1) / mThreads;
+        for(size_t begin = 0; begin < paths.size(); begin += per_thread){
+            path_chunks.emplace_back(begin, std::min(begin + per_thread, paths.size()));
+        }
+        return count_chunks<CountsT>(kmer_length, path_chunks, [&] (std::pair<size_t, size_t> range, CountsT & counts) {
+            string genome;
+            for(size_t i = range.first; i < range.second; ++i){
+                spell_path(fields(paths[i]), segments, links, genome);
+                if(!genome.empty()){
+                    counts.count(genome);
+                }
+            }
+        });
+    }
+
+public:
+    /**
+     * @param threads number of threads to parse and count with (0 for one per hardware thread)
+     */
+    explicit GraphImporter(unsigned threads = 0)
+        : mThreads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) { }
+
+    /**
+     * Add every genome in a block of text to a graph
+     * @param graph graph to add to
+     * @param data first character of the text
+     * @param size number of characters
+     * @param format layout of the text
+     * @return number of genomes added
+     */
+    template <typename GraphT>
+    int import_text(GraphT & graph, const char * data, size_t size, ImportFormat format = ImportFormat::AUTO) const {
+        using CountsT = typename GraphT::SequenceCounts;
+        view text(data, size);
+        if(format == ImportFormat::AUTO){
+            format = detect(text);
+        }
+        int kmer_length = graph.get_kmer_len();
+        CountsT counts(kmer_length);
+        if(format == ImportFormat::GFA){
+            counts = count_gfa<CountsT>(text, kmer_length);
+        }
+        else if(format == ImportFormat::FASTA){
+            counts = count_chunks<CountsT>(kmer_length, split(text, '>'), [] (view chunk, CountsT & chunk_counts) {
+                string genome;
+                bool in_record = false;
+                auto finish = [&] () {
+                    if(in_record && !genome.empty()){
+                        chunk_counts.count(genome);
+                    }
+                    genome.clear();
+                };
+                for_each_line(chunk, [&] (view line) {
+                    if(!line.empty() && line[0] == '>'){
+                        finish();
+                        in_record = true;
+                    }
+                    else {
+                        genome.append(line);
+                    }
+                });
+                finish();
+            });
+        }
+        else {
+            counts = count_chunks<CountsT>(kmer_length, split(text, 0), [] (view chunk, CountsT & chunk_counts) {
+                for_each_line(chunk, [&] (view line) {
+                    if(!line.empty()){
+                        chunk_counts.count(line.data(), line.size());
+                    }
+                });
+            });
+        }
+        graph.add_counts(counts);
+        return counts.sequences();
+    }
+
+    /**
+     * Add every genome in a string to a graph
+     */
+    template <typename GraphT>
+    int import_text(GraphT & graph, const string & text, ImportFormat format = ImportFormat::AUTO) const {
+        return import_text(graph, text.data(), text.size(), format);
+    }
+
+    /**
+     * Add every genome in a file to a graph
+     * @param graph graph to add to
+     * @param path file to read
+     * @param format layout of the file
+     * @return number of genomes added
+     */
+    template <typename GraphT>
+    int import_file(GraphT & graph, const string & path, ImportFormat format = ImportFormat::AUTO) const {
+        MappedFile file(path);
+        return import_text(graph, file.data(), file.size(), format);
+    }
+
+    /**
+     * @return number of threads used
+     */
+    unsigned threads() const { return mThreads; }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHIMPORTER_H
@@ -0,0 +1,172 @@
+/**
+ * @file GraphTraversal.cpp
+ * @author Anna Catenacci
+ */
+
+#include "DeBruijnGraph.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Textbook traversal to check against: roots are the starts, then every vertex in store order
+    template <typename GraphT>
+    vector<string> reference_order(const GraphT & g, TraversalOrder order){
+        vector<string> roots = g.get_start_vertices();
+        vector<string> all = g.get_all_vertices();
+        roots.insert(roots.end(), all.begin(), all.end());
+        std::set<string> visited;
+        vector<string> result;
+        for(auto const & root : roots){
+            if(visited.count(root) > 0){
+                continue;
+            }
+            std::deque<string> frontier{root};
+            if(order == TraversalOrder::BREADTH_FIRST){
+                visited.insert(root);
+            }
+            while(!frontier.empty()){
+                string current;
+                if(order == TraversalOrder::DEPTH_FIRST){
+                    current = frontier.back();
+                    frontier.pop_back();
+                    if(!visited.insert(current).second){
+                        continue;
+                    }
+                }
+                else {
+                    current = frontier.front();
+                    frontier.pop_front();
+                }
+                result.push_back(current);
+                vector<string> adj = g.get_value(current).get_adj_list();
+                if(order == TraversalOrder::DEPTH_FIRST){
+                    std::reverse(adj.begin(), adj.end());
+                }
+                for(auto const & next : adj){
+                    if(visited.count(next) == 0){
+                        if(order == TraversalOrder::BREADTH_FIRST){
+                            visited.insert(next);
+                        }
+                        frontier.push_back(next);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    DeBruijnGraph population(int seed){
+        emp::Random random(seed);
+        DeBruijnGraph g(6);
+        for(int i = 0; i < 50; ++i){
+            string genome;
+            for(int j = 0; j < 80; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            g.add_sequence(genome);
+        }
+        return g;
+    }
+}
+
+TEST_CASE("GraphTraversal__orders", "[GraphTraversal.hpp]")
+{
+    {
+        DeBruijnGraph g = population(48);
+        vector<string> depth_first, breadth_first;
+        for(const string & kmer : g.depth_first()){
+            depth_first.push_back(kmer);
+        }
+        for(const string & kmer : g.breadth_first()){
+            breadth_first.push_back(kmer);
+        }
+        CHECK(depth_first == reference_order(g, TraversalOrder::DEPTH_FIRST));
+        CHECK(breadth_first == reference_order(g, TraversalOrder::BREADTH_FIRST));
+        CHECK(int(depth_first.size()) == g.get_size());
+
+        // every edge once, from the vertex being visited
+        long long edges = 0;
+        for(auto edge : g.depth_first().edges()){
+            CHECK(g.get_value(edge.first).valid_adj(edge.second));
+            edges++;
+        }
+        CHECK(edges == g.statistics().edges);
+
+        // the iterator also gives the vertex's value
+        auto traversal = g.breadth_first();
+        for(auto it = traversal.begin(); it != traversal.end(); ++it){
+            CHECK(it.value().get_kmer_occurrences() == g.get_value(*it).get_kmer_occurrences());
+        }
+
+        // vertices no start reaches any more are still visited: "100" was the only start, and "000" was
+        // not added as one because it already existed when "0001" was added
+        DeBruijnGraph orphans;
+        orphans.add_sequence("1000");
+        orphans.add_sequence("0001");
+        orphans.remove_sequence("1000");
+        CHECK(orphans.get_start_vertices().empty());
+        vector<string> visited;
+        for(const string & kmer : orphans.depth_first()){
+            visited.push_back(kmer);
+        }
+        CHECK(visited == vector<string>{"000", "001"});
+
+        DeBruijnGraph empty;
+        CHECK(empty.depth_first().begin() == empty.depth_first().end());
+    }
+}
+
+TEST_CASE("GraphTraversal__concurrent-and-parallel", "[GraphTraversal.hpp]")
+{
+    {
+        const DeBruijnGraph g = population(49);
+        vector<string> expected = reference_order(g, TraversalOrder::DEPTH_FIRST);
+
+        // several traversals and samplers over the same graph at once
+        vector<vector<string>> orders(4);
+        vector<string> children(4);
+        vector<std::thread> threads;
+        for(size_t i = 0; i < orders.size(); ++i){
+            threads.emplace_back([&g, &orders, &children, i] () {
+                for(const string & kmer : g.depth_first()){
+                    orders[i].push_back(kmer);
+                }
+                emp::Random random(int(i) + 1);
+                children[i] = g.sample_path(random, g.get_start_vertices()[0]);
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+        for(auto const & order : orders){
+            CHECK(order == expected);
+        }
+        for(auto const & child : children){
+            CHECK(g.is_valid(child));
+        }
+
+        // the parallel traversal visits every vertex exactly once, with any number of threads
+        for(unsigned thread_count : {1u, 3u, 8u}){
+            std::mutex lock;
+            std::multiset<string> seen;
+            std::atomic<long long> occurrences{0};
+            g.parallel_traversal([&] (const string & kmer, const DBGraphValue & value) {
+                occurrences += value.get_kmer_occurrences();
+                std::lock_guard<std::mutex> guard(lock);
+                seen.insert(kmer);
+            }, thread_count);
+            vector<string> all = g.get_all_vertices();
+            CHECK(seen == std::multiset<string>(all.begin(), all.end()));
+            CHECK(occurrences == g.statistics().total_occurrences);
+        }
+
+        // an exception on one thread stops the traversal and reaches the caller
+        CHECK_THROWS_AS(g.parallel_traversal([] (const string &, const DBGraphValue &) {
+            throw std::runtime_error("analysis failed");
+        }, 4), std::runtime_error);
+    }
+}
@@ -0,0 +1,448 @@
+/**
+ * @file GraphTraversal.hpp
+ * @author Anna Catenacci
+ *
+ * Read-only traversals of a DeBruijnGraph that keep their visited set to themselves, so any number of them
+ * can run over the same graph at once, alongside sample_path and other readers.
+ *
+ * GraphTraversal walks the vertices in depth-first or breadth-first order, each exactly once: first everything
+ * reachable from the start vertices, then, in store order, whatever is left (vertices only reachable around a
+ * cycle). Its iterators hand out references to k-mers already in the graph, and the frontier holds pointers,
+ * so stepping does not copy any strings. edges() walks the out-edges of the same vertices in the same order.
+ *
+ * ParallelTraversal calls a function on every vertex from several threads. Each thread works depth first
+ * from its own deque and steals from the others when it runs dry; a vertex belongs to whichever thread
+ * claims it first in a sharded visited set.
+ *
+ * The graph must not change while a traversal is running.
+ *     for(const string & kmer : graph.depth_first()){ ... }
+ *     graph.parallel_traversal([&] (const string & kmer, const DBGraphValue & value) { ... });
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHTRAVERSAL_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHTRAVERSAL_H
+
+#include "DeBruijnValue.hpp"
+#include <vector>
+#include <string>
+#include <deque>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+enum class TraversalOrder { DEPTH_FIRST, BREADTH_FIRST };
+
+/**
+ * One pass over a graph's vertices. The traversal is its own range: begin() starts it, and its iterators
+ * share its state, so they are single-pass.
+ * @tparam GraphT graph type (see BasicDeBruijnGraph)
+ */
+template <typename GraphT>
+class GraphTraversal {
+private:
+    /// A vertex on the frontier: its k-mer (somewhere stable) and its value in the store
+    struct Entry {
+        const string * kmer;
+        const DBGraphValue * value;
+    };
+
+    const GraphT * mGraph;
+    TraversalOrder mOrder;
+
+    /// The graph's start vertices, read in place (the frontier points into them)
+    const vector<string> * mStarts;
+    size_t mNextStart = 0;
+
+    /// Position of the sweep over the store for vertices the starts do not reach
+    typename std::decay<decltype(std::declval<const GraphT &>().vertices())>::type::const_iterator mSweep;
+
+    /// Key of the last vertex the sweep found (some stores only hand out temporary keys)
+    string mSweepKey;
+
+    std::deque<Entry> mFrontier;
+    std::unordered_set<const DBGraphValue *> mVisited;
+
+    /// Vertex the iterators are at (kmer is nullptr once the traversal is over)
+    Entry mCurrent{nullptr, nullptr};
+
+    /**
+     * @param kmer k-mer to look up
+     * @return the vertex's value, or nullptr if it is not in the graph
+     */
+    const DBGraphValue * find(const string & kmer) const {
+        auto it = mGraph->vertices().find(kmer);
+        return it == mGraph->vertices().end() ? nullptr : &it->second;
+    }
+
+    /**
+     * Put a vertex on the frontier if it has not been visited. Breadth first marks vertices as they are
+     * queued, so each is queued once; depth first marks them as they are visited, to keep true DFS order.
+     */
+    void push(const string * kmer, const DBGraphValue * value){
+        if(value == nullptr || mVisited.count(value) > 0){
+            return;
+        }
+        if(mOrder == TraversalOrder::BREADTH_FIRST){
+            mVisited.insert(value);
+        }
+        mFrontier.push_back(Entry{kmer, value});
+    }
+
+    /**
+     * Queue the next vertex that no earlier root reached
+     * @return false if every vertex has been visited
+     */
+    bool push_root(){
+        while(mNextStart < mStarts->size()){
+            const string & start = (*mStarts)[mNextStart++];
+            const DBGraphValue * value = find(start);
+            if(value != nullptr && mVisited.count(value) == 0){
+                push(&start, value);
+                return true;
+            }
+        }
+        for(; mSweep != mGraph->vertices().end(); ++mSweep){
+            const DBGraphValue * value = &mSweep->second;
+            if(mVisited.count(value) == 0){
+                mSweepKey = mSweep->first;
+                ++mSweep;
+                push(&mSweepKey, value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Move mCurrent to the next unvisited vertex and queue its successors
+     */
+    void advance(){
+        while(true){
+            if(mFrontier.empty() && !push_root()){
+                mCurrent = Entry{nullptr, nullptr};
+                return;
+            }
+            Entry entry;
+            if(mOrder == TraversalOrder::DEPTH_FIRST){
+                entry = mFrontier.back();
+                mFrontier.pop_back();
+                if(!mVisited.insert(entry.value).second){
+                    continue;
+                }
+            }
+            else {
+                entry = mFrontier.front();
+                mFrontier.pop_front();
+            }
+            mCurrent = entry;
+            const vector<string> & adjacencies = entry.value->adjacencies();
+            if(mOrder == TraversalOrder::DEPTH_FIRST){
+                // pushed in reverse so the first successor is visited first
+                for(size_t i = adjacencies.size(); i > 0; --i){
+                    push(&adjacencies[i - 1], find(adjacencies[i - 1]));
+                }
+            }
+            else {
+                for(auto const & adjacency : adjacencies){
+                    push(&adjacency, find(adjacency));
+                }
+            }
+            return;
+        }
+    }
+
+public:
+    /**
+     * Iterator over the vertices, in traversal order
+     */
+    class iterator {
+        GraphTraversal * mTraversal = nullptr;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = string;
+        using difference_type = std::ptrdiff_t;
+        using reference = const string &;
+        using pointer = const string *;
+
+        iterator() = default;
+        explicit iterator(GraphTraversal * traversal) : mTraversal(traversal) { }
+
+        /// The vertex's k-mer (valid until the iterator moves)
+        reference operator*() const { return *mTraversal->mCurrent.kmer; }
+        pointer operator->() const { return mTraversal->mCurrent.kmer; }
+
+        /// The vertex's value in the store
+        const DBGraphValue & value() const { return *mTraversal->mCurrent.value; }
+
+        iterator & operator++(){ mTraversal->advance(); return *this; }
+
+        /// Iterators compare equal when both are past the end
+        bool operator==(const iterator & other) const { return at_end() == other.at_end(); }
+        bool operator!=(const iterator & other) const { return !(*this == other); }
+
+    private:
+        bool at_end() const { return mTraversal == nullptr || mTraversal->mCurrent.kmer == nullptr; }
+    };
+
+    /**
+     * Iterator over the out-edges of the vertices, vertex by vertex in traversal order
+     */
+    class edge_iterator {
+        iterator mVertex;
+        size_t mIndex = 0;
+
+        /// Step over vertices with no successors
+        void settle(){
+            while(mVertex != iterator() && mIndex >= mVertex.value().adjacencies().size()){
+                ++mVertex;
+                mIndex = 0;
+            }
+        }
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<const string &, const string &>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+
+        edge_iterator() = default;
+        explicit edge_iterator(iterator vertex) : mVertex(vertex) { settle(); }
+
+        /// (from, to) k-mers of the edge
+        reference operator*() const { return reference(*mVertex, mVertex.value().adjacencies()[mIndex]); }
+
+        edge_iterator & operator++(){ ++mIndex; settle(); return *this; }
+
+        bool operator==(const edge_iterator & other) const { return mVertex == other.mVertex; }
+        bool operator!=(const edge_iterator & other) const { return !(*this == other); }
+    };
+
+    /**
+     * Range of edges for range-based for loops (see GraphTraversal::edges)
+     */
+    class edge_range {
+        /// Set when the range was made from a temporary traversal, which it then keeps alive
+        std::unique_ptr<GraphTraversal> mOwned;
+        GraphTraversal * mTraversal;
+    public:
+        explicit edge_range(GraphTraversal * traversal) : mTraversal(traversal) { }
+        explicit edge_range(GraphTraversal && traversal)
+            : mOwned(new GraphTraversal(std::move(traversal))), mTraversal(mOwned.get()) { }
+        edge_iterator begin(){ return edge_iterator(mTraversal->begin()); }
+        edge_iterator end(){ return edge_iterator(); }
+    };
+
+    /**
+     * @param graph graph to traverse (must outlive the traversal and not change during it)
+     * @param order depth or breadth first
+     */
+    GraphTraversal(const GraphT & graph, TraversalOrder order)
+        : mGraph(&graph), mOrder(order), mStarts(&graph.start_vertices()), mSweep(graph.vertices().begin()) { }
+
+    GraphTraversal(const GraphTraversal & other) = delete;
+    GraphTraversal & operator=(const GraphTraversal & other) = delete;
+    GraphTraversal(GraphTraversal && other) = default;
+
+    /**
+     * Start the traversal (only once per traversal object)
+     * @return iterator at the first vertex
+     */
+    iterator begin(){
+        advance();
+        return iterator(this);
+    }
+
+    iterator end(){ return iterator(); }
+
+    /**
+     * @return range over the out-edges of every vertex, in traversal order
+     */
+    edge_range edges() & { return edge_range(this); }
+    edge_range edges() && { return edge_range(std::move(*this)); }
+};
+
+/**
+ * Runs a function on every vertex of a graph on several threads, with work stealing
+ * @tparam GraphT graph type (see BasicDeBruijnGraph)
+ */
+template <typename GraphT>
+class ParallelTraversal {
+private:
+    /// A vertex to process: its k-mer (somewhere stable) and its value in the store
+    struct Entry {
+        const string * kmer;
+        const DBGraphValue * value;
+    };
+
+    /// One thread's work; it pops from the back, thieves take from the front
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Entry> entries;
+    };
+
+    /// Part of the visited set
+    struct VisitedShard {
+        std::mutex lock;
+        std::unordered_set<const DBGraphValue *> values;
+    };
+
+    static constexpr size_t VISITED_SHARDS = 64;
+
+    const GraphT & mGraph;
+    unsigned mThreads;
+    vector<WorkQueue> mQueues;
+    vector<VisitedShard> mVisited;
+
+    /// Vertices queued and not yet processed, over all queues
+    std::atomic<size_t> mPending{0};
+
+    /// Set when a thread's function throws, so the others stop
+    std::atomic<bool> mFailed{false};
+
+    /**
+     * Mark a vertex visited
+     * @return true if no thread had claimed it before
+     */
+    bool claim(const DBGraphValue * value){
+        VisitedShard & shard = mVisited[std::hash<const void *>{}(value) % VISITED_SHARDS];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.values.insert(value).second;
+    }
+
+    const DBGraphValue * find(const string & kmer) const {
+        auto it = mGraph.vertices().find(kmer);
+        return it == mGraph.vertices().end() ? nullptr : &it->second;
+    }
+
+    void push(size_t thread, Entry entry){
+        mPending++;
+        std::lock_guard<std::mutex> guard(mQueues[thread].lock);
+        mQueues[thread].entries.push_back(entry);
+    }
+
+    /**
+     * Take work from this thread's queue, or else from another's
+     * @return false if every queue was empty
+     */
+    bool take(size_t thread, Entry & entry){
+        {
+            WorkQueue & own = mQueues[thread];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if(!own.entries.empty()){
+                entry = own.entries.back();
+                own.entries.pop_back();
+                return true;
+            }
+        }
+        for(size_t offset = 1; offset < mQueues.size(); ++offset){
+            WorkQueue & victim = mQueues[(thread + offset) % mQueues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if(!victim.entries.empty()){
+                entry = victim.entries.front();
+                victim.entries.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Process queued vertices, and the ones they lead to, until no work is left anywhere
+     */
+    template <typename FuncType>
+    void work(size_t thread, FuncType & func){
+        Entry entry;
+        while(!mFailed){
+            if(!take(thread, entry)){
+                if(mPending == 0){
+                    return;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            func(*entry.kmer, *entry.value);
+            for(auto const & adjacency : entry.value->adjacencies()){
+                const DBGraphValue * value = find(adjacency);
+                if(value != nullptr && claim(value)){
+                    push(thread, Entry{&adjacency, value});
+                }
+            }
+            mPending--;
+        }
+    }
+
+    /**
+     * Run work on every thread until the queues are drained
+     */
+    template <typename FuncType>
+    void drain(FuncType & func){
+        vector<std::exception_ptr> errors(mThreads);
+        vector<std::thread> threads;
+        for(size_t i = 0; i < mThreads; ++i){
+            threads.emplace_back([this, &func, &errors, i] () {
+                try {
+                    work(i, func);
+                }
+                catch(...){
+                    errors[i] = std::current_exception();
+                    mFailed = true;
+                }
+            });
+        }
+        for(auto & thread : threads){ thread.join(); }
+        for(auto const & error : errors){
+            if(error){
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+public:
+    /**
+     * @param graph graph to traverse (must not change during the traversal)
+     * @param threads number of threads (0 for one per hardware thread)
+     */
+    explicit ParallelTraversal(const GraphT & graph, unsigned threads = 0)
+        : mGraph(graph), mThreads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          mQueues(mThreads), mVisited(VISITED_SHARDS) { }
+
+    /**
+     * Call func once on every vertex (only once per traversal object). Calls come from several threads at
+     * once, in no fixed order.
+     * @param func lambda taking (const string & kmer, const DBGraphValue & value); must be thread-safe
+     */
+    template <typename FuncType>
+    void run(FuncType func){
+        // everything reachable from the starts, which are dealt out to the threads
+        const vector<string> & starts = mGraph.start_vertices();
+        size_t next_thread = 0;
+        for(auto const & start : starts){
+            const DBGraphValue * value = find(start);
+            if(value != nullptr && claim(value)){
+                push(next_thread++ % mThreads, Entry{&start, value});
+            }
+        }
+        drain(func);
+        // then whatever only a cycle leads to
+        vector<string> rest;
+        for(auto const & vertex : mGraph.vertices()){
+            if(claim(&vertex.second)){
+                rest.push_back(vertex.first);
+            }
+        }
+        for(auto const & kmer : rest){
+            push(next_thread++ % mThreads, Entry{&kmer, find(kmer)});
+        }
+        drain(func);
+    }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_GRAPHTRAVERSAL_H
@@ -0,0 +1,66 @@
+/**
+ * @file KmerKernel.cpp
+ * @author Anna Catenacci
+ */
+
+#include "KmerKernel.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Deterministic pseudo-random words, so the test does not depend on a random library
+    vector<uint64_t> make_genome(size_t num_words, uint64_t seed){
+        vector<uint64_t> words(num_words);
+        for(auto & word : words){
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+        return words;
+    }
+}
+
+TEST_CASE("KmerKernel__codes", "[KmerKernel.hpp]")
+{
+    {
+        // lengths that end mid-word and on a word boundary, and k from 1 to 64
+        for(size_t num_bits : {size_t(3), size_t(64), size_t(130), size_t(1000)}){
+            vector<uint64_t> genome = make_genome((num_bits + 63) / 64, num_bits);
+            for(int k : {1, 3, 7, 31, 63, 64}){
+                if(size_t(k) > num_bits){
+                    continue;
+                }
+                size_t count = KmerKernel::kmer_count(num_bits, k);
+                vector<uint64_t> codes(count), scalar_codes(count);
+                KmerKernel::extract(genome.data(), num_bits, k, codes.data());
+                KmerKernel::extract(genome.data(), num_bits, k, scalar_codes.data(), false);
+                CHECK(codes == scalar_codes);
+
+                // every code spells the bits of its k-mer
+                bool spelled = true;
+                string kmer;
+                for(size_t i = 0; i < count; ++i){
+                    KmerKernel::decode(codes[i], k, kmer);
+                    for(int j = 0; j < k; ++j){
+                        bool bit = (genome[(i + j) / 64] >> ((i + j) % 64)) & 1;
+                        spelled = spelled && kmer[j] == (bit ? '1' : '0');
+                    }
+                }
+                CHECK(spelled);
+            }
+        }
+
+        vector<uint64_t> a = make_genome(4, 1), b = make_genome(4, 2);
+        vector<uint64_t> codes;
+        KmerKernel::extract_batch({a.data(), b.data()}, 200, 5, codes);
+        CHECK(codes.size() == 2 * 196);
+        vector<uint64_t> b_codes(196);
+        KmerKernel::extract(b.data(), 200, 5, b_codes.data());
+        CHECK(vector<uint64_t>(codes.begin() + 196, codes.end()) == b_codes);
+
+        CHECK(KmerKernel::kmer_count(2, 3) == 0);
+        CHECK_THROWS_AS(KmerKernel::extract(a.data(), 200, 65, codes.data()), std::invalid_argument);
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file KmerKernel.hpp
+ * @author Anna Catenacci
+ *
+ * Extracts every k-mer of a packed bit genome as an integer code in one pass over the genome's words.
+ * The graph keys its vertices (and its prefilter) by k-mer string, so callers decode the codes they need.
+ *
+ * Bit i of a genome is bit (i % 64) of word i / 64 (the layout emp::BitVector uses), and the code of the
+ * k-mer starting at bit i has genome bit i + j as its bit j, so k can be at most 64.
+ * On x86-64 CPUs with AVX2 four k-mers are computed per step; everywhere else (or when the CPU lacks
+ * AVX2) a scalar loop produces exactly the same codes. The choice is made at run time.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_KMERKERNEL_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_KMERKERNEL_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PANGENOMES_KMER_KERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+
+using std::string; using std::vector;
+
+class KmerKernel {
+public:
+    /// Longest k-mer that fits in a code
+    static constexpr int MAX_KMER_LENGTH = 64;
+
+private:
+
+    /**
+     * @param kmer_length k
+     * @return mask of the low k bits
+     */
+    static uint64_t kmer_mask(int kmer_length){
+        return kmer_length == 64 ? ~uint64_t(0) : (uint64_t(1) << kmer_length) - 1;
+    }
+
+    /**
+     * Check the arguments shared by every extraction function
+     * @param kmer_length k
+     */
+    static void check_kmer_length(int kmer_length){
+        if(kmer_length < 1 || kmer_length > MAX_KMER_LENGTH){
+            throw std::invalid_argument("KmerKernel: k-mer length must be between 1 and 64");
+        }
+    }
+
+    /**
+     * Code of one k-mer
+     * @param words packed genome
+     * @param num_words number of words in the genome
+     * @param position first bit of the k-mer
+     * @param mask kmer_mask(k)
+     */
+    static uint64_t code_at(const uint64_t * words, size_t num_words, size_t position, uint64_t mask){
+        size_t word = position / 64;
+        size_t shift = position % 64;
+        uint64_t code = words[word] >> shift;
+        if(shift != 0 && word + 1 < num_words){
+            code |= words[word + 1] << (64 - shift);
+        }
+        return code & mask;
+    }
+
+    /**
+     * Scalar extraction of k-mers [begin, end)
+     */
+    static void extract_scalar(const uint64_t * words, size_t num_words, int kmer_length, size_t begin, size_t end,
+                               uint64_t * codes){
+        uint64_t mask = kmer_mask(kmer_length);
+        for(size_t i = begin; i < end; ++i){
+            codes[i] = code_at(words, num_words, i, mask);
+        }
+    }
+
+#ifdef PANGENOMES_KMER_KERNEL_AVX2
+    /**
+     * AVX2 extraction of k-mers [0, end), four at a time; returns how many it did (the rest are left for
+     * the scalar loop). Every k-mer it handles has a next word to read, so no lane reads past the genome.
+     */
+    __attribute__((target("avx2")))
+    static size_t extract_avx2(const uint64_t * words, size_t num_words, int kmer_length, size_t end,
+                               uint64_t * codes){
+        if(num_words < 2){
+            return 0;
+        }
+        size_t safe_end = std::min(end, (num_words - 1) * 64);
+        const __m256i mask = _mm256_set1_epi64x(kmer_mask(kmer_length));
+        const __m256i sixty_four = _mm256_set1_epi64x(64);
+        const __m256i lane_offsets = _mm256_set_epi64x(3, 2, 1, 0);
+        size_t i = 0;
+        for(; i + 4 <= safe_end; i += 4){
+            __m256i positions = _mm256_add_epi64(_mm256_set1_epi64x(i), lane_offsets);
+            __m256i word_index = _mm256_srli_epi64(positions, 6);
+            __m256i shift = _mm256_and_si256(positions, _mm256_set1_epi64x(63));
+            __m256i low_words = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(words), word_index, 8);
+            __m256i high_words = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(words + 1), word_index, 8);
+            // a shift of 64 gives 0 with the variable-shift instructions, which is what shift == 0 needs
+            __m256i code = _mm256_or_si256(_mm256_srlv_epi64(low_words, shift),
+                                           _mm256_sllv_epi64(high_words, _mm256_sub_epi64(sixty_four, shift)));
+            code = _mm256_and_si256(code, mask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(codes + i), code);
+        }
+        return i;
+    }
+#endif
+
+public:
+    /**
+     * @return true if the vector path will be used on this CPU
+     */
+    static bool has_avx2(){
+#ifdef PANGENOMES_KMER_KERNEL_AVX2
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @param num_bits genome length
+     * @param kmer_length k
+     * @return number of k-mers in the genome
+     */
+    static size_t kmer_count(size_t num_bits, int kmer_length){
+        return num_bits < size_t(kmer_length) ? 0 : num_bits - kmer_length + 1;
+    }
+
+    /**
+     * Compute the code of every k-mer of a genome
+     * @param words packed genome
+     * @param num_bits number of bits in the genome
+     * @param kmer_length k (1-64)
+     * @param codes output, kmer_count(num_bits, k) entries
+     * @param use_simd set to false to force the scalar loop (for testing)
+     */
+    static void extract(const uint64_t * words, size_t num_bits, int kmer_length, uint64_t * codes,
+                        bool use_simd = true){
+        check_kmer_length(kmer_length);
+        size_t count = kmer_count(num_bits, kmer_length);
+        size_t num_words = (num_bits + 63) / 64;
+        size_t done = 0;
+#ifdef PANGENOMES_KMER_KERNEL_AVX2
+        if(use_simd && has_avx2()){
+            done = extract_avx2(words, num_words, kmer_length, count, codes);
+        }
+#endif
+        extract_scalar(words, num_words, kmer_length, done, count, codes);
+    }
+
+    /**
+     * Compute the codes of every k-mer of a batch of equal-length genomes in one call
+     * @param genomes packed genomes
+     * @param num_bits number of bits in each genome
+     * @param kmer_length k (1-64)
+     * @param codes filled with each genome's codes, one genome after the other
+     */
+    static void extract_batch(const vector<const uint64_t *> & genomes, size_t num_bits, int kmer_length,
+                              vector<uint64_t> & codes){
+        size_t count = kmer_count(num_bits, kmer_length);
+        codes.resize(count * genomes.size());
+        for(size_t g = 0; g < genomes.size(); ++g){
+            extract(genomes[g], num_bits, kmer_length, codes.data() + g * count);
+        }
+    }
+
+    /**
+     * Spell a code out as the k-mer string the graph uses ('0' and '1')
+     * @param code k-mer code
+     * @param kmer_length k
+     * @param kmer output, reused between calls to avoid allocating
+     */
+    static void decode(uint64_t code, int kmer_length, string & kmer){
+        kmer.resize(kmer_length);
+        for(int j = 0; j < kmer_length; ++j){
+            kmer[j] = '0' + ((code >> j) & 1);
+        }
+    }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_KMERKERNEL_H
@@ -0,0 +1,91 @@
+/**
+ * @file MetricsRecorder.cpp
+ * @author Anna Catenacci
+ */
+
+#include "MetricsRecorder.hpp"
+#include <sstream>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Add a genome built from a counter, so every generation changes the graph
+    void add_generation(DeBruijnGraph & graph, int generation){
+        string genome;
+        for(int bit = 0; bit < 16; ++bit){
+            genome += ((generation * 2654435761u) >> bit) & 1 ? '1' : '0';
+        }
+        graph.add_sequence(genome);
+    }
+}
+
+TEST_CASE("MetricsRecorder__csv-batches", "[MetricsRecorder.hpp]")
+{
+    {
+        DeBruijnGraph graph;
+        std::stringstream out;
+        {
+            MetricsRecorder<DeBruijnGraph> recorder(graph, &out, MetricsFormat::CSV, 8, 5);
+            for(int generation = 0; generation < 12; ++generation){
+                add_generation(graph, generation);
+                recorder.record(generation);
+                // rows are written in batches of five, not one at a time
+                CHECK(recorder.pending() == size_t((generation + 1) % 5));
+            }
+            MetricsRow last = recorder.rows().back();
+            CHECK(last.generation == 11);
+            CHECK(last.sequences == 12);
+            CHECK(last.vertices == graph.get_size());
+            CHECK(last.edges == graph.edge_count());
+            CHECK(last.kmer_entropy == graph.statistics().kmer_entropy());
+            CHECK(recorder.rows().size() == 8);
+        } // the last two rows are written when the recorder goes away
+
+        vector<string> lines;
+        for(string line; std::getline(out, line); ){
+            lines.push_back(line);
+        }
+        REQUIRE(lines.size() == 13);
+        CHECK(lines[0] == MetricsRow::CSV_HEADER);
+        CHECK(lines[1].substr(0, 4) == "0,1,");
+        CHECK(lines[12].substr(0, 6) == "11,12,");
+    }
+}
+
+TEST_CASE("MetricsRecorder__binary-and-in-memory", "[MetricsRecorder.hpp]")
+{
+    {
+        DeBruijnGraph graph;
+        std::stringstream out;
+        MetricsRecorder<DeBruijnGraph> recorder(graph, &out, MetricsFormat::BINARY, 4);
+        vector<MetricsRow> expected;
+        for(int generation = 0; generation < 10; ++generation){
+            add_generation(graph, generation);
+            recorder.record(generation);
+            expected.push_back(recorder.sample(generation));
+        }
+        recorder.flush();
+        vector<MetricsRow> read = MetricsRecorder<DeBruijnGraph>::read_binary(out);
+        REQUIRE(read.size() == expected.size());
+        for(size_t i = 0; i < read.size(); ++i){
+            CHECK(read[i].generation == expected[i].generation);
+            CHECK(read[i].vertices == expected[i].vertices);
+            CHECK(read[i].memory_bytes == expected[i].memory_bytes);
+            CHECK(read[i].mean_out_degree == expected[i].mean_out_degree);
+        }
+        std::stringstream not_metrics("hello world, this is not a metrics file");
+        CHECK_THROWS_AS(MetricsRecorder<DeBruijnGraph>::read_binary(not_metrics), std::runtime_error);
+
+        // without an output stream the newest rows are kept and the oldest overwritten
+        MetricsRecorder<DeBruijnGraph> history(graph, nullptr, MetricsFormat::CSV, 3);
+        for(int generation = 0; generation < 5; ++generation){
+            history.record(generation);
+        }
+        vector<MetricsRow> kept = history.rows();
+        REQUIRE(kept.size() == 3);
+        CHECK(kept[0].generation == 2);
+        CHECK(kept[2].generation == 4);
+        CHECK(history.dropped() == 2);
+        CHECK_THROWS_AS(MetricsRecorder<DeBruijnGraph>(graph, nullptr, MetricsFormat::CSV, 0), std::invalid_argument);
+    }
+}
@@ -0,0 +1,300 @@
+/**
+ * @file MetricsRecorder.hpp
+ * @author Anna Catenacci
+ *
+ * Records a fixed set of pangenome metrics every generation into a preallocated ring buffer, and writes them
+ * out in large batches instead of one line at a time.
+ *
+ * Typical use in a MABE run:
+ *     std::ofstream out("pangenome_metrics.csv");
+ *     MetricsRecorder<DeBruijnGraph> recorder(graph, &out, MetricsFormat::CSV, 4096, 1000);
+ *     ...
+ *     recorder.record(generation);        // every generation: a few counter reads and one copy
+ *     ...
+ *     recorder.flush();                   // at shutdown (the destructor also flushes)
+ *
+ * Without an output stream the recorder keeps the most recent rows in memory, overwriting the oldest once the
+ * buffer is full (see rows() and dropped()).
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_METRICSRECORDER_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_METRICSRECORDER_H
+
+#include "DeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <ostream>
+#include <istream>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * One generation's metrics. Plain data, so batches are written to binary files as they are in memory.
+ */
+struct MetricsRow {
+    int64_t generation = 0;
+    int64_t sequences = 0;
+    int64_t vertices = 0;
+    int64_t edges = 0;
+    int64_t branch_vertices = 0;
+    int64_t endpoints = 0;
+    int64_t endpoint_vertices = 0;
+    int64_t total_occurrences = 0;
+    int64_t singleton_kmers = 0;
+    int64_t memory_bytes = 0;
+    double kmer_entropy = 0;
+    double mean_out_degree = 0;
+
+    /// Column names, in the order write_csv_row writes them
+    static constexpr const char * CSV_HEADER = "generation,sequences,vertices,edges,branch_vertices,endpoints,"
+        "endpoint_vertices,total_occurrences,singleton_kmers,memory_bytes,kmer_entropy,mean_out_degree";
+
+    /**
+     * Write the row as one CSV line
+     * @param out stream to write to
+     */
+    void write_csv_row(std::ostream & out) const {
+        out << generation << ',' << sequences << ',' << vertices << ',' << edges << ',' << branch_vertices << ','
+            << endpoints << ',' << endpoint_vertices << ',' << total_occurrences << ',' << singleton_kmers << ','
+            << memory_bytes << ',' << kmer_entropy << ',' << mean_out_degree << '\n';
+    }
+};
+
+/// How a MetricsRecorder writes its batches
+enum class MetricsFormat {
+    /// A header line, then one line per generation
+    CSV,
+    /// A small header ("PGMR", version, row size), then the rows as raw MetricsRow structs
+    BINARY
+};
+
+template <typename GraphT>
+class MetricsRecorder {
+public:
+    /// First four bytes of a binary metrics file
+    static constexpr char BINARY_MAGIC[4] = {'P', 'G', 'M', 'R'};
+    static constexpr uint32_t BINARY_VERSION = 1;
+
+private:
+    /// Graph the metrics are read from
+    const GraphT & mGraph;
+
+    /// Where batches are written (nullptr to keep rows in memory only)
+    std::ostream * mOut;
+
+    MetricsFormat mFormat;
+
+    /// Ring buffer of rows, allocated once
+    vector<MetricsRow> mRows;
+
+    /// Index of the oldest retained row in mRows
+    size_t mFirst = 0;
+
+    /// Number of retained rows
+    size_t mCount = 0;
+
+    /// Number of retained rows not yet written out
+    size_t mPending = 0;
+
+    /// Write a batch once this many rows are pending
+    size_t mFlushInterval;
+
+    /// Rows overwritten before they were written out (only without an output stream)
+    size_t mDropped = 0;
+
+    /// True once the CSV header or binary header has been written
+    bool mHeaderWritten = false;
+
+    /**
+     * @param i position counting from the oldest retained row
+     * @return row at that position
+     */
+    const MetricsRow & at(size_t i) const { return mRows[(mFirst + i) % mRows.size()]; }
+
+    /**
+     * Write the header, if it has not been written yet
+     */
+    void write_header(){
+        if(mHeaderWritten){
+            return;
+        }
+        if(mFormat == MetricsFormat::CSV){
+            *mOut << MetricsRow::CSV_HEADER << '\n';
+        }
+        else {
+            uint32_t version = BINARY_VERSION;
+            uint32_t row_size = sizeof(MetricsRow);
+            mOut->write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+            mOut->write(reinterpret_cast<const char *>(&version), sizeof(version));
+            mOut->write(reinterpret_cast<const char *>(&row_size), sizeof(row_size));
+        }
+        mHeaderWritten = true;
+    }
+
+    /**
+     * Write rows [begin, end) of the ring (counting from the oldest), which must not wrap around
+     */
+    void write_span(size_t begin, size_t end){
+        if(mFormat == MetricsFormat::CSV){
+            for(size_t i = begin; i < end; ++i){
+                mRows[i].write_csv_row(*mOut);
+            }
+        }
+        else {
+            mOut->write(reinterpret_cast<const char *>(mRows.data() + begin), (end - begin) * sizeof(MetricsRow));
+        }
+    }
+
+public:
+    /**
+     * @param graph graph to record; it must outlive the recorder
+     * @param out stream batches are written to, or nullptr to keep the rows in memory only
+     * @param format CSV or binary
+     * @param capacity number of rows the buffer holds
+     * @param flush_interval write a batch once this many rows are pending (at most capacity; 0 means capacity)
+     */
+    MetricsRecorder(const GraphT & graph, std::ostream * out = nullptr, MetricsFormat format = MetricsFormat::CSV,
+                    size_t capacity = 4096, size_t flush_interval = 0)
+        : mGraph(graph), mOut(out), mFormat(format), mRows(capacity),
+          mFlushInterval(flush_interval == 0 || flush_interval > capacity ? capacity : flush_interval) {
+        if(capacity == 0){
+            throw std::invalid_argument("MetricsRecorder: capacity must be at least 1");
+        }
+    }
+
+    MetricsRecorder(const MetricsRecorder &) = delete;
+    MetricsRecorder & operator=(const MetricsRecorder &) = delete;
+
+    ~MetricsRecorder(){
+        try {
+            flush();
+        }
+        catch(...){
+        }
+    }
+
+    /**
+     * Read the graph's metrics now
+     * @param generation generation to label the row with
+     * @return the row
+     */
+    MetricsRow sample(int64_t generation) const {
+        const DeBruijnStatistics & stats = mGraph.statistics();
+        MetricsRow row;
+        row.generation = generation;
+        row.sequences = mGraph.get_sequence_size();
+        row.vertices = stats.vertices;
+        row.edges = stats.edges;
+        row.branch_vertices = stats.branch_vertices;
+        row.endpoints = stats.endpoints;
+        row.endpoint_vertices = stats.endpoint_vertices;
+        row.total_occurrences = stats.total_occurrences;
+        row.singleton_kmers = stats.singleton_kmers;
+        row.memory_bytes = mGraph.memory_usage().total();
+        row.kmer_entropy = stats.kmer_entropy();
+        row.mean_out_degree = stats.mean_out_degree();
+        return row;
+    }
+
+    /**
+     * Append this generation's metrics, writing a batch out if enough rows are pending
+     * @param generation generation to label the row with
+     */
+    void record(int64_t generation){
+        if(mCount == mRows.size()){
+            // the oldest row gives way; it has only not been written out if there is no output stream
+            bool oldest_pending = mPending == mCount;
+            mFirst = (mFirst + 1) % mRows.size();
+            mCount--;
+            if(oldest_pending){
+                mPending--;
+                mDropped++;
+            }
+        }
+        mRows[(mFirst + mCount) % mRows.size()] = sample(generation);
+        mCount++;
+        mPending++;
+        if(mOut && mPending >= mFlushInterval){
+            flush();
+        }
+    }
+
+    /**
+     * Write every pending row out (does nothing without an output stream). Written rows stay readable
+     * through rows() until they are overwritten.
+     */
+    void flush(){
+        if(!mOut || mPending == 0){
+            return;
+        }
+        write_header();
+        size_t begin = (mFirst + mCount - mPending) % mRows.size();
+        size_t end = begin + mPending;
+        if(end > mRows.size()){
+            write_span(begin, mRows.size());
+            write_span(0, end - mRows.size());
+        }
+        else {
+            write_span(begin, end);
+        }
+        mOut->flush();
+        mPending = 0;
+        if(!*mOut){
+            throw std::runtime_error("MetricsRecorder: could not write metrics");
+        }
+    }
+
+    /**
+     * @return retained rows, oldest first
+     */
+    vector<MetricsRow> rows() const {
+        vector<MetricsRow> retained;
+        retained.reserve(mCount);
+        for(size_t i = 0; i < mCount; ++i){
+            retained.push_back(at(i));
+        }
+        return retained;
+    }
+
+    /**
+     * @return number of rows recorded but not yet written out
+     */
+    size_t pending() const { return mPending; }
+
+    /**
+     * @return number of rows overwritten before they could be written out
+     */
+    size_t dropped() const { return mDropped; }
+
+    /**
+     * @return number of rows the buffer holds
+     */
+    size_t capacity() const { return mRows.size(); }
+
+    /**
+     * Read back a file written in MetricsFormat::BINARY
+     * @param in stream positioned at the start of the file
+     * @return every row in the file
+     */
+    static vector<MetricsRow> read_binary(std::istream & in){
+        char magic[4];
+        uint32_t version = 0, row_size = 0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char *>(&version), sizeof(version));
+        in.read(reinterpret_cast<char *>(&row_size), sizeof(row_size));
+        if(!in || std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0 || version != BINARY_VERSION
+           || row_size != sizeof(MetricsRow)){
+            throw std::runtime_error("MetricsRecorder::read_binary: not a metrics file from this version");
+        }
+        vector<MetricsRow> rows;
+        MetricsRow row;
+        while(in.read(reinterpret_cast<char *>(&row), sizeof(row))){
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_METRICSRECORDER_H
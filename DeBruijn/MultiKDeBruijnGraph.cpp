@@ -0,0 +1,100 @@
+/**
+ * @file MultiKDeBruijnGraph.cpp
+ * @author Anna Catenacci
+ */
+
+#include "MultiKDeBruijnGraph.hpp"
+#include "GraphContents.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    vector<uint64_t> pack(const string & genome){
+        vector<uint64_t> words((genome.size() + 63) / 64, 0);
+        for(size_t i = 0; i < genome.size(); ++i){
+            if(genome[i] == '1'){
+                words[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+        return words;
+    }
+}
+
+TEST_CASE("MultiKDeBruijnGraph__levels-match-separate-graphs", "[MultiKDeBruijnGraph.hpp]")
+{
+    {
+        MultiKDeBruijnGraph multi({8, 3, 70, 5, 3});
+        CHECK(multi.kmer_lengths() == vector<int>{3, 5, 8, 70});
+        CHECK_THROWS_AS(multi.level(4), std::invalid_argument);
+        CHECK_THROWS_AS(MultiKDeBruijnGraph({}), std::invalid_argument);
+
+        vector<DeBruijnGraph> separate;
+        for(int k : multi.kmer_lengths()){
+            separate.emplace_back(k);
+        }
+        emp::Random random(47);
+        vector<string> population;
+        for(int i = 0; i < 30; ++i){
+            string genome;
+            for(int j = 0; j < 100; ++j){
+                genome += random.P(0.5) ? '1' : '0';
+            }
+            population.push_back(genome);
+            // half of them arrive packed, read once for every level
+            if(i % 2){
+                vector<uint64_t> words = pack(genome);
+                multi.add_sequence(words.data(), genome.size());
+            }
+            else {
+                multi.add_sequence(genome);
+            }
+            for(auto & g : separate){
+                g.add_sequence(genome);
+            }
+        }
+        // genomes shorter than some of the k-mers
+        multi.add_sequence("0110");
+        uint64_t short_genome = 0b1011011;
+        multi.add_sequence(&short_genome, 7);
+        for(auto & g : separate){
+            g.add_sequence("0110");
+            g.add_sequence("1101101");
+        }
+        for(auto & g : separate){
+            CHECK(graph_contents(multi.level(g.get_kmer_len())) == graph_contents(g));
+        }
+
+        // crossover on one level replaces the parent everywhere
+        emp::Random multi_random(5), separate_random(5);
+        for(int i = 0; i < 10; ++i){
+            int k = multi.kmer_lengths()[i % 3];
+            string child = multi.modify_org(multi_random, population[i], k);
+            DeBruijnGraph & chosen = separate[i % 3];
+            CHECK(child == chosen.modify_org(separate_random, population[i]));
+            CHECK(multi.is_valid(child, k));
+            for(auto & g : separate){
+                if(&g != &chosen){
+                    g.update_sequence(population[i], child);
+                }
+            }
+            population[i] = child;
+        }
+        for(int i = 10; i < 20; ++i){
+            vector<uint64_t> words = pack(population[i]);
+            multi.remove_sequence(words.data(), population[i].size());
+            for(auto & g : separate){
+                g.remove_sequence(population[i]);
+            }
+        }
+        multi.remove_sequence(population[25]);
+        size_t separate_bytes = 0;
+        for(auto & g : separate){
+            g.remove_sequence(population[25]);
+            CHECK(graph_contents(multi.level(g.get_kmer_len())) == graph_contents(g));
+            CHECK(multi.level(g.get_kmer_len()).get_sequence_size() == g.get_sequence_size());
+            separate_bytes += g.memory_usage().total();
+        }
+        CHECK(multi.memory_bytes() == separate_bytes);
+    }
+}
@@ -0,0 +1,236 @@
+/**
+ * @file MultiKDeBruijnGraph.hpp
+ * @author Anna Catenacci
+ *
+ * Several DeBruijnGraphs of the same population, one per k-mer length, kept in step so a k sweep is one run
+ * instead of one run per k.
+ *
+ * Every genome is added to and removed from all levels at once. A packed bit genome is read once: the
+ * KmerKernel extracts the codes of its longest k-mers, and since a shorter k-mer is the low bits of the longer
+ * code that starts at the same position, every level takes its k-mers from that one window. String genomes
+ * are walked in place by every level, without copying. Each level still keeps its own vertex store, as
+ * k-mers of different lengths are different keys.
+ *
+ * The level to breed from is chosen per call, and the child replaces its parent in every level:
+ *     MultiKDeBruijnGraph graph({3, 5, 8});
+ *     ...
+ *     string child = graph.modify_org(random, parent, 5);
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_MULTIKDEBRUIJNGRAPH_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_MULTIKDEBRUIJNGRAPH_H
+
+#include "DeBruijnGraph.hpp"
+#include "KmerKernel.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+class MultiKDeBruijnGraph {
+private:
+    /// One graph per k, in increasing order of k
+    vector<DeBruijnGraph> mLevels;
+
+    /**
+     * @param kmer_length k
+     * @return the level with that k
+     */
+    DeBruijnGraph & find_level(int kmer_length){
+        for(auto & level : mLevels){
+            if(level.get_kmer_len() == kmer_length){
+                return level;
+            }
+        }
+        throw std::invalid_argument("MultiKDeBruijnGraph: no level has k = " + std::to_string(kmer_length));
+    }
+
+    /**
+     * Run a sequence function of every level on a packed bit genome, extracting its k-mers only once
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     * @param body lambda taking (DeBruijnGraph & level, kmer_at, count)
+     */
+    template <typename FuncType>
+    void for_each_level_packed(const uint64_t * words, size_t num_bits, FuncType body){
+        // the longest k whose k-mers fit in a code and in the genome provides the shared window
+        int window = 0;
+        for(auto const & level : mLevels){
+            if(level.get_kmer_len() <= KmerKernel::MAX_KMER_LENGTH && size_t(level.get_kmer_len()) <= num_bits){
+                window = level.get_kmer_len();
+            }
+        }
+        vector<uint64_t> codes;
+        if(window > 0){
+            codes.resize(KmerKernel::kmer_count(num_bits, window));
+            KmerKernel::extract(words, num_bits, window, codes.data());
+        }
+        for(auto & level : mLevels){
+            int kmer_length = level.get_kmer_len();
+            if(kmer_length > window){
+                level.with_packed_kmers(words, num_bits, [&level, &body] (auto kmer_at, size_t count) { body(level, kmer_at, count); });
+                continue;
+            }
+            // k-mers past the last window start are read further along the last window
+            size_t last = codes.size() - 1;
+            uint64_t mask = kmer_length == 64 ? ~uint64_t(0) : (uint64_t(1) << kmer_length) - 1;
+            auto kmer_at = [&codes, last, mask, kmer_length] (size_t i, string & kmer) {
+                uint64_t code = i <= last ? codes[i] : codes[last] >> (i - last);
+                KmerKernel::decode(code & mask, kmer_length, kmer);
+            };
+            body(level, kmer_at, num_bits - kmer_length + 1);
+        }
+    }
+
+public:
+    /**
+     * @param kmer_lengths the k of every level (in any order, each at least 1)
+     */
+    explicit MultiKDeBruijnGraph(vector<int> kmer_lengths){
+        std::sort(kmer_lengths.begin(), kmer_lengths.end());
+        kmer_lengths.erase(std::unique(kmer_lengths.begin(), kmer_lengths.end()), kmer_lengths.end());
+        if(kmer_lengths.empty() || kmer_lengths.front() < 1){
+            throw std::invalid_argument("MultiKDeBruijnGraph: needs at least one k, and every k must be at least 1");
+        }
+        for(int kmer_length : kmer_lengths){
+            mLevels.emplace_back(kmer_length);
+        }
+    }
+
+    /**
+     * @return the k of every level, in increasing order
+     */
+    vector<int> kmer_lengths() const {
+        vector<int> lengths;
+        for(auto const & level : mLevels){
+            lengths.push_back(level.get_kmer_len());
+        }
+        return lengths;
+    }
+
+    /**
+     * @param kmer_length k of a level
+     * @return that level's graph, for queries (statistics, is_valid, write_csv, ...)
+     */
+    const DeBruijnGraph & level(int kmer_length) const {
+        return const_cast<MultiKDeBruijnGraph *>(this)->find_level(kmer_length);
+    }
+
+///@remark POPULATION /////////////////////////////////////////////////////////////
+
+    /**
+     * Add a genome to every level
+     * To be used in OnOffspringReady in MABE
+     * @param sequence to add
+     */
+    void add_sequence(const string & sequence){
+        for(auto & level : mLevels){
+            size_t kmer_length = level.get_kmer_len();
+            level.add_kmers([&sequence, kmer_length] (size_t i, string & kmer) { kmer.assign(sequence, i, kmer_length); },
+                            level.walk_length(sequence.size()), sequence.size());
+        }
+    }
+
+    /**
+     * Add a packed bit genome (same layout as DeBruijnGraph::add_sequence) to every level, reading it once
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     */
+    void add_sequence(const uint64_t * words, size_t num_bits){
+        for_each_level_packed(words, num_bits, [num_bits] (DeBruijnGraph & level, auto kmer_at, size_t count) {
+            level.add_kmers(kmer_at, count, num_bits);
+        });
+    }
+
+    /**
+     * Remove a genome from every level (a level where it is not valid is left alone)
+     * To be used in BeforeDeath in MABE
+     * @param sequence to remove
+     */
+    void remove_sequence(const string & sequence){
+        for(auto & level : mLevels){
+            level.remove_sequence(sequence);
+        }
+    }
+
+    /**
+     * Remove a packed bit genome from every level, reading it once
+     * @param words packed bits of the genome
+     * @param num_bits number of bits in the genome
+     */
+    void remove_sequence(const uint64_t * words, size_t num_bits){
+        for_each_level_packed(words, num_bits, [] (DeBruijnGraph & level, auto kmer_at, size_t count) {
+            level.remove_kmers(kmer_at, count);
+        });
+    }
+
+    /**
+     * Replace a genome with another in every level (see DeBruijnGraph::update_sequence)
+     * @param old_sequence genome to replace
+     * @param new_sequence genome to add in its place
+     */
+    void update_sequence(const string & old_sequence, const string & new_sequence){
+        for(auto & level : mLevels){
+            level.update_sequence(old_sequence, new_sequence);
+        }
+    }
+
+///@remark CROSSOVER /////////////////////////////////////////////////////////////
+
+    /**
+     * Build a new genome by walking one level, without changing any level (see DeBruijnGraph::sample_path)
+     * @param random random number generator (see RandomPolicy.hpp)
+     * @param organism whose genome we are modifying
+     * @param kmer_length k of the level to walk
+     * @param probability that the modification will take place (otherwise organism is returned)
+     * @param seq_count see DeBruijnGraph::sample_path
+     * @param variable_length false if the genome must be a fixed, standard length
+     * @return the new genome
+     */
+    template <typename RandomT>
+    string sample_path(RandomT & random, const string & organism, int kmer_length, double probability = 1,
+                       bool seq_count = 1, bool variable_length = 0) const {
+        return level(kmer_length).sample_path(random, organism, probability, seq_count, variable_length);
+    }
+
+    /**
+     * Do crossover on one level and replace the organism's genome with the result in every level, so all
+     * levels keep describing the same population
+     * @param random random number generator (see RandomPolicy.hpp)
+     * @param organism whose genome we are modifying
+     * @param kmer_length k of the level to walk
+     * @param probability that the modification will take place
+     * @param seq_count see DeBruijnGraph::sample_path
+     * @param variable_length false if the genome must be a fixed, standard length
+     * @return the new genome
+     */
+    template <typename RandomT>
+    string modify_org(RandomT & random, const string & organism, int kmer_length, double probability = 1,
+                      bool seq_count = 1, bool variable_length = 0){
+        string path = sample_path(random, organism, kmer_length, probability, seq_count, variable_length);
+        if(path != organism){
+            update_sequence(organism, path);
+        }
+        return path;
+    }
+
+    /**
+     * @param sequence to evaluate
+     * @param kmer_length k of the level to check it against
+     * @return true if the sequence is a path of that level
+     */
+    bool is_valid(const string & sequence, int kmer_length) const { return level(kmer_length).is_valid(sequence); }
+
+    /**
+     * @return estimated bytes used by every level together (see DeBruijnGraph::memory_usage)
+     */
+    size_t memory_bytes() const {
+        size_t bytes = 0;
+        for(auto const & level : mLevels){
+            bytes += level.memory_usage().total();
+        }
+        return bytes;
+    }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_MULTIKDEBRUIJNGRAPH_H
@@ -0,0 +1,76 @@
+/**
+ * @file PathArchive.cpp
+ * @author Anna Catenacci
+ */
+
+#include "PathArchive.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("PathArchive__round-trip", "[PathArchive.hpp]")
+{
+    {
+        // a low-diversity population: copies of a few point mutants of one ancestor, of a few different lengths
+        emp::Random random(17);
+        string ancestor;
+        for(int i = 0; i < 200; ++i){
+            ancestor += random.P(0.5) ? '1' : '0';
+        }
+        vector<string> variants;
+        for(int v = 0; v < 10; ++v){
+            string variant = ancestor.substr(0, 200 - random.GetUInt(3));
+            for(int m = 0; m < 2; ++m){
+                size_t site = random.GetUInt(variant.size());
+                variant[site] = variant[site] == '1' ? '0' : '1';
+            }
+            variants.push_back(variant);
+        }
+        vector<string> population;
+        DeBruijnGraph graph(12);
+        for(int i = 0; i < 500; ++i){
+            population.push_back(variants[random.GetUInt(variants.size())]);
+            graph.add_sequence(population.back());
+        }
+
+        PathArchive archive(graph);
+        for(auto const & genome : population){
+            archive.add(genome);
+        }
+        CHECK(archive.size() == population.size());
+        for(size_t i = 0; i < population.size(); ++i){
+            CHECK(archive.decode(i) == population[i]);
+            CHECK(archive.genome_length(i) == population[i].size());
+        }
+
+        // a few bits per genome instead of a byte per site
+        size_t raw_bytes = 0;
+        for(auto const & genome : population){
+            raw_bytes += genome.size();
+        }
+        CHECK(archive.size_in_bytes() * 20 < raw_bytes);
+        CHECK(archive.bits_per_genome() < 100);
+
+        // packed bits match the string
+        vector<uint64_t> words = archive.decode_bits(3);
+        for(size_t i = 0; i < population[3].size(); ++i){
+            CHECK(bool((words[i / 64] >> (i % 64)) & 1) == (population[3][i] == '1'));
+        }
+
+        // genomes that are not paths of the snapshot cannot be archived
+        CHECK_THROWS_AS(archive.add("0101"), std::invalid_argument);
+        string stranger = population[0];
+        stranger.replace(50, 20, "00000000000000000000");
+        CHECK_THROWS_AS(archive.add(stranger), std::invalid_argument);
+        CHECK_THROWS_AS(archive.decode(population.size() + 1), std::out_of_range);
+
+        // the snapshot is shared, and outlives the graph it was frozen from
+        auto snapshot = std::make_shared<const SuccinctDeBruijnGraph>(graph);
+        PathArchive first(snapshot), second(snapshot);
+        graph = DeBruijnGraph(12);
+        first.add(population[9]);
+        second.add(population[10]);
+        CHECK(first.decode(0) == population[9]);
+        CHECK(second.decode(0) == population[10]);
+    }
+}
@@ -0,0 +1,284 @@
+/**
+ * @file PathArchive.hpp
+ * @author Anna Catenacci
+ *
+ * Stores genomes as paths through a frozen pangenome, so whole generations can be archived in memory.
+ *
+ * A genome is encoded as the rank of its first k-mer in a SuccinctDeBruijnGraph snapshot, followed only by
+ * the choices it makes at branch vertices (ceil(log2(out-degree)) bits each); every step through a vertex
+ * with a single successor costs nothing. Each record is:
+ *     gamma(zigzag(length - snapshot length) + 1), start rank (fixed width), gamma(choice bits + 1), choices
+ * (gamma is Elias gamma). In a low-diversity population most of a genome is non-branching, so a record is a
+ * few bytes however long the genome is. The snapshot is frozen, so its successor order never changes and
+ * records stay decodable for as long as the archive keeps the snapshot.
+ *
+ * Typical use at the end of a generation:
+ *     PathArchive archive(graph);                   // freeze this generation's pangenome
+ *     for(auto & org : population){ archive.add(org.genome); }
+ *     ...
+ *     string genome = archive.decode(17);
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHARCHIVE_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHARCHIVE_H
+
+#include "SuccinctDeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+
+class PathArchive {
+private:
+    /// Records between two stored offsets
+    static constexpr size_t RECORDS_PER_OFFSET = 64;
+
+    /// Graph the paths run through
+    std::shared_ptr<const SuccinctDeBruijnGraph> mSnapshot;
+
+    /// Every record, back to back, 64 bits to a word
+    vector<uint64_t> mWords;
+
+    /// Number of bits written
+    size_t mBitCount = 0;
+
+    /// Bit offset of every RECORDS_PER_OFFSET-th record
+    vector<size_t> mOffsets;
+
+    /// Number of records
+    size_t mCount = 0;
+
+    /// Bits in a start-vertex rank
+    int mVertexWidth = 0;
+
+    /**
+     * @return number of bits needed to tell apart count different values
+     */
+    static int width_for(size_t count){
+        int width = 0;
+        while(width < 64 && (uint64_t(1) << width) < count){
+            width++;
+        }
+        return width;
+    }
+
+    /**
+     * Append the low width bits of a value, lowest bit first
+     */
+    void write_bits(uint64_t value, int width){
+        for(int written = 0; written < width; ){
+            if(mBitCount % 64 == 0){
+                mWords.push_back(0);
+            }
+            int room = std::min(width - written, 64 - int(mBitCount % 64));
+            uint64_t piece = (value >> written) & (room == 64 ? ~uint64_t(0) : (uint64_t(1) << room) - 1);
+            mWords.back() |= piece << (mBitCount % 64);
+            written += room;
+            mBitCount += room;
+        }
+    }
+
+    /**
+     * Read width bits written by write_bits
+     * @param position bit offset to read from, moved past the bits
+     */
+    uint64_t read_bits(size_t & position, int width) const {
+        uint64_t value = 0;
+        for(int read = 0; read < width; ){
+            int room = std::min(width - read, 64 - int(position % 64));
+            uint64_t piece = (mWords[position / 64] >> (position % 64)) & (room == 64 ? ~uint64_t(0) : (uint64_t(1) << room) - 1);
+            value |= piece << read;
+            read += room;
+            position += room;
+        }
+        return value;
+    }
+
+    /**
+     * Elias gamma code of a value of at least 1: n zeros, a one, then the low n bits
+     */
+    void write_gamma(uint64_t value){
+        int bits = 63 - __builtin_clzll(value);
+        write_bits(uint64_t(1) << bits, bits + 1);
+        write_bits(value, bits);
+    }
+
+    uint64_t read_gamma(size_t & position) const {
+        int bits = 0;
+        while(!read_bits(position, 1)){
+            bits++;
+        }
+        return (uint64_t(1) << bits) | read_bits(position, bits);
+    }
+
+    /**
+     * Read a record's header and move past it
+     * @param position bit offset of the record, left at its first choice
+     * @param length set to the genome's length
+     * @param start set to the rank of its first k-mer
+     * @return number of choice bits that follow
+     */
+    size_t read_header(size_t & position, size_t & length, size_t & start) const {
+        uint64_t zigzag = read_gamma(position) - 1;
+        int64_t difference = (zigzag & 1) ? -int64_t(zigzag >> 1) - 1 : int64_t(zigzag >> 1);
+        length = size_t(mSnapshot->get_sequence_length() + difference);
+        start = read_bits(position, mVertexWidth);
+        return read_gamma(position) - 1;
+    }
+
+    /**
+     * @param index record number
+     * @return bit offset of the record
+     */
+    size_t record_offset(size_t index) const {
+        if(index >= mCount){
+            throw std::out_of_range("PathArchive: no genome has index " + std::to_string(index));
+        }
+        size_t position = mOffsets[index / RECORDS_PER_OFFSET];
+        for(size_t skip = index % RECORDS_PER_OFFSET; skip > 0; --skip){
+            size_t length, start;
+            position += read_header(position, length, start);
+        }
+        return position;
+    }
+
+public:
+    /**
+     * @param snapshot frozen graph every archived genome must be a path of
+     */
+    explicit PathArchive(std::shared_ptr<const SuccinctDeBruijnGraph> snapshot)
+        : mSnapshot(std::move(snapshot)), mVertexWidth(width_for(mSnapshot->vertex_count())) { }
+
+    /**
+     * Freeze a graph and archive against it
+     * @param graph current pangenome
+     */
+    explicit PathArchive(const DeBruijnGraph & graph) : PathArchive(std::make_shared<const SuccinctDeBruijnGraph>(graph)) { }
+
+    /**
+     * Encode a genome
+     * @param genome a genome whose every k-mer and edge is in the snapshot
+     * @return index to decode it by
+     */
+    size_t add(const string & genome){
+        int kmer_length = mSnapshot->get_kmer_len();
+        size_t start = mSnapshot->find_vertex(genome.substr(0, kmer_length));
+        if(int(genome.size()) < kmer_length || start == SuccinctDeBruijnGraph::NOT_FOUND){
+            throw std::invalid_argument("PathArchive::add: genome does not start at a k-mer of the snapshot");
+        }
+        // work out the choices first, so the header can give their total length
+        vector<std::pair<size_t, int>> choices;
+        size_t choice_bits = 0;
+        size_t current = start;
+        for(size_t i = kmer_length; i < genome.size(); ++i){
+            size_t degree = 0, chosen = 0, next = SuccinctDeBruijnGraph::NOT_FOUND;
+            mSnapshot->for_each_successor(current, [&] (size_t target, size_t label) {
+                if(mSnapshot->symbol(label) == genome[i]){
+                    chosen = degree;
+                    next = target;
+                }
+                degree++;
+            });
+            if(next == SuccinctDeBruijnGraph::NOT_FOUND){
+                throw std::invalid_argument("PathArchive::add: genome leaves the snapshot at position " + std::to_string(i));
+            }
+            if(degree > 1){
+                choices.emplace_back(chosen, width_for(degree));
+                choice_bits += choices.back().second;
+            }
+            current = next;
+        }
+
+        if(mCount % RECORDS_PER_OFFSET == 0){
+            mOffsets.push_back(mBitCount);
+        }
+        int64_t difference = int64_t(genome.size()) - mSnapshot->get_sequence_length();
+        write_gamma((difference < 0 ? (uint64_t(-difference - 1) << 1) | 1 : uint64_t(difference) << 1) + 1);
+        write_bits(start, mVertexWidth);
+        write_gamma(choice_bits + 1);
+        for(auto const & choice : choices){
+            write_bits(choice.first, choice.second);
+        }
+        return mCount++;
+    }
+
+    /**
+     * @param index returned by add
+     * @return the genome
+     */
+    string decode(size_t index) const {
+        size_t position = record_offset(index);
+        size_t length, current;
+        read_header(position, length, current);
+        string genome = mSnapshot->get_kmer(current);
+        genome.reserve(length);
+        while(genome.size() < length){
+            size_t degree = 0;
+            mSnapshot->for_each_successor(current, [&degree] (size_t, size_t) { degree++; });
+            if(degree == 0){
+                throw std::runtime_error("PathArchive::decode: record does not match the snapshot");
+            }
+            size_t chosen = degree > 1 ? read_bits(position, width_for(degree)) : 0;
+            mSnapshot->for_each_successor(current, [&] (size_t target, size_t label) {
+                if(chosen-- == 0){
+                    genome += mSnapshot->symbol(label);
+                    current = target;
+                }
+            });
+        }
+        return genome;
+    }
+
+    /**
+     * Decode a bit genome ('0' / '1') straight into packed words; bit i is bit (i % 64) of word i / 64,
+     * the layout emp::BitVector and DeBruijnGraph::add_sequence(const uint64_t *, size_t) use
+     * @param index returned by add
+     * @return the genome's bits (genome_length(index) of them)
+     */
+    vector<uint64_t> decode_bits(size_t index) const {
+        string genome = decode(index);
+        vector<uint64_t> words((genome.size() + 63) / 64, 0);
+        for(size_t i = 0; i < genome.size(); ++i){
+            if(genome[i] == '1'){
+                words[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+        return words;
+    }
+
+    /**
+     * @param index returned by add
+     * @return length of the genome, without decoding it
+     */
+    size_t genome_length(size_t index) const {
+        size_t position = record_offset(index);
+        size_t length, start;
+        read_header(position, length, start);
+        return length;
+    }
+
+    /**
+     * @return number of archived genomes
+     */
+    size_t size() const { return mCount; }
+
+    /**
+     * @return the graph the genomes are paths of
+     */
+    const SuccinctDeBruijnGraph & snapshot() const { return *mSnapshot; }
+
+    /**
+     * @return bytes used by the records, not counting the snapshot
+     */
+    size_t size_in_bytes() const {
+        return sizeof(*this) + mWords.capacity() * sizeof(uint64_t) + mOffsets.capacity() * sizeof(size_t);
+    }
+
+    /**
+     * @return average bits per archived genome, not counting the snapshot
+     */
+    double bits_per_genome() const { return mCount == 0 ? 0 : double(mBitCount) / mCount; }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHARCHIVE_H
@@ -0,0 +1,49 @@
+/**
+ * @file PathStore.cpp
+ * @author Anna Catenacci
+ */
+
+#include "PathStore.hpp"
+#include <map>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("PathStore__store-release-compact", "[PathStore.hpp]")
+{
+    {
+        PathStore store;
+        SequenceHandle first = store.store("0110");
+        SequenceHandle second = store.store("111000");
+        CHECK(first != second);
+        CHECK(store.path(first) == "0110");
+        CHECK(store.path(second) == "111000");
+        CHECK(store.size() == 2);
+
+        store.release(first);
+        CHECK(!store.contains(first));
+        CHECK_THROWS_AS(store.path(first), std::out_of_range);
+        CHECK(store.store("1") == first);   // the freed slot is reused
+        CHECK(store.path(first) == "1");
+
+        // churn enough paths to trigger compaction, checking the survivors every time
+        std::map<uint32_t, std::string> live;
+        for(int i = 0; i < 5000; ++i){
+            std::string path(50 + i % 7, char('0' + i % 2));
+            path += std::to_string(i);
+            live[store.store(path).id] = path;
+            if(i % 3 != 0){
+                SequenceHandle gone{live.begin()->first};
+                store.release(gone);
+                live.erase(live.begin());
+            }
+        }
+        size_t live_symbols = 0;
+        for(auto const & entry : live){
+            CHECK(store.path(SequenceHandle{entry.first}) == entry.second);
+            live_symbols += entry.second.size();
+        }
+        CHECK(store.size() == live.size() + 2);
+        // removed paths take up at most as much room as live ones, and the buffer at most doubles on top of that
+        CHECK(store.memory_bytes() < 4 * live_symbols + 5000 * (sizeof(uint32_t) + 24));
+    }
+}
@@ -0,0 +1,164 @@
+/**
+ * @file PathStore.hpp
+ * @author Anna Catenacci
+ *
+ * Keeps the paths of the sequences registered with a DeBruijnGraph, so an organism can hold a 4-byte
+ * SequenceHandle instead of its genome string and the graph can still walk its path to remove it.
+ *
+ * A path is stored as the sequence's symbols (its first k-mer, then one symbol per edge), all of them packed
+ * one after another in a single buffer. Handles are slot numbers; the slots of removed paths are reused, and
+ * the buffer is compacted once more than half of it belongs to removed paths.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHSTORE_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHSTORE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * Names one registered sequence. Valid until the sequence is removed; after that its slot may be reused.
+ */
+struct SequenceHandle {
+    static constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+    uint32_t id = INVALID;
+
+    /**
+     * @return true if the handle was returned by a registration
+     */
+    bool valid() const { return id != INVALID; }
+
+    bool operator==(const SequenceHandle & other) const { return id == other.id; }
+    bool operator!=(const SequenceHandle & other) const { return id != other.id; }
+};
+
+class PathStore {
+private:
+    /// Where one path lies in mSymbols
+    struct Slot {
+        size_t offset = 0;
+        uint32_t length = 0;
+        bool live = false;
+    };
+
+    /// Symbols of every path, back to back
+    std::string mSymbols;
+
+    /// One slot per handle id
+    std::vector<Slot> mSlots;
+
+    /// Ids of slots whose paths were removed, to be reused
+    std::vector<uint32_t> mFreeSlots;
+
+    /// Number of live paths
+    size_t mLiveCount = 0;
+
+    /// Symbols in mSymbols that belong to removed paths
+    size_t mGarbage = 0;
+
+    /// Compaction is not worth it below this many symbols of garbage
+    static constexpr size_t MIN_COMPACT_SYMBOLS = 4096;
+
+    /**
+     * Move every live path to the front of the buffer, dropping the symbols of removed ones
+     */
+    void compact(){
+        std::string symbols;
+        symbols.reserve(mSymbols.size() - mGarbage);
+        for(auto & slot : mSlots){
+            if(slot.live){
+                size_t offset = symbols.size();
+                symbols.append(mSymbols, slot.offset, slot.length);
+                slot.offset = offset;
+            }
+        }
+        mSymbols.swap(symbols);
+        mGarbage = 0;
+    }
+
+public:
+    /**
+     * Store a path
+     * @param symbols the sequence
+     * @return handle of the stored path
+     */
+    SequenceHandle store(std::string_view symbols){
+        if(symbols.size() > std::numeric_limits<uint32_t>::max()){
+            throw std::invalid_argument("PathStore::store: sequence is too long to register");
+        }
+        SequenceHandle handle;
+        if(!mFreeSlots.empty()){
+            handle.id = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else {
+            if(mSlots.size() >= SequenceHandle::INVALID){
+                throw std::length_error("PathStore::store: every handle is in use");
+            }
+            handle.id = uint32_t(mSlots.size());
+            mSlots.emplace_back();
+        }
+        mSlots[handle.id] = Slot{mSymbols.size(), uint32_t(symbols.size()), true};
+        mSymbols.append(symbols);
+        mLiveCount++;
+        return handle;
+    }
+
+    /**
+     * @param handle handle to check
+     * @return true if the handle names a stored path
+     */
+    bool contains(SequenceHandle handle) const {
+        return handle.id < mSlots.size() && mSlots[handle.id].live;
+    }
+
+    /**
+     * @param handle handle of a stored path
+     * @return its symbols (only valid until the next store or release)
+     */
+    std::string_view path(SequenceHandle handle) const {
+        if(!contains(handle)){
+            throw std::out_of_range("PathStore::path: no sequence is registered under this handle");
+        }
+        const Slot & slot = mSlots[handle.id];
+        return std::string_view(mSymbols.data() + slot.offset, slot.length);
+    }
+
+    /**
+     * Forget a path, freeing its handle for reuse
+     * @param handle handle of a stored path
+     */
+    void release(SequenceHandle handle){
+        if(!contains(handle)){
+            return;
+        }
+        Slot & slot = mSlots[handle.id];
+        slot.live = false;
+        mGarbage += slot.length;
+        mFreeSlots.push_back(handle.id);
+        mLiveCount--;
+        if(mGarbage >= MIN_COMPACT_SYMBOLS && mGarbage * 2 > mSymbols.size()){
+            compact();
+        }
+    }
+
+    /**
+     * @return number of stored paths
+     */
+    size_t size() const { return mLiveCount; }
+
+    /**
+     * @return bytes held by the store
+     */
+    size_t memory_bytes() const {
+        return mSymbols.capacity() + mSlots.capacity() * sizeof(Slot) + mFreeSlots.capacity() * sizeof(uint32_t);
+    }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_PATHSTORE_H
@@ -0,0 +1,86 @@
+/**
+ * @file RandomPolicy.cpp
+ * @author Anna Catenacci
+ */
+
+#include "RandomPolicy.hpp"
+#include <random>
+#include <vector>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Bounded draws, doubles and coin flips from any generator with the GetUInt / P calls stay in range and look uniform
+    template <typename RandomT>
+    void check_calls(RandomT & random){
+        std::vector<int> counts(5, 0);
+        int heads = 0;
+        bool in_range = true;
+        for(int i = 0; i < 50000; ++i){
+            uint32_t value = random.GetUInt(5);
+            in_range = in_range && value < 5;
+            counts[value % 5]++;
+            uint32_t ranged = random.GetUInt(7, 9);
+            in_range = in_range && ranged >= 7 && ranged < 9;
+            double fraction = random.GetDouble();
+            in_range = in_range && fraction >= 0 && fraction < 1;
+            heads += random.P(0.1);
+        }
+        CHECK(in_range);
+        for(int count : counts){
+            CHECK((count > 9500 && count < 10500));
+        }
+        CHECK((heads > 4600 && heads < 5400));
+        CHECK(random.GetUInt(0) == 0);
+        CHECK(random.GetUInt(1) == 0);
+        CHECK(!random.P(0));
+        CHECK(random.P(1));
+    }
+}
+
+TEST_CASE("RandomPolicy__buffered-draws", "[RandomPolicy.hpp]")
+{
+    {
+        // a 64-bit engine's words come out in order, a 32-bit engine's are paired high then low
+        Xoshiro256 engine(3), copy(3);
+        BufferedRandom<Xoshiro256, 4> buffered(engine);
+        for(int i = 0; i < 10; ++i){
+            CHECK(buffered() == copy());
+        }
+        std::mt19937 small(5), small_copy(5);
+        BufferedRandom<std::mt19937> buffered_small(small);
+        uint64_t high = small_copy();
+        CHECK(buffered_small() == ((high << 32) | uint64_t(small_copy())));
+
+        Xoshiro256 a(9), b(9), c(10);
+        CHECK(a() == b());
+        CHECK(a() != c());
+
+        check_calls(buffered);
+        check_calls(buffered_small);
+        std::mt19937_64 wide(7);
+        BufferedRandom<std::mt19937_64> buffered_wide(wide);
+        check_calls(buffered_wide);
+        // works with the standard distributions too
+        std::uniform_int_distribution<int> die(1, 6);
+        int roll = die(buffered);
+        CHECK((roll >= 1 && roll <= 6));
+    }
+}
+
+TEST_CASE("RandomPolicy__call-detection", "[RandomPolicy.hpp]")
+{
+    {
+        CHECK(has_random_calls<BufferedRandom<Xoshiro256>>::value);
+        CHECK(!has_random_calls<Xoshiro256>::value);
+        CHECK(!has_random_calls<std::mt19937>::value);
+
+        // an engine is wrapped for the call, a generator with the calls is used as it is
+        Xoshiro256 engine(1), copy(1);
+        uint32_t wrapped = with_random_calls(engine, [] (auto & calls) { return calls.GetUInt(1000); });
+        BufferedRandom<Xoshiro256> buffered(copy);
+        CHECK(wrapped == buffered.GetUInt(1000));
+        uint32_t direct = with_random_calls(buffered, [&buffered] (auto & calls) { return &calls == &buffered ? 1u : 0u; });
+        CHECK(direct == 1);
+    }
+}
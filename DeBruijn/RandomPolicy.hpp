@@ -0,0 +1,224 @@
+/**
+ * @file RandomPolicy.hpp
+ * @author Anna Catenacci
+ *
+ * Random number generators the graphs can sample with, without depending on any particular library.
+ *
+ * The graphs' sampling calls take any generator that either
+ *  - has GetUInt(n) and P(p) calls, like emp::Random, CounterRandom or BufferedRandom, which are used as they are, or
+ *  - is a standard uniform random bit generator (std::mt19937_64, Xoshiro256 below, ...), which is wrapped in a
+ *    BufferedRandom for the length of the call.
+ *
+ * BufferedRandom draws its engine's output in blocks and turns it into bounded integers with Lemire's
+ * multiply-shift, so choosing a branch needs no division except in the rare rejection case, and P(p) is one
+ * integer comparison. Wrapping happens per call, so the unused end of the buffer is thrown away each time;
+ * to avoid that when sampling many genomes, keep one BufferedRandom and pass it instead of the engine.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_RANDOMPOLICY_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_RANDOMPOLICY_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+/**
+ * xoshiro256** (Blackman and Vigna), a small, fast 64-bit generator for runs that do not need emp::Random's stream
+ */
+class Xoshiro256 {
+public:
+    using result_type = uint64_t;
+
+private:
+    /// Generator state (never all zero)
+    std::array<uint64_t, 4> mState;
+
+    static uint64_t rotate_left(uint64_t x, int k){ return (x << k) | (x >> (64 - k)); }
+
+public:
+    /**
+     * @param seed any value; the state is filled from it with splitmix64
+     */
+    explicit Xoshiro256(uint64_t seed = 0){
+        for(auto & word : mState){
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * @return next 64 random bits
+     */
+    result_type operator()(){
+        uint64_t result = rotate_left(mState[1] * 5, 7) * 9;
+        uint64_t shifted = mState[1] << 17;
+        mState[2] ^= mState[0];
+        mState[3] ^= mState[1];
+        mState[1] ^= mState[2];
+        mState[0] ^= mState[3];
+        mState[2] ^= shifted;
+        mState[3] = rotate_left(mState[3], 45);
+        return result;
+    }
+};
+
+/**
+ * The GetUInt / GetDouble / P calls on top of any standard uniform random bit generator whose outputs are full
+ * 32-bit or 64-bit words
+ * @tparam EngineT generator type; the BufferedRandom keeps a reference to it
+ * @tparam BUFFER_WORDS number of 64-bit words drawn from the engine at a time
+ */
+template <typename EngineT, size_t BUFFER_WORDS = 32>
+class BufferedRandom {
+    using engine_result = typename EngineT::result_type;
+    static_assert(EngineT::min() == 0 && (uint64_t(EngineT::max()) == 0xFFFFFFFFULL
+                                         || uint64_t(EngineT::max()) == ~uint64_t(0)),
+                  "BufferedRandom needs an engine that produces full 32-bit or 64-bit words");
+    static constexpr bool WIDE_ENGINE = uint64_t(EngineT::max()) == ~uint64_t(0);
+
+    /// Engine the words come from
+    EngineT & mEngine;
+
+    /// Words drawn ahead of use
+    std::array<uint64_t, BUFFER_WORDS> mBuffer;
+
+    /// Next unused word of mBuffer
+    size_t mNext = BUFFER_WORDS;
+
+    /// Second half of a word split by next32, if there is one
+    uint32_t mSpare = 0;
+    bool mHasSpare = false;
+
+    /**
+     * Draw a whole buffer of words from the engine
+     */
+    void fill(){
+        for(auto & word : mBuffer){
+            if(WIDE_ENGINE){
+                word = uint64_t(mEngine());
+            }
+            else {
+                uint64_t high = uint64_t(mEngine());
+                word = (high << 32) | uint64_t(mEngine());
+            }
+        }
+        mNext = 0;
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit BufferedRandom(EngineT & engine) : mEngine(engine), mBuffer{} { }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * @return next 64 random bits
+     */
+    result_type operator()(){
+        if(mNext == BUFFER_WORDS){
+            fill();
+        }
+        return mBuffer[mNext++];
+    }
+
+    /**
+     * @return next 32 random bits (half of a buffered word; the other half is kept for the next call)
+     */
+    uint32_t next32(){
+        if(mHasSpare){
+            mHasSpare = false;
+            return mSpare;
+        }
+        uint64_t word = (*this)();
+        mSpare = uint32_t(word >> 32);
+        mHasSpare = true;
+        return uint32_t(word);
+    }
+
+    /**
+     * Uniform integer below a bound, without modulo bias (Lemire's multiply-shift; divides only when it might reject)
+     * @param max one past the largest value
+     * @return value in [0, max), or 0 if max is 0
+     */
+    uint32_t GetUInt(uint32_t max){
+        uint64_t product = uint64_t(next32()) * max;
+        uint32_t low = uint32_t(product);
+        if(low < max){
+            uint32_t threshold = uint32_t(-max) % max;
+            while(low < threshold){
+                product = uint64_t(next32()) * max;
+                low = uint32_t(product);
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+    /**
+     * @param min smallest value
+     * @param max one past the largest value
+     * @return value in [min, max)
+     */
+    uint32_t GetUInt(uint32_t min, uint32_t max){ return min + GetUInt(max - min); }
+
+    /**
+     * @return value in [0, 1) with 53 random bits
+     */
+    double GetDouble(){ return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+    /**
+     * One draw compared against the probability scaled to 53 bits, so no floating-point work per call
+     * @param probability chance of returning true
+     * @return true with the given probability
+     */
+    bool P(double probability){
+        uint64_t bits = (*this)() >> 11;
+        if(probability <= 0){
+            return false;
+        }
+        if(probability >= 1){
+            return true;
+        }
+        return bits < uint64_t(probability * 9007199254740992.0);
+    }
+};
+
+/**
+ * True for generators with the GetUInt / P calls (emp::Random, CounterRandom, BufferedRandom)
+ */
+template <typename RandomT, typename = void>
+struct has_random_calls : std::false_type { };
+
+template <typename RandomT>
+struct has_random_calls<RandomT, std::void_t<decltype(std::declval<RandomT &>().GetUInt(1u)),
+                                             decltype(std::declval<RandomT &>().P(0.5))>> : std::true_type { };
+
+/**
+ * Run body with a generator that has the GetUInt / P calls: the given one if it has them, otherwise a
+ * BufferedRandom over it
+ * @param random generator
+ * @param body lambda taking the generator to use
+ * @return whatever body returns
+ */
+template <typename RandomT, typename BodyT>
+decltype(auto) with_random_calls(RandomT & random, BodyT body){
+    if constexpr (has_random_calls<RandomT>::value){
+        return body(random);
+    }
+    else {
+        BufferedRandom<RandomT> buffered(random);
+        return body(buffered);
+    }
+}
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_RANDOMPOLICY_H
@@ -0,0 +1,174 @@
+/**
+ * @file SuccinctDeBruijnGraph.cpp
+ * @author Anna Catenacci
+ */
+
+#include "SuccinctDeBruijnGraph.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Check that every read query of the succinct graph agrees with the graph it was built from
+    void check_matches(const DeBruijnGraph & graph, const SuccinctDeBruijnGraph & succinct){
+        CHECK(succinct.get_size() == graph.get_size());
+        CHECK(succinct.edge_count() == graph.edge_count());
+        for(auto const & vertex : graph.get_all_vertices()){
+            DBGraphValue value = graph.get_value(vertex);
+            CHECK(succinct.contains(vertex));
+            CHECK(succinct.get_kmer(succinct.find_vertex(vertex)) == vertex);
+            CHECK(succinct.get_adj_list(vertex) == value.get_adj_list());
+            CHECK(succinct.get_kmer_occurrences(vertex) == value.get_kmer_occurrences());
+            CHECK(succinct.get_endpoint(vertex) == value.get_endpoint());
+        }
+        vector<string> branches = graph.get_branch_vertices();
+        vector<string> succinct_branches = succinct.get_branch_vertices();
+        // the graph's branch list can hold a vertex twice when other branches were added in between
+        std::sort(branches.begin(), branches.end());
+        branches.erase(std::unique(branches.begin(), branches.end()), branches.end());
+        std::sort(succinct_branches.begin(), succinct_branches.end());
+        CHECK(succinct_branches == branches);
+        CHECK(succinct.get_start_vertices() == graph.get_start_vertices());
+
+        vector<string> order, succinct_order;
+        graph.depth_first_traversal([&order] (string vertex) { order.push_back(vertex); });
+        succinct.depth_first_traversal([&succinct_order] (string vertex) { succinct_order.push_back(vertex); });
+        CHECK(succinct_order == order);
+    }
+}
+
+TEST_CASE("SuccinctDeBruijnGraph__bit-vectors", "[SuccinctDeBruijnGraph.hpp]")
+{
+    {
+        RankSelectBitVector bits;
+        vector<size_t> ones, zeros;
+        for(size_t i = 0; i < 3000; ++i){
+            bool bit = (i * 7) % 5 == 0 || i % 97 == 0;
+            bits.push_back(bit);
+            (bit ? ones : zeros).push_back(i);
+        }
+        bits.build();
+        CHECK(bits.size() == 3000);
+        CHECK(bits.ones() == ones.size());
+        size_t rank = 0;
+        for(size_t i = 0; i <= 3000; ++i){
+            CHECK(bits.rank1(i) == rank);
+            if(i < 3000 && bits[i]){ rank++; }
+        }
+        for(size_t j = 0; j < ones.size(); ++j){
+            CHECK(bits.select1(j) == ones[j]);
+        }
+        for(size_t j = 0; j < zeros.size(); ++j){
+            CHECK(bits.select0(j) == zeros[j]);
+        }
+
+        // symbol counts that are and are not powers of two, including a single symbol
+        for(uint32_t symbols : {1u, 5u, 8u, 19u}){
+            vector<uint32_t> sequence;
+            for(size_t i = 0; i < 2000; ++i){
+                sequence.push_back((i * i + 3 * i) % 23 % symbols);
+            }
+            WaveletMatrix wavelet(sequence, symbols);
+            vector<size_t> seen(symbols, 0);
+            bool matches = true;
+            for(size_t i = 0; i < sequence.size(); ++i){
+                uint32_t s = sequence[i];
+                matches = matches && wavelet[i] == s && wavelet.rank(s, i) == seen[s] && wavelet.select(s, seen[s]) == i;
+                seen[s]++;
+            }
+            CHECK(matches);
+            for(uint32_t s = 0; s < symbols; ++s){
+                CHECK(wavelet.rank(s, sequence.size()) == seen[s]);
+            }
+        }
+
+        vector<uint32_t> values = {0, 5, 17, 3, 1000, 2, 0, 999};
+        PackedIntVector packed(values);
+        for(size_t i = 0; i < values.size(); ++i){
+            CHECK(packed[i] == values[i]);
+        }
+    }
+}
+
+TEST_CASE("SuccinctDeBruijnGraph__matches-source-graph", "[SuccinctDeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph digits;
+        digits.add_sequence("12345678");
+        digits.add_sequence("12345000");
+        digits.add_sequence("99945000");
+        SuccinctDeBruijnGraph frozen_digits(digits);
+        check_matches(digits, frozen_digits);
+        CHECK(frozen_digits.is_valid("12345678"));
+        CHECK(frozen_digits.is_valid("99945000"));
+        CHECK(!frozen_digits.is_valid("12399999"));
+        CHECK(!frozen_digits.contains("111"));
+        CHECK(!frozen_digits.contains("12"));
+        CHECK(frozen_digits.get_adj_list("777").empty());
+        CHECK(frozen_digits.vertex_branch_check("345"));
+
+        DeBruijnGraph bits;
+        bits.add_sequence("0000110110");
+        bits.add_sequence("0001110100");
+        bits.add_sequence("1111000010");
+        bits.add_sequence("0000110111");
+        SuccinctDeBruijnGraph frozen_bits(bits);
+        check_matches(bits, frozen_bits);
+        CHECK(frozen_bits.is_valid("0000110110"));
+        CHECK(frozen_bits.is_valid("1111000010"));
+        // a few bits per edge plus fixed overhead, well under the map-of-strings graph
+        CHECK(frozen_bits.size_in_bytes() < bits.memory_usage().total());
+
+        // a larger graph, so the bitvectors span several rank blocks
+        DeBruijnGraph wide(6);
+        emp::Random random(5);
+        for(int i = 0; i < 200; ++i){
+            string genome;
+            for(int j = 0; j < 30; ++j){
+                genome += char('a' + random.GetUInt(4));
+            }
+            wide.add_sequence(genome);
+        }
+        SuccinctDeBruijnGraph frozen_wide(wide);
+        check_matches(wide, frozen_wide);
+        CHECK(frozen_wide.bits_per_edge() > 0);
+
+        // edge labels cost about log2(2σ) bits each, not a bitvector per character
+        DeBruijnGraph decimal(8);
+        for(int i = 0; i < 300; ++i){
+            string genome;
+            for(int j = 0; j < 60; ++j){
+                genome += char('0' + random.GetUInt(10));
+            }
+            decimal.add_sequence(genome);
+        }
+        SuccinctDeBruijnGraph frozen_decimal(decimal);
+        check_matches(decimal, frozen_decimal);
+        CHECK(frozen_decimal.bits_per_edge() < 14);
+
+        CHECK_THROWS_AS(frozen_digits.random_walk(random, "1", 1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("SuccinctDeBruijnGraph__random-walk", "[SuccinctDeBruijnGraph.hpp]")
+{
+    {
+        DeBruijnGraph bits;
+        bits.add_sequence("0000110110");
+        bits.add_sequence("0001110100");
+        bits.add_sequence("0000111000");
+        const SuccinctDeBruijnGraph frozen(bits);
+
+        emp::Random random(3);
+        for(int i = 0; i < 50; ++i){
+            string child = frozen.random_walk(random, "0000110110", 1, false);
+            CHECK(child.substr(0, 3) == "000");
+            CHECK(int(child.size()) <= frozen.get_sequence_length());
+            CHECK(frozen.is_valid(child));
+            CHECK(bits.is_valid(child));
+        }
+        // the frozen graph is never changed by walking it
+        check_matches(bits, frozen);
+        CHECK(frozen.random_walk(random, "0000110110", 0) == "0000110110");
+    }
+}
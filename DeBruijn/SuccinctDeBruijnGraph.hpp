@@ -0,0 +1,912 @@
+/**
+ * @file SuccinctDeBruijnGraph.hpp
+ * @author Anna Catenacci
+ *
+ * A frozen, succinct (BOSS-style) representation of a DeBruijnGraph, for keeping many archived
+ * generations resident in memory at a few bits per edge.
+ *
+ * Layout (Bowe, Onodera, Sadakane and Shibuya's representation, adapted to our k-mer vertices):
+ * - Vertices are sorted in colexicographic order (compared from their last character backwards).
+ *   Vertices with no incoming edge get a chain of '$'-padded dummy predecessors so every vertex
+ *   except the all-'$' root has exactly one incoming edge that is "counted".
+ * - Every vertex lists its outgoing edges by label (the last character of the successor), in order;
+ *   a vertex with no successors gets a single '$' edge. The `last` bitvector marks each vertex's final edge.
+ * - Vertices that share their last k-1 characters all point to the same successor for a label, so only
+ *   the first of them has that edge "unflagged"; the others carry the label flagged. Edge labels, flagged
+ *   or not, are kept as one sequence of 2σ-1 symbols in a wavelet matrix, about log2(2σ) bits per edge.
+ * - mFirst[c] is the rank of the first vertex whose last character is c.
+ * The target of an edge labeled c is then mFirst[c] + (number of unflagged c edges up to it) - 1, and every
+ * query (successors, k-mer lookup, spelling a vertex back out) is answered with rank/select.
+ *
+ * Only the read side of DeBruijnGraph is supported: successor enumeration, is_valid, branch vertices,
+ * traversal, per-k-mer counts and modify_org-style random walks.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_SUCCINCTDEBRUIJNGRAPH_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_SUCCINCTDEBRUIJNGRAPH_H
+
+#include "DeBruijnGraph.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+using std::string; using std::vector; using std::map;
+
+/**
+ * Plain bitvector with constant-time rank and logarithmic select.
+ * Cumulative counts are sampled every 512 bits (about 6% overhead).
+ */
+class RankSelectBitVector {
+private:
+    static constexpr size_t WORDS_PER_BLOCK = 8;
+
+    /// The bits, 64 to a word
+    vector<uint64_t> mWords;
+
+    /// Number of ones before each 512-bit block (one extra entry at the end)
+    vector<uint32_t> mBlockRanks;
+
+    /// Number of bits
+    size_t mSize = 0;
+
+    static size_t popcount(uint64_t word) { return __builtin_popcountll(word); }
+
+public:
+    /**
+     * Append a bit. Call build() after the last one.
+     * @param bit value to append
+     */
+    void push_back(bool bit){
+        if(mSize % 64 == 0){
+            mWords.push_back(0);
+        }
+        if(bit){
+            mWords.back() |= uint64_t(1) << (mSize % 64);
+        }
+        mSize++;
+    }
+
+    /**
+     * Build the rank samples; must be called before rank1 or select1
+     */
+    void build(){
+        mWords.shrink_to_fit();
+        mBlockRanks.assign(mWords.size() / WORDS_PER_BLOCK + 2, 0);
+        uint32_t ones = 0;
+        for(size_t i = 0; i < mWords.size(); ++i){
+            if(i % WORDS_PER_BLOCK == 0){
+                mBlockRanks[i / WORDS_PER_BLOCK] = ones;
+            }
+            ones += popcount(mWords[i]);
+        }
+        for(size_t b = (mWords.size() + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK; b < mBlockRanks.size(); ++b){
+            mBlockRanks[b] = ones;
+        }
+    }
+
+    /**
+     * @param i bit position
+     * @return the bit
+     */
+    bool operator[](size_t i) const { return (mWords[i / 64] >> (i % 64)) & 1; }
+
+    /**
+     * @return number of bits
+     */
+    size_t size() const { return mSize; }
+
+    /**
+     * @return number of set bits
+     */
+    size_t ones() const { return mBlockRanks.empty() ? 0 : mBlockRanks.back(); }
+
+    /**
+     * Count the set bits before a position
+     * @param i position (may equal size())
+     * @return number of ones in [0, i)
+     */
+    size_t rank1(size_t i) const {
+        size_t word = i / 64;
+        size_t rank = mBlockRanks[word / WORDS_PER_BLOCK];
+        for(size_t w = word - word % WORDS_PER_BLOCK; w < word; ++w){
+            rank += popcount(mWords[w]);
+        }
+        if(i % 64){
+            rank += popcount(mWords[word] & ((uint64_t(1) << (i % 64)) - 1));
+        }
+        return rank;
+    }
+
+    /**
+     * Find an unset bit by rank
+     * @param j which one to find, counting from 0 (must be less than size() - ones())
+     * @return position of the j-th unset bit
+     */
+    size_t select0(size_t j) const {
+        // last block with at most j zeros before it
+        size_t low = 0, high = mBlockRanks.size() - 1;
+        while(low < high){
+            size_t mid = (low + high + 1) / 2;
+            if(mid * WORDS_PER_BLOCK * 64 - mBlockRanks[mid] <= j){
+                low = mid;
+            }
+            else {
+                high = mid - 1;
+            }
+        }
+        size_t remaining = j - (low * WORDS_PER_BLOCK * 64 - mBlockRanks[low]);
+        for(size_t w = low * WORDS_PER_BLOCK; w < mWords.size(); ++w){
+            uint64_t word = ~mWords[w];
+            size_t count = popcount(word);
+            if(remaining < count){
+                for(size_t r = 0; r < remaining; ++r){
+                    word &= word - 1; // clear lowest set bit
+                }
+                return w * 64 + __builtin_ctzll(word);
+            }
+            remaining -= count;
+        }
+        return mSize;
+    }
+
+    /**
+     * Find a set bit by rank
+     * @param j which one to find, counting from 0 (must be less than ones())
+     * @return position of the j-th set bit
+     */
+    size_t select1(size_t j) const {
+        size_t block = std::upper_bound(mBlockRanks.begin(), mBlockRanks.end(), j) - mBlockRanks.begin() - 1;
+        size_t remaining = j - mBlockRanks[block];
+        for(size_t w = block * WORDS_PER_BLOCK; w < mWords.size(); ++w){
+            size_t count = popcount(mWords[w]);
+            if(remaining < count){
+                uint64_t word = mWords[w];
+                for(size_t r = 0; r < remaining; ++r){
+                    word &= word - 1; // clear lowest set bit
+                }
+                return w * 64 + __builtin_ctzll(word);
+            }
+            remaining -= count;
+        }
+        return mSize;
+    }
+
+    /**
+     * @return bytes used by the bits and the rank samples
+     */
+    size_t size_in_bytes() const { return mWords.size() * sizeof(uint64_t) + mBlockRanks.size() * sizeof(uint32_t); }
+};
+
+/**
+ * Fixed-width packed array of unsigned integers, as narrow as the largest value needs
+ */
+class PackedIntVector {
+private:
+    vector<uint64_t> mWords;
+    size_t mSize = 0;
+    int mWidth = 0;
+
+public:
+    PackedIntVector()=default;
+
+    /**
+     * Pack a list of values
+     * @param values to store
+     */
+    PackedIntVector(const vector<uint32_t> & values) : mSize(values.size()) {
+        uint32_t largest = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+        while(mWidth < 32 && (uint64_t(1) << mWidth) <= largest){
+            mWidth++;
+        }
+        mWords.assign((mSize * mWidth + 63) / 64 + 1, 0);
+        for(size_t i = 0; i < mSize; ++i){
+            size_t bit = i * mWidth;
+            mWords[bit / 64] |= uint64_t(values[i]) << (bit % 64);
+            if(bit % 64 + mWidth > 64){
+                mWords[bit / 64 + 1] |= uint64_t(values[i]) >> (64 - bit % 64);
+            }
+        }
+    }
+
+    /**
+     * @param i index
+     * @return the value at i
+     */
+    uint32_t operator[](size_t i) const {
+        if(mWidth == 0){
+            return 0;
+        }
+        size_t bit = i * mWidth;
+        uint64_t value = mWords[bit / 64] >> (bit % 64);
+        if(bit % 64 + mWidth > 64){
+            value |= mWords[bit / 64 + 1] << (64 - bit % 64);
+        }
+        return value & ((uint64_t(1) << mWidth) - 1);
+    }
+
+    /**
+     * @return bytes used
+     */
+    size_t size_in_bytes() const { return mWords.size() * sizeof(uint64_t); }
+};
+
+/**
+ * Sequence of small integer symbols with access, rank and select in one bitvector step per bit of the
+ * symbols (a wavelet matrix: each level holds one bit of every symbol, with the symbols stably sorted by
+ * their higher bits).
+ */
+class WaveletMatrix {
+private:
+    /// One bitvector per bit of the symbols, most significant first
+    vector<RankSelectBitVector> mLevels;
+
+    /// Number of zeros in each level
+    vector<size_t> mZeros;
+
+    /**
+     * @param s symbol
+     * @param level level index
+     * @return the bit of s that level holds
+     */
+    bool bit(size_t s, size_t level) const { return (s >> (mLevels.size() - 1 - level)) & 1; }
+
+    /**
+     * Follow a position down one level
+     */
+    size_t down(size_t level, size_t i, bool one) const {
+        size_t ones = mLevels[level].rank1(i);
+        return one ? mZeros[level] + ones : i - ones;
+    }
+
+public:
+    WaveletMatrix()=default;
+
+    /**
+     * Store a sequence of symbols
+     * @param values symbols, each less than symbols
+     * @param symbols number of distinct symbols the sequence may hold
+     */
+    WaveletMatrix(vector<uint32_t> values, uint32_t symbols){
+        size_t width = 0;
+        while((uint64_t(1) << width) < symbols){
+            width++;
+        }
+        mLevels.resize(width);
+        mZeros.resize(width);
+        vector<uint32_t> ones;
+        for(size_t level = 0; level < width; ++level){
+            ones.clear();
+            size_t zeros = 0;
+            for(uint32_t value : values){
+                bool one = bit(value, level);
+                mLevels[level].push_back(one);
+                if(one){
+                    ones.push_back(value);
+                }
+                else {
+                    values[zeros++] = value;
+                }
+            }
+            mLevels[level].build();
+            mZeros[level] = zeros;
+            std::copy(ones.begin(), ones.end(), values.begin() + zeros);
+        }
+    }
+
+    /**
+     * @param i position
+     * @return the symbol there
+     */
+    size_t operator[](size_t i) const {
+        size_t value = 0;
+        for(size_t level = 0; level < mLevels.size(); ++level){
+            bool one = mLevels[level][i];
+            value = value << 1 | one;
+            i = down(level, i, one);
+        }
+        return value;
+    }
+
+    /**
+     * Count a symbol before a position
+     * @param s symbol
+     * @param i position (may equal the length)
+     * @return number of times s occurs in [0, i)
+     */
+    size_t rank(size_t s, size_t i) const {
+        size_t begin = 0;
+        for(size_t level = 0; level < mLevels.size(); ++level){
+            bool one = bit(s, level);
+            begin = down(level, begin, one);
+            i = down(level, i, one);
+        }
+        return i - begin;
+    }
+
+    /**
+     * Find an occurrence of a symbol by rank
+     * @param s symbol
+     * @param j which occurrence to find, counting from 0 (must be less than rank(s, length))
+     * @return its position
+     */
+    size_t select(size_t s, size_t j) const {
+        size_t position = 0;
+        for(size_t level = 0; level < mLevels.size(); ++level){
+            position = down(level, position, bit(s, level));
+        }
+        position += j;
+        for(size_t level = mLevels.size(); level-- > 0;){
+            position = bit(s, level) ? mLevels[level].select1(position - mZeros[level]) : mLevels[level].select0(position);
+        }
+        return position;
+    }
+
+    /**
+     * @return bytes used by the levels
+     */
+    size_t size_in_bytes() const {
+        size_t bytes = mZeros.size() * sizeof(size_t);
+        for(auto const & level : mLevels){
+            bytes += level.size_in_bytes();
+        }
+        return bytes;
+    }
+};
+
+class SuccinctDeBruijnGraph {
+public:
+    /// Returned by find_vertex when a k-mer is not in the graph
+    static constexpr size_t NOT_FOUND = size_t(-1);
+
+private:
+
+    /// Length of the k-mer IDs
+    int mKmerLength = 3;
+
+    /// Length of the genomes the random walks build
+    int mSequenceLength = 0;
+
+    /// Characters used by the genomes, in sorted order; label c stands for mAlphabet[c-1] and label 0 for '$'
+    string mAlphabet;
+
+    /// Label of each character (0 for characters not in the alphabet)
+    uint8_t mLabelOf[256] = {};
+
+    /// Number of vertices, dummies included
+    size_t mVertexCount = 0;
+
+    /// Number of real vertices and real edges
+    size_t mRealVertices = 0;
+    size_t mRealEdges = 0;
+
+    /// Marks the last outgoing edge of each vertex
+    RankSelectBitVector mLast;
+
+    /// Label of every edge: 0 for '$', c for an unflagged edge labeled c, c + mAlphabet.size() for a flagged one
+    WaveletMatrix mLabels;
+
+    /// mFirst[c] = rank of the first vertex whose last character has label c
+    vector<size_t> mFirst;
+
+    /// Marks which vertices are real (not '$' padding)
+    RankSelectBitVector mReal;
+
+    /// Per-vertex occurrence and endpoint counts, indexed by rank among real vertices
+    PackedIntVector mOccurrences;
+    PackedIntVector mEndpoints;
+
+    /// Start vertices, in the order the source graph listed them
+    vector<size_t> mStarts;
+
+    /**
+     * @param v vertex rank
+     * @return position of its first outgoing edge
+     */
+    size_t first_edge(size_t v) const { return v == 0 ? 0 : mLast.select1(v - 1) + 1; }
+
+    /**
+     * @param v vertex rank
+     * @return position of its last outgoing edge
+     */
+    size_t last_edge(size_t v) const { return mLast.select1(v); }
+
+    /**
+     * @param e edge position
+     * @return the edge's label (0 for '$')
+     */
+    size_t label(size_t e) const {
+        size_t s = mLabels[e];
+        return s > mAlphabet.size() ? s - mAlphabet.size() : s;
+    }
+
+    /**
+     * @param c label (not '$')
+     * @param flagged whether to count flagged or unflagged edges
+     * @param e edge position (may equal the number of edges)
+     * @return number of edges before e carrying c with that flag
+     */
+    size_t label_rank(size_t c, bool flagged, size_t e) const { return mLabels.rank(flagged ? c + mAlphabet.size() : c, e); }
+
+    /**
+     * @param c label (not '$')
+     * @param flagged whether to look among flagged or unflagged edges
+     * @param j which one to find, counting from 0
+     * @return position of the j-th edge carrying c with that flag
+     */
+    size_t label_select(size_t c, bool flagged, size_t j) const { return mLabels.select(flagged ? c + mAlphabet.size() : c, j); }
+
+    /**
+     * Follow an edge
+     * @param e edge position (label must not be '$')
+     * @param c its label
+     * @return rank of the vertex it points to
+     */
+    size_t target(size_t e, size_t c) const { return mFirst[c] + label_rank(c, false, e + 1) - 1; }
+
+    /**
+     * @param v vertex rank
+     * @return label of the vertex's last character
+     */
+    size_t last_label(size_t v) const {
+        return std::upper_bound(mFirst.begin(), mFirst.end() - 1, v) - mFirst.begin() - 1;
+    }
+
+    /**
+     * @param v vertex rank (must be real)
+     * @return its rank among real vertices, for the packed counts
+     */
+    size_t real_rank(size_t v) const { return mReal.rank1(v); }
+
+    /**
+     * Colexicographic order on label strings
+     */
+    static bool colex_less(const string & a, const string & b){
+        return std::lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend());
+    }
+
+public:
+    SuccinctDeBruijnGraph()=default;
+    ~SuccinctDeBruijnGraph()=default;
+
+    /**
+     * Freeze a graph into succinct form
+     * @param graph source graph; it is only read
+     */
+    explicit SuccinctDeBruijnGraph(const DeBruijnGraph & graph)
+        : mKmerLength(graph.get_kmer_len()), mSequenceLength(graph.get_sequence_length()) {
+        // collect the alphabet and every vertex that is named anywhere (dangling adjacencies included)
+        std::set<char> characters;
+        map<string, DBGraphValue> values;
+        std::set<string> has_predecessor;
+        graph.for_each_vertex([&values, &has_predecessor] (const string & vertex, const DBGraphValue & value) {
+            for(auto const & adj : value.adjacencies()){
+                has_predecessor.insert(adj);
+            }
+            values.emplace(vertex, value);
+        });
+        for(auto const & adj : has_predecessor){
+            values[adj];
+        }
+        for(auto const & element : values){
+            if(int(element.first.size()) != mKmerLength){
+                throw std::invalid_argument("SuccinctDeBruijnGraph: every vertex must be a k-mer of length k");
+            }
+            characters.insert(element.first.begin(), element.first.end());
+        }
+        mAlphabet = string(characters.begin(), characters.end());
+        if(mAlphabet.size() > 255){
+            throw std::invalid_argument("SuccinctDeBruijnGraph: alphabet too large");
+        }
+        for(size_t c = 0; c < mAlphabet.size(); ++c){
+            mLabelOf[uint8_t(mAlphabet[c])] = c + 1;
+        }
+        size_t sigma = mAlphabet.size() + 1;
+
+        // vertices as label strings, with their outgoing labels; dummies are added for every source
+        map<string, std::set<uint8_t>> out_labels;
+        map<string, const DBGraphValue *> real;
+        for(auto const & element : values){
+            string labels = encode(element.first);
+            std::set<uint8_t> & out = out_labels[labels];
+            for(auto const & adj : element.second.adjacencies()){
+                out.insert(mLabelOf[uint8_t(adj.back())]);
+            }
+            real[labels] = &element.second;
+            if(!has_predecessor.count(element.first)){
+                for(int i = 0; i < mKmerLength; ++i){
+                    out_labels[string(mKmerLength - i, '\0') + labels.substr(0, i)].insert(labels[i]);
+                }
+            }
+        }
+        if(out_labels.empty()){
+            out_labels[string(mKmerLength, '\0')];
+        }
+
+        vector<string> order;
+        for(auto const & element : out_labels){
+            order.push_back(element.first);
+        }
+        std::sort(order.begin(), order.end(), colex_less);
+        mVertexCount = order.size();
+
+        // lay out the edges
+        mFirst.assign(sigma + 1, 0);
+        vector<uint32_t> edge_labels, occurrences, endpoints;
+        string group = "";
+        vector<bool> seen(sigma, false);
+        for(size_t v = 0; v < order.size(); ++v){
+            const string & labels = order[v];
+            mFirst[uint8_t(labels.back()) + 1]++;
+            if(v == 0 || labels.compare(1, string::npos, group) != 0){
+                group = labels.substr(1);
+                seen.assign(sigma, false);
+            }
+            auto found = real.find(labels);
+            bool is_real = found != real.end();
+            mReal.push_back(is_real);
+            if(is_real){
+                mRealVertices++;
+                occurrences.push_back(std::max(0, found->second->get_kmer_occurrences()));
+                endpoints.push_back(std::max(0, found->second->get_endpoint()));
+            }
+
+            const std::set<uint8_t> & out = out_labels[labels];
+            vector<uint8_t> edges(out.begin(), out.end());
+            if(edges.empty()){
+                edges.push_back(0);
+            }
+            for(size_t i = 0; i < edges.size(); ++i){
+                uint8_t c = edges[i];
+                bool flagged = c != 0 && seen[c];
+                if(c != 0){
+                    seen[c] = true;
+                    mRealEdges += is_real;
+                }
+                edge_labels.push_back(flagged ? c + mAlphabet.size() : c);
+                mLast.push_back(i + 1 == edges.size());
+            }
+        }
+        for(size_t c = 1; c <= sigma; ++c){
+            mFirst[c] += mFirst[c-1];
+        }
+        mLast.build();
+        mReal.build();
+        mLabels = WaveletMatrix(std::move(edge_labels), 2 * sigma - 1);
+        mOccurrences = PackedIntVector(occurrences);
+        mEndpoints = PackedIntVector(endpoints);
+
+        for(auto const & start : graph.start_vertices()){
+            size_t v = find_vertex(start);
+            if(v != NOT_FOUND){
+                mStarts.push_back(v);
+            }
+        }
+    }
+
+    /**
+     * Translate a k-mer into label string form ('\0' stands for '$')
+     * @param kmer characters
+     * @return labels
+     */
+    string encode(const string & kmer) const {
+        string labels(kmer.size(), '\0');
+        for(size_t i = 0; i < kmer.size(); ++i){
+            labels[i] = mLabelOf[uint8_t(kmer[i])];
+        }
+        return labels;
+    }
+
+///@remark LOOKUP /////////////////////////////////////////////////////////////
+
+    /**
+     * Find a k-mer by backward search (k rounds of rank/select)
+     * @param kmer to look for
+     * @return vertex rank, or NOT_FOUND
+     */
+    size_t find_vertex(const string & kmer) const {
+        if(int(kmer.size()) != mKmerLength || mVertexCount == 0){
+            return NOT_FOUND;
+        }
+        size_t low = 0, high = mVertexCount - 1;
+        for(char ch : kmer){
+            size_t c = mLabelOf[uint8_t(ch)];
+            if(c == 0){
+                return NOT_FOUND;
+            }
+            size_t begin = first_edge(low), end = last_edge(high) + 1;
+            size_t unflagged_before = label_rank(c, false, begin);
+            size_t unflagged_through = label_rank(c, false, end);
+            size_t flagged_before = label_rank(c, true, begin);
+            bool any_unflagged = unflagged_through > unflagged_before;
+            bool any_flagged = label_rank(c, true, end) > flagged_before;
+            if(!any_unflagged && !any_flagged){
+                return NOT_FOUND;
+            }
+            // a flagged first edge shares its target with the last unflagged edge before the range
+            size_t first_unflagged = any_unflagged ? label_select(c, false, unflagged_before) : end;
+            size_t first_flagged = any_flagged ? label_select(c, true, flagged_before) : end;
+            low = mFirst[c] + unflagged_before - (first_flagged < first_unflagged ? 1 : 0);
+            high = mFirst[c] + unflagged_through - 1;
+        }
+        return mReal[low] ? low : NOT_FOUND;
+    }
+
+    /**
+     * Spell a vertex back out by walking k predecessor links
+     * @param v vertex rank
+     * @return its k-mer ('$' for padding)
+     */
+    string get_kmer(size_t v) const {
+        string kmer(mKmerLength, '$');
+        for(int i = mKmerLength - 1; i >= 0; --i){
+            size_t c = last_label(v);
+            if(c == 0){
+                break;
+            }
+            kmer[i] = mAlphabet[c-1];
+            size_t incoming = label_select(c, false, v - mFirst[c]);
+            v = mLast.rank1(incoming);
+        }
+        return kmer;
+    }
+
+    /**
+     * Call func(target, label) for every outgoing edge of a vertex, in label order
+     * @param v vertex rank
+     */
+    template <typename FuncType>
+    void for_each_successor(size_t v, FuncType func) const {
+        for(size_t e = first_edge(v), end = last_edge(v); e <= end; ++e){
+            size_t c = label(e);
+            if(c != 0){
+                func(target(e, c), c);
+            }
+        }
+    }
+
+    /**
+     * @param c edge label (not '$')
+     * @return the character it stands for
+     */
+    char symbol(size_t c) const { return mAlphabet[c-1]; }
+
+    /**
+     * @return number of vertices, '$' padding included (vertex ranks are below this)
+     */
+    size_t vertex_count() const { return mVertexCount; }
+
+    /**
+     * Check whether a k-mer is a vertex of the graph
+     * @param kmer to look for
+     * @return true if present
+     */
+    bool contains(const string & kmer) const { return find_vertex(kmer) != NOT_FOUND; }
+
+    /**
+     * Same contract as DeBruijnGraph::is_valid (including that it stops one k-mer short of the end)
+     * @param sequence to evaluate
+     * @return true if the sequence is in the graph
+     */
+    bool is_valid(const string & sequence) const {
+        if(int(sequence.size()) <= mKmerLength + 1){
+            return true;
+        }
+        size_t current = find_vertex(sequence.substr(0, mKmerLength));
+        for(int i = 0; i + mKmerLength + 1 < int(sequence.size()); ++i){
+            if(current == NOT_FOUND){
+                return false;
+            }
+            size_t c = mLabelOf[uint8_t(sequence[i + mKmerLength])];
+            size_t next = NOT_FOUND;
+            for_each_successor(current, [&] (size_t t, size_t l) { if(l == c){ next = t; } });
+            current = next;
+        }
+        return current != NOT_FOUND;
+    }
+
+///@remark SUCCESSORS AND COUNTS /////////////////////////////////////////////////////////////
+
+    /**
+     * Successor enumeration
+     * @param kmer vertex
+     * @return its adjacency list, in the same (sorted) order as DeBruijnGraph
+     */
+    vector<string> get_adj_list(const string & kmer) const {
+        vector<string> adj;
+        size_t v = find_vertex(kmer);
+        if(v != NOT_FOUND){
+            for_each_successor(v, [&] (size_t, size_t c) { adj.push_back(kmer.substr(1) + mAlphabet[c-1]); });
+        }
+        return adj;
+    }
+
+    /**
+     * @param kmer vertex
+     * @return number of times the k-mer is used in the pangenome (0 if absent)
+     */
+    int get_kmer_occurrences(const string & kmer) const {
+        size_t v = find_vertex(kmer);
+        return v == NOT_FOUND ? 0 : mOccurrences[real_rank(v)];
+    }
+
+    /**
+     * @param kmer vertex
+     * @return number of sequences that end at the k-mer (0 if absent)
+     */
+    int get_endpoint(const string & kmer) const {
+        size_t v = find_vertex(kmer);
+        return v == NOT_FOUND ? 0 : mEndpoints[real_rank(v)];
+    }
+
+    /**
+     * Given a vertex, return true if the vertex branches
+     * @param kmer to check
+     * @return true if the vertex has more than one successor
+     */
+    bool vertex_branch_check(const string & kmer) const { return get_adj_list(kmer).size() > 1; }
+
+    /**
+     * Return vector containing vertices with more than one adjacency in graph
+     * @return branched vertex IDs, in colexicographic order
+     */
+    vector<string> get_branch_vertices() const {
+        vector<string> branches;
+        for(size_t v = 0; v < mVertexCount; ++v){
+            if(mReal[v] && last_edge(v) > first_edge(v)){
+                branches.push_back(get_kmer(v));
+            }
+        }
+        return branches;
+    }
+
+    /**
+     * @return start vertices, in the order of the source graph
+     */
+    vector<string> get_start_vertices() const {
+        vector<string> starts;
+        for(size_t v : mStarts){
+            starts.push_back(get_kmer(v));
+        }
+        return starts;
+    }
+
+    /**
+     * @return number of (real) vertices
+     */
+    int get_size() const { return mRealVertices; }
+
+    /**
+     * @return number of (real) edges
+     */
+    int edge_count() const { return mRealEdges; }
+
+    /**
+     * @return length of the k-mer IDs
+     */
+    int get_kmer_len() const { return mKmerLength; }
+
+    /**
+     * @return length of the genomes random walks build
+     */
+    int get_sequence_length() const { return mSequenceLength; }
+
+///@remark TRAVERSAL AND RANDOM WALKS /////////////////////////////////////////////////////////////
+
+    template <typename FuncType>
+    /**
+     * Depth-first traversal with the same visiting order and rules as DeBruijnGraph::depth_first_traversal
+     * @param func lambda taking the vertex's k-mer
+     */
+    void depth_first_traversal(FuncType func) const {
+        if(mRealVertices == 1 && !mStarts.empty()){
+            func(get_kmer(mStarts[0]));
+            return;
+        }
+        vector<int> visits(mVertexCount, 0);
+        vector<size_t> path(mStarts.begin(), mStarts.end());
+        vector<size_t> successors;
+        while(path.size() > 0){
+            size_t current = path.back();
+            path.pop_back();
+            successors.clear();
+            for_each_successor(current, [&] (size_t t, size_t) { successors.push_back(t); });
+            if(visits[current] <= int(successors.size())){
+                func(get_kmer(current));
+                if(visits[current] < 1){
+                    path.insert(path.end(), successors.rbegin(), successors.rend());
+                }
+                visits[current]++;
+            }
+        }
+    }
+
+    /**
+     * Build a new genome the way DeBruijnGraph::modify_org does, by walking the frozen graph and choosing
+     * branches at random. The graph is not changed; if the walk reaches a vertex with nothing left to
+     * choose it stops early.
+     * @param random random number generator (see RandomPolicy.hpp), such as emp::Random, CounterRandom or Xoshiro256
+     * @param organism genome whose first k-mer the walk starts from
+     * @param probability that the walk takes place (otherwise organism is returned)
+     * @param seq_count if true, a successor is used at most as often as the k-mer appears in the pangenome
+     * @param variable_length if true, the walk may stop at any endpoint vertex
+     * @return the new genome
+     */
+    template <typename RandomT>
+    string random_walk(RandomT & random, const string & organism, double probability = 1, bool seq_count = 1, bool variable_length = 0) const {
+        return with_random_calls(random, [&] (auto & calls) {
+            return walk_calls(calls, organism, probability, seq_count, variable_length);
+        });
+    }
+
+private:
+    /**
+     * random_walk with a generator that has the GetUInt / P calls
+     */
+    template <typename RandomT>
+    string walk_calls(RandomT & random, const string & organism, double probability, bool seq_count, bool variable_length) const {
+        string path = organism.substr(0, mKmerLength);
+        size_t current = find_vertex(path);
+        if(current == NOT_FOUND){
+            throw std::invalid_argument("SuccinctDeBruijnGraph::random_walk: organism does not start at a vertex of the graph");
+        }
+        if(!random.P(probability)){
+            return organism;
+        }
+        std::unordered_map<size_t, int> visits;
+        std::unordered_map<size_t, vector<size_t>> available;
+        visits[current]++;
+        while(int(path.size()) < mSequenceLength){
+            vector<size_t> & choices = available[current];
+            if(visits[current] == 1){
+                for_each_successor(current, [&] (size_t t, size_t) { choices.push_back(t); });
+            }
+            size_t index;
+            if(variable_length && mEndpoints[real_rank(current)] > 0){
+                index = random.GetUInt(choices.size() + 1);
+                if(index == choices.size()){
+                    break;
+                }
+            }
+            else {
+                if(choices.empty()){
+                    break;
+                }
+                index = random.GetUInt(choices.size());
+            }
+            size_t next = choices[index];
+            path += mAlphabet[last_label(next) - 1];
+            visits[next]++;
+            if(seq_count && visits[next] == int(mOccurrences[real_rank(current)])){
+                choices.erase(std::remove(choices.begin(), choices.end(), next), choices.end());
+            }
+            current = next;
+        }
+        return path;
+    }
+
+public:
+
+///@remark SPACE /////////////////////////////////////////////////////////////
+
+    /**
+     * @return bytes used by the succinct structures
+     */
+    size_t size_in_bytes() const {
+        return sizeof(*this) + mLast.size_in_bytes() + mReal.size_in_bytes() + mLabels.size_in_bytes()
+            + mOccurrences.size_in_bytes() + mEndpoints.size_in_bytes()
+            + mFirst.size() * sizeof(size_t) + mStarts.size() * sizeof(size_t) + mAlphabet.size();
+    }
+
+    /**
+     * @return bits per real edge, everything included
+     */
+    double bits_per_edge() const { return mRealEdges == 0 ? 0 : 8.0 * size_in_bytes() / mRealEdges; }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_SUCCINCTDEBRUIJNGRAPH_H
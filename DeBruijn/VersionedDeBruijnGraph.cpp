@@ -0,0 +1,86 @@
+/**
+ * @file VersionedDeBruijnGraph.cpp
+ * @author Anna Catenacci
+ */
+
+#include "VersionedDeBruijnGraph.hpp"
+#include <thread>
+#include <sstream>
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+TEST_CASE("VersionedDeBruijnGraph__snapshot-isolation", "[VersionedDeBruijnGraph.hpp]")
+{
+    {
+        VersionedDeBruijnGraph versions(3);
+        versions.update([] (DeBruijnGraph & g) {
+            g.add_sequence("12345678");
+            g.add_sequence("12345000");
+        });
+        CHECK(versions.get_version() == 1);
+
+        // a reader pins version 1 and keeps it while the writer moves on
+        VersionedDeBruijnGraph::snapshot_t pinned = versions.pin();
+        std::weak_ptr<const DeBruijnGraph> watcher = pinned;
+
+        versions.draft().remove_sequence("12345678");
+        versions.draft().add_sequence("99945000");
+        CHECK(versions.pin()->get_sequence_size() == 2);   // draft is not visible yet
+        CHECK(versions.pin()->is_valid("12345678"));
+        CHECK(versions.publish() == 2);
+
+        CHECK(pinned->get_sequence_size() == 2);
+        CHECK(pinned->is_valid("12345678"));
+        CHECK(!pinned->is_valid("99945000"));
+        CHECK(!versions.pin()->is_valid("12345678"));
+        CHECK(versions.pin()->is_valid("99945000"));
+        CHECK(versions.pin()->get_start_vertices().size() == 2);
+
+        // the old version is reclaimed once its last reader lets go
+        CHECK(!watcher.expired());
+        pinned.reset();
+        CHECK(watcher.expired());
+
+        // discarded drafts never become visible
+        versions.draft().add_sequence("55555555");
+        versions.discard();
+        CHECK(versions.publish() == 2);
+        CHECK(!versions.pin()->is_valid("55555555"));
+    }
+}
+
+TEST_CASE("VersionedDeBruijnGraph__readers-during-updates", "[VersionedDeBruijnGraph.hpp]")
+{
+    {
+        VersionedDeBruijnGraph versions(3);
+        versions.update([] (DeBruijnGraph & g) { g.add_sequence("1110000"); });
+
+        // readers traverse and write CSVs from whatever version they pin while the writer publishes
+        std::atomic<bool> consistent{true};
+        vector<std::thread> readers;
+        for(int t = 0; t < 3; ++t){
+            readers.emplace_back([&versions, &consistent] () {
+                for(int i = 0; i < 50; ++i){
+                    auto snapshot = versions.pin();
+                    int visited = 0;
+                    snapshot->depth_first_traversal([&visited] (string) { visited++; });
+                    std::ostringstream out;
+                    snapshot->write_csv(out, std::to_string(i));
+                    if(visited < snapshot->get_size() || out.str().empty()){
+                        consistent = false;
+                    }
+                }
+            });
+        }
+        for(int generation = 0; generation < 20; ++generation){
+            versions.update([generation] (DeBruijnGraph & g) {
+                g.add_sequence("111" + std::to_string(generation % 10) + "000");
+            });
+        }
+        for(auto & reader : readers){ reader.join(); }
+
+        CHECK(consistent);
+        CHECK(versions.get_version() == 21);
+        CHECK(versions.pin()->get_sequence_size() == 21);
+    }
+}
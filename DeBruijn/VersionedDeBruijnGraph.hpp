@@ -0,0 +1,141 @@
+/**
+ * @file VersionedDeBruijnGraph.hpp
+ * @author Anna Catenacci
+ *
+ * Snapshot isolation for the pangenome, in the style of read-copy-update.
+ * Readers pin an immutable version of the graph and keep using it for as long as they like,
+ * while a single writer builds the next version (births and deaths of the next generation)
+ * in a private draft and then publishes it with one atomic pointer swap.
+ * A version is reclaimed automatically when the last reader holding it lets go.
+ *
+ * Typical use in a MABE run:
+ *     auto snapshot = versions.pin();                        // analysis / sampling thread(s)
+ *     snapshot->write_csv(out, "200");
+ *
+ *     versions.draft().add_sequence(child);                  // writer thread
+ *     versions.draft().remove_sequence(dead);
+ *     versions.publish();
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERSIONEDDEBRUIJNGRAPH_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERSIONEDDEBRUIJNGRAPH_H
+
+#include "DeBruijnGraph.hpp"
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+class VersionedDeBruijnGraph {
+public:
+    using snapshot_t = std::shared_ptr<const DeBruijnGraph>;
+private:
+
+    /// Latest published version. Only accessed through std::atomic_load / std::atomic_store.
+    snapshot_t mPublished;
+
+    /// Next version, private to the writer until publish() is called
+    std::shared_ptr<DeBruijnGraph> mDraft;
+
+    /// Number of versions published so far
+    std::atomic<size_t> mVersion{0};
+
+    /// Serializes writers; readers never take it
+    std::mutex mWriterMutex;
+
+    /**
+     * Make sure a draft exists. The caller must hold mWriterMutex.
+     * @return the draft graph
+     */
+    DeBruijnGraph & ensure_draft(){
+        if(!mDraft){
+            mDraft = std::make_shared<DeBruijnGraph>(*std::atomic_load(&mPublished));
+        }
+        return *mDraft;
+    }
+
+    /**
+     * Swap the draft in as the published version. The caller must hold mWriterMutex.
+     * @return the number of the latest published version
+     */
+    size_t publish_draft(){
+        if(mDraft){
+            std::atomic_store(&mPublished, snapshot_t(std::move(mDraft)));
+            mDraft.reset();
+            ++mVersion;
+        }
+        return mVersion;
+    }
+
+public:
+    /**
+     * Start from an empty graph
+     * @param kmer_length length of each vertex ID
+     */
+    VersionedDeBruijnGraph(int kmer_length = 3) : mPublished(std::make_shared<const DeBruijnGraph>(kmer_length)) { }
+
+    /**
+     * Start from an existing graph, which becomes version 0
+     * @param initial graph to publish
+     */
+    VersionedDeBruijnGraph(const DeBruijnGraph & initial) : mPublished(std::make_shared<const DeBruijnGraph>(initial)) { }
+
+    ~VersionedDeBruijnGraph()=default;
+    VersionedDeBruijnGraph(const VersionedDeBruijnGraph &) = delete;
+    VersionedDeBruijnGraph & operator=(const VersionedDeBruijnGraph &) = delete;
+
+    /**
+     * Pin the latest published version. Wait-free with respect to the writer.
+     * The returned graph never changes; use its const interface (is_valid, get_value, write_csv,
+     * display, the const depth_first_traversal, ...). Drop the pointer to release the version.
+     * @return shared pointer to an immutable graph
+     */
+    snapshot_t pin() const { return std::atomic_load(&mPublished); }
+
+    /**
+     * Get the writer's draft of the next version, copying the published version on first use.
+     * The draft belongs to a single writer thread; use update() when several threads may write.
+     * @return mutable graph that readers cannot see yet
+     */
+    DeBruijnGraph & draft(){
+        std::lock_guard<std::mutex> guard(mWriterMutex);
+        return ensure_draft();
+    }
+
+    /**
+     * Make the draft the new published version. Readers pinned to older versions keep them.
+     * @return the number of the version that was just published
+     */
+    size_t publish(){
+        std::lock_guard<std::mutex> guard(mWriterMutex);
+        return publish_draft();
+    }
+
+    /**
+     * Throw away the draft without publishing it
+     */
+    void discard(){
+        std::lock_guard<std::mutex> guard(mWriterMutex);
+        mDraft.reset();
+    }
+
+    /**
+     * Apply a whole batch of mutations to a fresh draft and publish it in one step
+     * @param mutation callable taking a DeBruijnGraph & (e.g. a generation's births and deaths)
+     * @return the number of the version that was just published
+     */
+    template <typename FuncType>
+    size_t update(FuncType mutation){
+        std::lock_guard<std::mutex> guard(mWriterMutex);
+        mutation(ensure_draft());
+        return publish_draft();
+    }
+
+    /**
+     * Return the number of the latest published version
+     * @return version count, starting at 0 for the initial graph
+     */
+    size_t get_version() const { return mVersion; }
+
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERSIONEDDEBRUIJNGRAPH_H
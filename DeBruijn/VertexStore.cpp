@@ -0,0 +1,192 @@
+/**
+ * @file VertexStore.cpp
+ * @author Anna Catenacci
+ */
+
+#include "VertexStore.hpp"
+#define CATCH_CONFIG_MAIN
+#include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
+
+namespace {
+    /// Every 10-bit binary string, so the store has to split into several chunks
+    vector<string> all_kmers(){
+        vector<string> kmers;
+        for(int i = 0; i < 1024; ++i){
+            string kmer;
+            for(int bit = 9; bit >= 0; --bit){
+                kmer += ((i >> bit) & 1) ? '1' : '0';
+            }
+            kmers.push_back(kmer);
+        }
+        return kmers;
+    }
+}
+
+TEST_CASE("CowVertexStore__map-behaviour", "[VertexStore.hpp]")
+{
+    {
+        CowVertexStore store;
+        vector<string> kmers = all_kmers();
+        // insert out of order; iteration must still be sorted
+        for(int i = int(kmers.size()) - 1; i >= 0; --i){
+            store[kmers[i]].increment_kmer_occurrences();
+        }
+        CHECK(store.size() == 1024);
+        CHECK(store.chunk_count() > 1);
+
+        vector<string> iterated;
+        for(auto const & element : store){
+            iterated.push_back(element.first);
+            CHECK(element.second.get_kmer_occurrences() == 1);
+        }
+        CHECK(iterated == kmers);
+
+        CHECK(store.count("0000000000") == 1);
+        CHECK(store.count("000000000") == 0);
+        CHECK(store.find("1111111111") != store.end());
+        CHECK(store.find("2") == store.end());
+
+        for(size_t i = 0; i < kmers.size(); i += 2){
+            CHECK(store.erase(kmers[i]) == 1);
+        }
+        CHECK(store.erase(kmers[0]) == 0);
+        CHECK(store.size() == 512);
+        size_t counted = 0;
+        for(auto const & element : store){
+            CHECK(element.first.back() == '1');
+            counted++;
+        }
+        CHECK(counted == 512);
+
+        for(size_t i = 1; i < kmers.size(); i += 2){
+            store.erase(kmers[i]);
+        }
+        CHECK(store.empty());
+        CHECK(store.begin() == store.end());
+    }
+}
+
+TEST_CASE("CowVertexStore__copy-on-write", "[VertexStore.hpp]")
+{
+    {
+        CowVertexStore original;
+        vector<string> kmers = all_kmers();
+        for(auto const & kmer : kmers){
+            original[kmer].increment_kmer_occurrences();
+        }
+        size_t chunks = original.chunk_count();
+
+        // copying shares everything
+        CowVertexStore clone = original;
+        CHECK(clone.shared_chunk_count() == chunks);
+
+        // a write only duplicates the chunk it lands in
+        clone["0000000000"].increment_kmer_occurrences();
+        CHECK(clone.shared_chunk_count() == chunks - 1);
+        CHECK(clone.find("0000000000")->second.get_kmer_occurrences() == 2);
+        CHECK(original.find("0000000000")->second.get_kmer_occurrences() == 1);
+
+        // reads through a const reference never duplicate anything
+        const CowVertexStore & view = clone;
+        size_t seen = 0;
+        for(auto const & element : view){
+            seen += element.second.get_kmer_occurrences();
+        }
+        CHECK(seen == 1025);
+        CHECK(view.lookup(std::string_view("1010101010")) != nullptr);
+        CHECK(view.lookup(std::string_view("2")) == nullptr);
+        CHECK(clone.shared_chunk_count() == chunks - 1);
+
+        clone.erase("1111111111");
+        clone["2222222222"];
+        CHECK(original.count("1111111111") == 1);
+        CHECK(original.count("2222222222") == 0);
+        CHECK(original.size() == 1024);
+        CHECK(clone.size() == 1024);
+    }
+}
+
+namespace {
+    /// Insert, look up and erase through any of the stores, comparing against std::map
+    template <typename StoreT>
+    void check_store_behaves_like_map(){
+        StoreT store;
+        map<string, int> expected;
+        vector<string> kmers;
+        for(auto const & kmer : all_kmers()){
+            if(kmer.substr(0, 2) == "00"){
+                kmers.push_back(kmer.substr(2)); // 8 characters, so every store can hold them
+            }
+        }
+        for(size_t i = 0; i < kmers.size(); ++i){
+            store[kmers[(i * 37) % kmers.size()]].increment_kmer_occurrences();
+            expected[kmers[(i * 37) % kmers.size()]]++;
+        }
+        // erase in an order unrelated to the insertion order, re-checking after each removal
+        for(size_t i = 0; i < kmers.size(); i += 3){
+            CHECK(store.erase(kmers[i]) == 1);
+            CHECK(store.erase(kmers[i]) == 0);
+            expected.erase(kmers[i]);
+            CHECK(store.count(kmers[i]) == 0);
+        }
+        CHECK(store.size() == expected.size());
+        for(auto const & element : expected){
+            auto found = store.find(element.first);
+            REQUIRE(found != store.end());
+            CHECK(found->second.get_kmer_occurrences() == element.second);
+        }
+        map<string, int> iterated;
+        const StoreT & view = store;
+        for(auto const & element : view){
+            iterated[element.first] = element.second.get_kmer_occurrences();
+        }
+        CHECK(iterated == expected);
+
+        // lookup finds the same vertices through views into a longer buffer, without inserting anything
+        for(size_t i = 0; i < kmers.size(); ++i){
+            string buffer = "x" + kmers[i] + "y";
+            const DBGraphValue * value = view.lookup(std::string_view(buffer).substr(1, kmers[i].size()));
+            if(expected.count(kmers[i])){
+                REQUIRE(value != nullptr);
+                CHECK(value == &store.find(kmers[i])->second);
+            }
+            else {
+                CHECK(value == nullptr);
+            }
+        }
+        CHECK(view.lookup("000") == nullptr);
+        CHECK(store.size() == expected.size());
+
+        StoreT copy(view.begin(), view.end());
+        CHECK(copy.size() == store.size());
+        store.clear();
+        CHECK(store.empty());
+        CHECK(store.find("00000000") == store.end());
+        CHECK(copy.count("00000001") == 1);
+    }
+}
+
+TEST_CASE("VertexStore__hash-backends", "[VertexStore.hpp]")
+{
+    {
+        check_store_behaves_like_map<OrderedVertexStore>();
+        check_store_behaves_like_map<FlatHashVertexStore>();
+        check_store_behaves_like_map<PackedKeyVertexStore>();
+
+        PackedKeyVertexStore packed;
+        CHECK_THROWS_AS(packed["123456789"], std::length_error);
+        CHECK(packed.count("123456789") == 0);
+
+        CowVertexStore source;
+        source["b"].increment_kmer_occurrences();
+        source["a"];
+        FrozenVertexStore frozen(source.begin(), source.end());
+        CHECK(frozen.begin()->first == "a");
+        CHECK(frozen["b"].get_kmer_occurrences() == 1);
+        CHECK_THROWS_AS(frozen["c"], std::logic_error);
+        CHECK_THROWS_AS(frozen.erase("a"), std::logic_error);
+        CHECK(frozen.size() == 2);
+        CHECK(frozen.lookup("b")->get_kmer_occurrences() == 1);
+        CHECK(frozen.lookup("c") == nullptr);
+    }
+}
@@ -0,0 +1,1051 @@
+/**
+ * @file VertexStore.hpp
+ * @author Anna Catenacci
+ *
+ * Containers that hold the k-mer -> DBGraphValue map behind a DeBruijnGraph.
+ * BasicDeBruijnGraph takes one of these as its storage policy; DeBruijnGraph uses CowVertexStore.
+ *
+ * A storage policy provides the subset of the std::map interface the graph uses
+ * (operator[], count, find, erase, begin/end, size, empty, clear, a range constructor),
+ * plus lookup (a const, allocation-free find by string_view that returns a value pointer),
+ * ORDERED (iteration is in sorted k-mer order), READ_ONLY (vertices cannot be added or removed),
+ * MAX_KMER_LENGTH (longest k-mer the store can hold, so a graph can refuse a k it cannot store up front),
+ * overhead_bytes() and allocation_count() for DeBruijnGraph::memory_usage().
+ *
+ * - OrderedVertexStore is the plain std::map reference backend.
+ * - CowVertexStore keeps the vertices in sorted chunks that are shared between copies of the store.
+ *   Copying a store (and therefore a DeBruijnGraph) only copies one pointer; the first write to a copy
+ *   duplicates the chunk directory, and each chunk is only duplicated when one of its vertices is
+ *   written. This makes forking replicate simulations from a common ancestor pangenome cheap.
+ *   Iteration order is the same sorted order as std::map.
+ * - FlatHashVertexStore is an open-addressing (linear probing) hash table with the entries stored inline.
+ * - PackedKeyVertexStore packs each k-mer (up to 8 characters) into a 64-bit word, keeps keys and values
+ *   in dense arrays and hashes into them through a table of 32-bit indices.
+ * - FrozenVertexStore is a sorted array built once from another store, for read-only graphs.
+ */
+
+#ifndef PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERTEXSTORE_H
+#define PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERTEXSTORE_H
+
+#include "DeBruijnValue.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+
+using std::string; using std::vector; using std::map;
+
+/// Lookups by string_view find their vertex without building a string (std::less<> is transparent)
+using vertex_map_t = map<string, DBGraphValue, std::less<>>;
+
+class OrderedVertexStore : public vertex_map_t {
+public:
+    using vertex_map_t::map;
+
+    static constexpr bool ORDERED = true;
+    static constexpr bool READ_ONLY = false;
+    static constexpr size_t MAX_KMER_LENGTH = SIZE_MAX;
+
+    /// Bookkeeping bytes of one std::map node (colour, parent, left and right links)
+    static constexpr size_t NODE_OVERHEAD_BYTES = 4 * sizeof(void *);
+
+    /**
+     * Estimate the bytes spent on tree nodes (not on the keys and values themselves)
+     * @return bytes
+     */
+    size_t overhead_bytes() const { return sizeof(vertex_map_t) + size() * NODE_OVERHEAD_BYTES; }
+
+    /**
+     * @return number of separate heap allocations the store makes (one per node)
+     */
+    size_t allocation_count() const { return size(); }
+
+    /**
+     * Find a vertex without inserting it or copying the key
+     * @param key k-mer
+     * @return the vertex value, or nullptr if absent
+     */
+    const DBGraphValue * lookup(std::string_view key) const {
+        auto found = vertex_map_t::find(key);
+        return found == end() ? nullptr : &found->second;
+    }
+};
+
+class CowVertexStore {
+public:
+    using chunk_t = vertex_map_t;
+    using value_type = chunk_t::value_type;
+
+    static constexpr bool ORDERED = true;
+    static constexpr bool READ_ONLY = false;
+    static constexpr size_t MAX_KMER_LENGTH = SIZE_MAX;
+
+    /// Largest number of vertices a chunk holds before it is split in two
+    static constexpr size_t MAX_CHUNK_SIZE = 256;
+
+    /// Bookkeeping bytes of one std::map node
+    static constexpr size_t NODE_OVERHEAD_BYTES = OrderedVertexStore::NODE_OVERHEAD_BYTES;
+
+private:
+
+    /// Sorted list of chunks; chunk i holds the keys in [mFences[i], mFences[i+1])
+    struct Directory {
+        vector<string> mFences = {""};
+        vector<std::shared_ptr<chunk_t>> mChunks = {std::make_shared<chunk_t>()};
+    };
+
+    /// Chunk directory, shared between copies until one of them writes
+    std::shared_ptr<Directory> mDirectory = std::make_shared<Directory>();
+
+    /// Number of vertices in the store
+    size_t mSize = 0;
+
+    /**
+     * Find the chunk a key belongs in
+     * @param key k-mer
+     * @return chunk index
+     */
+    size_t chunk_index(std::string_view key) const {
+        const vector<string> & fences = mDirectory->mFences;
+        return std::upper_bound(fences.begin() + 1, fences.end(), key) - fences.begin() - 1;
+    }
+
+    /**
+     * Give this store its own copy of the directory, if it is shared
+     * @return the (now private) directory
+     */
+    Directory & own_directory(){
+        if(mDirectory.use_count() > 1){
+            mDirectory = std::make_shared<Directory>(*mDirectory);
+        }
+        return *mDirectory;
+    }
+
+    /**
+     * Give this store its own copy of a chunk, if it is shared
+     * @param index chunk index
+     * @return the (now private) chunk
+     */
+    chunk_t & own_chunk(size_t index){
+        Directory & directory = own_directory();
+        if(directory.mChunks[index].use_count() > 1){
+            directory.mChunks[index] = std::make_shared<chunk_t>(*directory.mChunks[index]);
+        }
+        return *directory.mChunks[index];
+    }
+
+    /**
+     * Split a chunk in half once it grows past MAX_CHUNK_SIZE. The chunk must already be private.
+     * @param index chunk index
+     */
+    void split_chunk(size_t index){
+        Directory & directory = *mDirectory;
+        chunk_t & chunk = *directory.mChunks[index];
+        auto middle = std::next(chunk.begin(), chunk.size() / 2);
+        auto upper = std::make_shared<chunk_t>();
+        string fence = middle->first;
+        upper->insert(std::make_move_iterator(middle), std::make_move_iterator(chunk.end()));
+        chunk.erase(middle, chunk.end());
+        directory.mFences.insert(directory.mFences.begin() + index + 1, fence);
+        directory.mChunks.insert(directory.mChunks.begin() + index + 1, upper);
+    }
+
+    /**
+     * Drop a chunk that has become empty, handing its key range to a neighbour
+     * @param index chunk index
+     */
+    void drop_chunk(size_t index){
+        Directory & directory = own_directory();
+        if(directory.mChunks.size() == 1){
+            return;
+        }
+        directory.mChunks.erase(directory.mChunks.begin() + index);
+        directory.mFences.erase(directory.mFences.begin() + index);
+        directory.mFences[0] = "";
+    }
+
+    /**
+     * Iterator over all vertices in sorted order
+     * @tparam IS_CONST true for const_iterator
+     */
+    template <bool IS_CONST>
+    class basic_iterator {
+        friend class CowVertexStore;
+        using directory_t = typename std::conditional<IS_CONST, const Directory, Directory>::type;
+        using chunk_iterator_t = typename std::conditional<IS_CONST, chunk_t::const_iterator, chunk_t::iterator>::type;
+
+        directory_t * mDir = nullptr;
+        size_t mChunk = 0;
+        chunk_iterator_t mIt;
+
+        /// Step over empty chunks so mIt always points at a vertex (or we are at the end)
+        void settle(){
+            while(mChunk < mDir->mChunks.size() && mIt == chunk_end()){
+                ++mChunk;
+                if(mChunk < mDir->mChunks.size()){
+                    mIt = chunk_begin();
+                }
+            }
+        }
+        chunk_iterator_t chunk_begin() const { return mDir->mChunks[mChunk]->begin(); }
+        chunk_iterator_t chunk_end() const { return mDir->mChunks[mChunk]->end(); }
+
+        basic_iterator(directory_t * dir, size_t chunk, chunk_iterator_t it) : mDir(dir), mChunk(chunk), mIt(it) { settle(); }
+        basic_iterator(directory_t * dir) : mDir(dir), mChunk(dir->mChunks.size()) { }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CowVertexStore::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = typename std::conditional<IS_CONST, const value_type &, value_type &>::type;
+        using pointer = typename std::conditional<IS_CONST, const value_type *, value_type *>::type;
+
+        basic_iterator()=default;
+        /// Allow iterator -> const_iterator
+        template <bool OTHER_CONST, typename = typename std::enable_if<IS_CONST && !OTHER_CONST>::type>
+        basic_iterator(const basic_iterator<OTHER_CONST> & other) : mDir(other.mDir), mChunk(other.mChunk), mIt(other.mIt) { }
+
+        reference operator*() const { return *mIt; }
+        pointer operator->() const { return &*mIt; }
+        basic_iterator & operator++(){ ++mIt; settle(); return *this; }
+        basic_iterator operator++(int){ basic_iterator old = *this; ++(*this); return old; }
+        bool operator==(const basic_iterator & other) const {
+            return mChunk == other.mChunk && (mChunk >= mDir->mChunks.size() || mIt == other.mIt);
+        }
+        bool operator!=(const basic_iterator & other) const { return !(*this == other); }
+
+        template <bool> friend class basic_iterator;
+    };
+
+public:
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    CowVertexStore()=default;
+    ~CowVertexStore()=default;
+    CowVertexStore(const CowVertexStore &) = default;
+    CowVertexStore & operator=(const CowVertexStore &) = default;
+
+    /**
+     * Copy the vertices of another store
+     * @param begin first (k-mer, value) pair
+     * @param end one past the last pair
+     */
+    template <typename Iterator>
+    CowVertexStore(Iterator begin, Iterator end){
+        for(; begin != end; ++begin){
+            (*this)[begin->first] = begin->second;
+        }
+    }
+
+    /**
+     * Access a vertex, inserting an empty one if needed. Duplicates the vertex's chunk if it is shared.
+     * @param key k-mer
+     * @return the vertex value
+     */
+    DBGraphValue & operator[](const string & key){
+        size_t index = chunk_index(key);
+        chunk_t & chunk = own_chunk(index);
+        auto found = chunk.find(key);
+        if(found != chunk.end()){
+            return found->second;
+        }
+        mSize++;
+        if(chunk.size() < MAX_CHUNK_SIZE){
+            return chunk[key];
+        }
+        chunk[key];
+        split_chunk(index);
+        return (*mDirectory->mChunks[chunk_index(key)])[key];
+    }
+
+    /**
+     * @param key k-mer
+     * @return 1 if the vertex is in the store, 0 if not
+     */
+    size_t count(const string & key) const { return mDirectory->mChunks[chunk_index(key)]->count(key); }
+
+    /**
+     * Remove a vertex
+     * @param key k-mer
+     * @return number of vertices removed
+     */
+    size_t erase(const string & key){
+        size_t index = chunk_index(key);
+        if(mDirectory->mChunks[index]->count(key) == 0){
+            return 0;
+        }
+        chunk_t & chunk = own_chunk(index);
+        chunk.erase(key);
+        mSize--;
+        if(chunk.empty()){
+            drop_chunk(index);
+        }
+        return 1;
+    }
+
+    /**
+     * Find a vertex without inserting it. Duplicates the vertex's chunk if it is shared.
+     * @param key k-mer
+     * @return iterator to the vertex, or end()
+     */
+    iterator find(const string & key){
+        size_t index = chunk_index(key);
+        if(mDirectory->mChunks[index]->count(key) == 0){
+            return end();
+        }
+        chunk_t & chunk = own_chunk(index);
+        return iterator(mDirectory.get(), index, chunk.find(key));
+    }
+
+    /**
+     * Find a vertex without inserting it or copying anything
+     * @param key k-mer
+     * @return const iterator to the vertex, or end()
+     */
+    const_iterator find(const string & key) const {
+        size_t index = chunk_index(key);
+        const chunk_t & chunk = *mDirectory->mChunks[index];
+        auto found = chunk.find(key);
+        if(found == chunk.end()){
+            return end();
+        }
+        return const_iterator(mDirectory.get(), index, found);
+    }
+
+    /**
+     * Find a vertex without inserting it, copying the key or duplicating a chunk
+     * @param key k-mer
+     * @return the vertex value, or nullptr if absent
+     */
+    const DBGraphValue * lookup(std::string_view key) const {
+        const chunk_t & chunk = *mDirectory->mChunks[chunk_index(key)];
+        auto found = chunk.find(key);
+        return found == chunk.end() ? nullptr : &found->second;
+    }
+
+    /**
+     * Mutable iteration needs every chunk to be private, so this duplicates any shared chunks.
+     * Iterate through a const reference when only reading.
+     */
+    iterator begin(){
+        Directory & directory = own_directory();
+        for(size_t i = 0; i < directory.mChunks.size(); ++i){
+            own_chunk(i);
+        }
+        return iterator(&directory, 0, directory.mChunks[0]->begin());
+    }
+    iterator end(){ return iterator(mDirectory.get()); }
+    const_iterator begin() const { return const_iterator(mDirectory.get(), 0, mDirectory->mChunks[0]->cbegin()); }
+    const_iterator end() const { return const_iterator(mDirectory.get()); }
+
+    /**
+     * @return number of vertices in the store
+     */
+    size_t size() const { return mSize; }
+
+    /**
+     * @return true if the store has no vertices
+     */
+    bool empty() const { return mSize == 0; }
+
+    /**
+     * Remove all vertices
+     */
+    void clear(){
+        mDirectory = std::make_shared<Directory>();
+        mSize = 0;
+    }
+
+    /**
+     * @return number of chunks the vertices are split into
+     */
+    size_t chunk_count() const { return mDirectory->mChunks.size(); }
+
+    /**
+     * Estimate the bytes spent on tree nodes and chunk bookkeeping (not on the keys and values themselves)
+     * @return bytes
+     */
+    size_t overhead_bytes() const {
+        size_t per_chunk = sizeof(chunk_t) + 2 * sizeof(void *) + sizeof(std::shared_ptr<chunk_t>) + sizeof(string);
+        return sizeof(Directory) + mSize * NODE_OVERHEAD_BYTES + mDirectory->mChunks.size() * per_chunk;
+    }
+
+    /**
+     * @return number of separate heap allocations the store makes (one per node and per chunk)
+     */
+    size_t allocation_count() const { return mSize + mDirectory->mChunks.size(); }
+
+    /**
+     * Count the chunks this store still shares with another copy
+     * @return number of shared chunks
+     */
+    size_t shared_chunk_count() const {
+        size_t shared = 0;
+        for(auto const & chunk : mDirectory->mChunks){
+            if(mDirectory.use_count() > 1 || chunk.use_count() > 1){
+                shared++;
+            }
+        }
+        return shared;
+    }
+
+};
+
+class FlatHashVertexStore {
+public:
+    using value_type = std::pair<string, DBGraphValue>;
+
+    static constexpr bool ORDERED = false;
+    static constexpr bool READ_ONLY = false;
+    static constexpr size_t MAX_KMER_LENGTH = SIZE_MAX;
+
+    /// Capacity the table starts at once the first vertex is added
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+private:
+
+    /// Entries, stored inline; only the slots marked in mUsed hold a vertex
+    vector<value_type> mSlots;
+
+    /// Marks which slots are in use
+    vector<uint8_t> mUsed;
+
+    /// Number of vertices in the store
+    size_t mSize = 0;
+
+    /**
+     * @param key k-mer
+     * @return slot the key hashes to (capacity must be non-zero)
+     */
+    size_t home(std::string_view key) const { return std::hash<std::string_view>{}(key) & (mSlots.size() - 1); }
+
+    /**
+     * Probe for a key
+     * @param key k-mer
+     * @return the key's slot, or the empty slot where it would go (capacity must be non-zero)
+     */
+    size_t probe(std::string_view key) const {
+        size_t mask = mSlots.size() - 1;
+        size_t slot = home(key);
+        while(mUsed[slot] && mSlots[slot].first != key){
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    /**
+     * Double the capacity (keeping the load factor under 7/8) and re-place every entry
+     */
+    void grow(){
+        vector<value_type> old_slots = std::move(mSlots);
+        vector<uint8_t> old_used = std::move(mUsed);
+        mSlots = vector<value_type>(old_slots.empty() ? INITIAL_CAPACITY : old_slots.size() * 2);
+        mUsed.assign(mSlots.size(), 0);
+        for(size_t i = 0; i < old_slots.size(); ++i){
+            if(old_used[i]){
+                size_t slot = probe(old_slots[i].first);
+                mSlots[slot] = std::move(old_slots[i]);
+                mUsed[slot] = 1;
+            }
+        }
+    }
+
+    /**
+     * Iterator over the used slots, in table order
+     * @tparam IS_CONST true for const_iterator
+     */
+    template <bool IS_CONST>
+    class basic_iterator {
+        friend class FlatHashVertexStore;
+        using store_t = typename std::conditional<IS_CONST, const FlatHashVertexStore, FlatHashVertexStore>::type;
+
+        store_t * mStore = nullptr;
+        size_t mSlot = 0;
+
+        /// Step over unused slots
+        void settle(){
+            while(mSlot < mStore->mSlots.size() && !mStore->mUsed[mSlot]){
+                ++mSlot;
+            }
+        }
+
+        basic_iterator(store_t * store, size_t slot) : mStore(store), mSlot(slot) { settle(); }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashVertexStore::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = typename std::conditional<IS_CONST, const value_type &, value_type &>::type;
+        using pointer = typename std::conditional<IS_CONST, const value_type *, value_type *>::type;
+
+        basic_iterator()=default;
+        /// Allow iterator -> const_iterator
+        template <bool OTHER_CONST, typename = typename std::enable_if<IS_CONST && !OTHER_CONST>::type>
+        basic_iterator(const basic_iterator<OTHER_CONST> & other) : mStore(other.mStore), mSlot(other.mSlot) { }
+
+        reference operator*() const { return mStore->mSlots[mSlot]; }
+        pointer operator->() const { return &mStore->mSlots[mSlot]; }
+        basic_iterator & operator++(){ ++mSlot; settle(); return *this; }
+        basic_iterator operator++(int){ basic_iterator old = *this; ++(*this); return old; }
+        bool operator==(const basic_iterator & other) const { return mSlot == other.mSlot; }
+        bool operator!=(const basic_iterator & other) const { return !(*this == other); }
+
+        template <bool> friend class basic_iterator;
+    };
+
+public:
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    FlatHashVertexStore()=default;
+    ~FlatHashVertexStore()=default;
+
+    /**
+     * Copy the vertices of another store
+     * @param begin first (k-mer, value) pair
+     * @param end one past the last pair
+     */
+    template <typename Iterator>
+    FlatHashVertexStore(Iterator begin, Iterator end){
+        for(; begin != end; ++begin){
+            (*this)[begin->first] = begin->second;
+        }
+    }
+
+    /**
+     * Access a vertex, inserting an empty one if needed.
+     * Inserting can move every entry, so do not hold a reference across an insertion.
+     * @param key k-mer
+     * @return the vertex value
+     */
+    DBGraphValue & operator[](const string & key){
+        if((mSize + 1) * 8 > mSlots.size() * 7){
+            grow();
+        }
+        size_t slot = probe(key);
+        if(!mUsed[slot]){
+            mSlots[slot].first = key;
+            mUsed[slot] = 1;
+            mSize++;
+        }
+        return mSlots[slot].second;
+    }
+
+    /**
+     * @param key k-mer
+     * @return 1 if the vertex is in the store, 0 if not
+     */
+    size_t count(const string & key) const { return !mSlots.empty() && mUsed[probe(key)]; }
+
+    /**
+     * Remove a vertex, shifting later entries of its probe run back so no tombstones are needed
+     * @param key k-mer
+     * @return number of vertices removed
+     */
+    size_t erase(const string & key){
+        if(mSlots.empty()){
+            return 0;
+        }
+        size_t mask = mSlots.size() - 1;
+        size_t hole = probe(key);
+        if(!mUsed[hole]){
+            return 0;
+        }
+        for(size_t next = (hole + 1) & mask; mUsed[next]; next = (next + 1) & mask){
+            // an entry can fill the hole unless its home lies cyclically in (hole, next]
+            if(((next - home(mSlots[next].first)) & mask) >= ((next - hole) & mask)){
+                mSlots[hole] = std::move(mSlots[next]);
+                hole = next;
+            }
+        }
+        mSlots[hole] = value_type();
+        mUsed[hole] = 0;
+        mSize--;
+        return 1;
+    }
+
+    /**
+     * Find a vertex without inserting it
+     * @param key k-mer
+     * @return iterator to the vertex, or end()
+     */
+    iterator find(const string & key){
+        if(mSlots.empty()){
+            return end();
+        }
+        size_t slot = probe(key);
+        return mUsed[slot] ? iterator(this, slot) : end();
+    }
+    const_iterator find(const string & key) const {
+        if(mSlots.empty()){
+            return end();
+        }
+        size_t slot = probe(key);
+        return mUsed[slot] ? const_iterator(this, slot) : end();
+    }
+
+    /**
+     * Find a vertex without inserting it or copying the key
+     * @param key k-mer
+     * @return the vertex value, or nullptr if absent
+     */
+    const DBGraphValue * lookup(std::string_view key) const {
+        if(mSlots.empty()){
+            return nullptr;
+        }
+        size_t slot = probe(key);
+        return mUsed[slot] ? &mSlots[slot].second : nullptr;
+    }
+
+    iterator begin(){ return iterator(this, 0); }
+    iterator end(){ return iterator(this, mSlots.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, mSlots.size()); }
+
+    /**
+     * @return number of vertices in the store
+     */
+    size_t size() const { return mSize; }
+
+    /**
+     * @return true if the store has no vertices
+     */
+    bool empty() const { return mSize == 0; }
+
+    /**
+     * Remove all vertices
+     */
+    void clear(){
+        mSlots.clear();
+        mUsed.clear();
+        mSize = 0;
+    }
+
+    /**
+     * Estimate the bytes spent on empty slots and slot flags (not on the stored keys and values)
+     * @return bytes
+     */
+    size_t overhead_bytes() const { return (mSlots.size() - mSize) * sizeof(value_type) + mUsed.size(); }
+
+    /**
+     * @return number of separate heap allocations the store makes (the slot array and the flags)
+     */
+    size_t allocation_count() const { return mSlots.empty() ? 0 : 2; }
+};
+
+class PackedKeyVertexStore {
+public:
+    using value_type = std::pair<string, DBGraphValue>;
+
+    static constexpr bool ORDERED = false;
+    static constexpr bool READ_ONLY = false;
+
+    /// Longest k-mer that fits in a packed key (one byte per character)
+    static constexpr size_t MAX_KMER_LENGTH = 8;
+
+private:
+
+    /// Packed k-mers, parallel to mValues; removal swaps the last entry into the gap
+    vector<uint64_t> mKeys;
+    vector<DBGraphValue> mValues;
+
+    /// Hash table of positions in mKeys (stored as position + 1, so 0 marks an empty slot)
+    vector<uint32_t> mIndex;
+
+    /**
+     * Pack a k-mer into one word, one byte per character
+     * @param key k-mer
+     * @param packed set to the packed key
+     * @return false if the key is too long (or contains '\0') to be packed
+     */
+    static bool pack(std::string_view key, uint64_t & packed){
+        if(key.size() > MAX_KMER_LENGTH || key.find('\0') != std::string_view::npos){
+            return false;
+        }
+        packed = 0;
+        for(size_t i = 0; i < key.size(); ++i){
+            packed |= uint64_t(uint8_t(key[i])) << (8 * i);
+        }
+        return true;
+    }
+
+    /**
+     * @param packed key
+     * @return the k-mer it stands for
+     */
+    static string unpack(uint64_t packed){
+        string key;
+        for(; packed != 0; packed >>= 8){
+            key += char(packed & 0xff);
+        }
+        return key;
+    }
+
+    /**
+     * @param packed key
+     * @return slot the key hashes to (capacity must be non-zero)
+     */
+    size_t home(uint64_t packed) const {
+        packed ^= packed >> 33;
+        packed *= 0xff51afd7ed558ccdULL;
+        packed ^= packed >> 33;
+        return packed & (mIndex.size() - 1);
+    }
+
+    /**
+     * Probe for a key
+     * @param packed key
+     * @return the key's slot, or the empty slot where it would go (capacity must be non-zero)
+     */
+    size_t probe(uint64_t packed) const {
+        size_t mask = mIndex.size() - 1;
+        size_t slot = home(packed);
+        while(mIndex[slot] != 0 && mKeys[mIndex[slot] - 1] != packed){
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    /**
+     * Double the index (keeping the load factor under 3/4) and re-place every key
+     */
+    void grow(){
+        mIndex.assign(mIndex.empty() ? 16 : mIndex.size() * 2, 0);
+        for(size_t i = 0; i < mKeys.size(); ++i){
+            mIndex[probe(mKeys[i])] = i + 1;
+        }
+    }
+
+    /**
+     * Position of a key in the dense arrays
+     * @param key k-mer
+     * @return position, or size() if absent
+     */
+    size_t position(std::string_view key) const {
+        uint64_t packed;
+        if(mIndex.empty() || !pack(key, packed)){
+            return mKeys.size();
+        }
+        uint32_t entry = mIndex[probe(packed)];
+        return entry == 0 ? mKeys.size() : entry - 1;
+    }
+
+    /**
+     * Iterator over the dense arrays. Dereferencing builds a (k-mer, value reference) pair.
+     * @tparam IS_CONST true for const_iterator
+     */
+    template <bool IS_CONST>
+    class basic_iterator {
+        friend class PackedKeyVertexStore;
+        using store_t = typename std::conditional<IS_CONST, const PackedKeyVertexStore, PackedKeyVertexStore>::type;
+        using value_ref_t = typename std::conditional<IS_CONST, const DBGraphValue &, DBGraphValue &>::type;
+
+        store_t * mStore = nullptr;
+        size_t mPosition = 0;
+
+        basic_iterator(store_t * store, size_t position) : mStore(store), mPosition(position) { }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PackedKeyVertexStore::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const string, value_ref_t>;
+
+        /// Lets it->second work even though there is no pair in memory to point at
+        struct pointer {
+            reference mPair;
+            const reference * operator->() const { return &mPair; }
+        };
+
+        basic_iterator()=default;
+        /// Allow iterator -> const_iterator
+        template <bool OTHER_CONST, typename = typename std::enable_if<IS_CONST && !OTHER_CONST>::type>
+        basic_iterator(const basic_iterator<OTHER_CONST> & other) : mStore(other.mStore), mPosition(other.mPosition) { }
+
+        reference operator*() const { return reference(unpack(mStore->mKeys[mPosition]), mStore->mValues[mPosition]); }
+        pointer operator->() const { return pointer{**this}; }
+        basic_iterator & operator++(){ ++mPosition; return *this; }
+        basic_iterator operator++(int){ basic_iterator old = *this; ++(*this); return old; }
+        bool operator==(const basic_iterator & other) const { return mPosition == other.mPosition; }
+        bool operator!=(const basic_iterator & other) const { return !(*this == other); }
+
+        template <bool> friend class basic_iterator;
+    };
+
+public:
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    PackedKeyVertexStore()=default;
+    ~PackedKeyVertexStore()=default;
+
+    /**
+     * Copy the vertices of another store
+     * @param begin first (k-mer, value) pair
+     * @param end one past the last pair
+     */
+    template <typename Iterator>
+    PackedKeyVertexStore(Iterator begin, Iterator end){
+        for(; begin != end; ++begin){
+            (*this)[begin->first] = begin->second;
+        }
+    }
+
+    /**
+     * Access a vertex, inserting an empty one if needed.
+     * Inserting can move every value, so do not hold a reference across an insertion.
+     * @param key k-mer (at most MAX_KMER_LENGTH characters)
+     * @return the vertex value
+     */
+    DBGraphValue & operator[](const string & key){
+        uint64_t packed;
+        if(!pack(key, packed)){
+            throw std::length_error("PackedKeyVertexStore: k-mers longer than 8 characters cannot be packed");
+        }
+        if((mKeys.size() + 1) * 4 > mIndex.size() * 3){
+            grow();
+        }
+        size_t slot = probe(packed);
+        if(mIndex[slot] == 0){
+            mKeys.push_back(packed);
+            mValues.emplace_back();
+            mIndex[slot] = mKeys.size();
+        }
+        return mValues[mIndex[slot] - 1];
+    }
+
+    /**
+     * @param key k-mer
+     * @return 1 if the vertex is in the store, 0 if not
+     */
+    size_t count(const string & key) const { return position(key) < mKeys.size(); }
+
+    /**
+     * Remove a vertex; the last vertex is moved into its place in the dense arrays
+     * @param key k-mer
+     * @return number of vertices removed
+     */
+    size_t erase(const string & key){
+        uint64_t packed;
+        if(mIndex.empty() || !pack(key, packed)){
+            return 0;
+        }
+        size_t mask = mIndex.size() - 1;
+        size_t hole = probe(packed);
+        if(mIndex[hole] == 0){
+            return 0;
+        }
+        size_t removed = mIndex[hole] - 1;
+        for(size_t next = (hole + 1) & mask; mIndex[next] != 0; next = (next + 1) & mask){
+            if(((next - home(mKeys[mIndex[next] - 1])) & mask) >= ((next - hole) & mask)){
+                mIndex[hole] = mIndex[next];
+                hole = next;
+            }
+        }
+        mIndex[hole] = 0;
+
+        size_t last = mKeys.size() - 1;
+        if(removed != last){
+            mIndex[probe(mKeys[last])] = removed + 1;
+            mKeys[removed] = mKeys[last];
+            mValues[removed] = std::move(mValues[last]);
+        }
+        mKeys.pop_back();
+        mValues.pop_back();
+        return 1;
+    }
+
+    /**
+     * Find a vertex without inserting it
+     * @param key k-mer
+     * @return iterator to the vertex, or end()
+     */
+    iterator find(const string & key){ return iterator(this, position(key)); }
+    const_iterator find(const string & key) const { return const_iterator(this, position(key)); }
+
+    /**
+     * Find a vertex without inserting it or unpacking its key (which find's iterator does)
+     * @param key k-mer
+     * @return the vertex value, or nullptr if absent
+     */
+    const DBGraphValue * lookup(std::string_view key) const {
+        size_t i = position(key);
+        return i < mKeys.size() ? &mValues[i] : nullptr;
+    }
+
+    iterator begin(){ return iterator(this, 0); }
+    iterator end(){ return iterator(this, mKeys.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, mKeys.size()); }
+
+    /**
+     * @return number of vertices in the store
+     */
+    size_t size() const { return mKeys.size(); }
+
+    /**
+     * @return true if the store has no vertices
+     */
+    bool empty() const { return mKeys.empty(); }
+
+    /**
+     * Remove all vertices
+     */
+    void clear(){
+        mKeys.clear();
+        mValues.clear();
+        mIndex.clear();
+    }
+
+    /**
+     * Estimate the bytes spent on the index table and the packed keys
+     * @return bytes
+     */
+    size_t overhead_bytes() const { return mIndex.size() * sizeof(uint32_t) + mKeys.size() * sizeof(uint64_t); }
+
+    /**
+     * @return number of separate heap allocations the store makes (keys, values and index)
+     */
+    size_t allocation_count() const { return mIndex.empty() ? 0 : 3; }
+};
+
+class FrozenVertexStore {
+public:
+    using value_type = std::pair<string, DBGraphValue>;
+    using iterator = vector<value_type>::iterator;
+    using const_iterator = vector<value_type>::const_iterator;
+
+    static constexpr bool ORDERED = true;
+    static constexpr bool READ_ONLY = true;
+    static constexpr size_t MAX_KMER_LENGTH = SIZE_MAX;
+
+private:
+
+    /// Every vertex, sorted by k-mer
+    vector<value_type> mEntries;
+
+    /**
+     * @param key k-mer
+     * @return position of the first entry not less than key
+     */
+    size_t lower_bound(std::string_view key) const {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), key,
+            [] (const value_type & entry, std::string_view k) { return entry.first < k; }) - mEntries.begin();
+    }
+
+    /**
+     * @param key k-mer
+     * @return position of key, or size() if absent
+     */
+    size_t position(std::string_view key) const {
+        size_t i = lower_bound(key);
+        return i < mEntries.size() && mEntries[i].first == key ? i : mEntries.size();
+    }
+
+public:
+    FrozenVertexStore()=default;
+    ~FrozenVertexStore()=default;
+
+    /**
+     * Freeze the vertices of another store
+     * @param begin first (k-mer, value) pair
+     * @param end one past the last pair
+     */
+    template <typename Iterator>
+    FrozenVertexStore(Iterator begin, Iterator end){
+        for(; begin != end; ++begin){
+            mEntries.emplace_back(begin->first, begin->second);
+        }
+        std::sort(mEntries.begin(), mEntries.end(),
+            [] (const value_type & a, const value_type & b) { return a.first < b.first; });
+        mEntries.shrink_to_fit();
+    }
+
+    /**
+     * Access an existing vertex. Values can still be written (traversals keep visit flags in them),
+     * but the set of vertices is fixed.
+     * @param key k-mer
+     * @return the vertex value
+     */
+    DBGraphValue & operator[](const string & key){
+        size_t i = position(key);
+        if(i == mEntries.size()){
+            throw std::logic_error("FrozenVertexStore: cannot insert vertex " + key + " into a frozen graph");
+        }
+        return mEntries[i].second;
+    }
+
+    /**
+     * @param key k-mer
+     * @return 1 if the vertex is in the store, 0 if not
+     */
+    size_t count(const string & key) const { return position(key) < mEntries.size(); }
+
+    /**
+     * Frozen stores cannot lose vertices
+     */
+    size_t erase(const string & key){
+        throw std::logic_error("FrozenVertexStore: cannot erase vertex " + key + " from a frozen graph");
+    }
+
+    /**
+     * Find a vertex
+     * @param key k-mer
+     * @return iterator to the vertex, or end()
+     */
+    iterator find(const string & key){ return mEntries.begin() + position(key); }
+    const_iterator find(const string & key) const { return mEntries.begin() + position(key); }
+
+    /**
+     * Find a vertex without copying the key
+     * @param key k-mer
+     * @return the vertex value, or nullptr if absent
+     */
+    const DBGraphValue * lookup(std::string_view key) const {
+        size_t i = position(key);
+        return i < mEntries.size() ? &mEntries[i].second : nullptr;
+    }
+
+    iterator begin(){ return mEntries.begin(); }
+    iterator end(){ return mEntries.end(); }
+    const_iterator begin() const { return mEntries.begin(); }
+    const_iterator end() const { return mEntries.end(); }
+
+    /**
+     * @return number of vertices in the store
+     */
+    size_t size() const { return mEntries.size(); }
+
+    /**
+     * @return true if the store has no vertices
+     */
+    bool empty() const { return mEntries.empty(); }
+
+    /**
+     * Frozen stores cannot be cleared
+     */
+    void clear(){
+        throw std::logic_error("FrozenVertexStore: cannot clear a frozen graph");
+    }
+
+    /**
+     * @return bytes spent beyond the keys and values themselves (none)
+     */
+    size_t overhead_bytes() const { return 0; }
+
+    /**
+     * @return number of separate heap allocations the store makes (the entry array)
+     */
+    size_t allocation_count() const { return mEntries.empty() ? 0 : 1; }
+};
+
+#endif //PANGENOMES_FOR_EVOLUTIONARY_COMPUTATION_VERTEXSTORE_H
@@ -15,6 +15,7 @@
 #include <string>
 #include "../../../mabe/MABE2/source/third-party/empirical/third-party/Catch/single_include/catch2/catch.hpp"
 #include "../../../mabe/MABE2/source/third-party/empirical/include/emp/data/DataFile.hpp"
+#include "../../../mabe/MABE2/source/third-party/empirical/include/emp/math/Random.hpp"
 
 using std::unique; using std::string;
 
@@ -719,4 +720,4 @@ int main() {
     // TestCSVHelperFunctions();
     // TestMABE();
 
-}
\ No newline at end of file
+}
\ No newline at end of file